@@ -72,6 +72,35 @@ class FaceMeshStreamProcessor {
     }
   }
 
+  /// Processes YUV 4:2:0 frames (e.g. Android `YUV_420_888`) coming from a
+  /// stream.
+  ///
+  /// The behaviour mirrors [FaceMeshProcessor.processYuv]. Provide at most one
+  /// of [roi] or [boxResolver].
+  Stream<FaceMeshResult> processYuv(
+    Stream<FaceMeshYuvImage> frames, {
+    NormalizedRect? roi,
+    FaceMeshBoxResolver<FaceMeshYuvImage>? boxResolver,
+    double boxScale = _boxScale,
+    bool boxMakeSquare = true,
+    int rotationDegrees = 0,
+    bool mirrorHorizontal = false,
+  }) async* {
+    _validateResolvers<FaceMeshYuvImage>(roi, boxResolver);
+    await for (final FaceMeshYuvImage frame in frames) {
+      final FaceMeshBox? dynamicBox = boxResolver?.call(frame);
+      yield _processor.processYuv(
+        frame,
+        roi: roi,
+        box: dynamicBox,
+        boxScale: boxScale,
+        boxMakeSquare: boxMakeSquare,
+        rotationDegrees: rotationDegrees,
+        mirrorHorizontal: mirrorHorizontal,
+      );
+    }
+  }
+
   void _validateResolvers<T>(
     NormalizedRect? roi,
     FaceMeshBoxResolver<T>? boxResolver,
@@ -1,5 +1,6 @@
+import 'dart:async';
 import 'dart:ffi' as ffi;
-import 'dart:io';
+import 'dart:typed_data';
 
 import 'package:ffi/ffi.dart' as pkg_ffi;
 import 'package:flutter/services.dart';
@@ -31,6 +32,9 @@ class FaceMeshPixelFormat {
 
   /// BGRA ordering for buffers that come directly from some platforms.
   static const int bgra = 1;
+
+  /// Packed 3-byte RGB; accepted by [FaceMeshProcessor.processCrop] only.
+  static const int rgb = 2;
 }
 
 /// Delegate types supported by the native runtime.
@@ -45,6 +49,62 @@ enum FaceMeshDelegate {
   gpuV2,
 }
 
+/// Filters used to sample the face crop fed to the model.
+enum FaceMeshInterpolation {
+  /// Bilinear taps; ROIs far larger than the model input are box-reduced
+  /// first.
+  bilinear,
+
+  /// One source pixel per model input pixel. Fastest, with visible aliasing
+  /// once the ROI is much larger or smaller than the model input.
+  nearest,
+
+  /// Box-averages ROIs larger than twice the model input before sampling.
+  area,
+
+  /// Picks one of the above per frame from the ROI size.
+  auto,
+}
+
+/// Vector kernel sets the native preprocessing can run with.
+///
+/// There are no ARMv8.2 dot-product/fp16 or AVX-512 kernels, and landmark
+/// postprocessing is scalar under every setting.
+enum FaceMeshKernelIsa {
+  /// Best set the CPU supports.
+  auto,
+
+  /// The ABI's baseline kernels (SSE2 on x86, NEON on ARM).
+  baseline,
+
+  /// AVX2 kernels; creation fails on CPUs without AVX2 and F16C.
+  avx2,
+}
+
+/// Frame layouts [FaceMeshProcessor.warmUp] can drive.
+enum FaceMeshWarmUpFormat {
+  /// Packed RGBA, as [FaceMeshProcessor.process] takes.
+  rgba,
+
+  /// Packed BGRA, as iOS camera frames arrive.
+  bgra,
+
+  /// Y plane plus interleaved VU, as Android camera frames usually arrive.
+  nv21,
+
+  /// Y plane plus separate U and V planes.
+  i420,
+}
+
+/// Layouts [FaceMeshProcessor.lastCrop] can return the face crop in.
+enum FaceMeshCropFormat {
+  /// Packed 3-byte RGB.
+  rgb,
+
+  /// The model's float input, NHWC and normalized to [-1, 1].
+  float,
+}
+
 /// Immutable normalized rectangle that MediaPipe uses as ROI input.
 class NormalizedRect {
   /// Builds a normalized rectangle from center, size, and rotation.
@@ -89,7 +149,8 @@ class NormalizedRect {
 /// Pixel-space bounding box used to derive a normalized ROI.
 ///
 /// You can use this helper when providing bounding regions to
-/// [FaceMeshProcessor.process] or [FaceMeshProcessor.processNv21].
+/// [FaceMeshProcessor.process], [FaceMeshProcessor.processNv21] or
+/// [FaceMeshProcessor.processYuv].
 class FaceMeshBox {
   /// Creates a pixel bounding box from explicit edges.
   const FaceMeshBox({
@@ -141,16 +202,19 @@ class FaceMeshBox {
       'FaceMeshBox(left: $left, top: $top, right: $right, bottom: $bottom)';
 }
 
-/// Container that holds RGBA/BGRA pixels used as inference input.
+/// Container that holds RGBA/BGRA (or RGB crop) pixels used as inference
+/// input.
 class FaceMeshImage {
-  /// Creates an RGBA/BGRA image wrapper from raw bytes.
+  /// Creates an RGBA/BGRA/RGB image wrapper from raw bytes.
   FaceMeshImage({
     required this.pixels,
     required this.width,
     required this.height,
     this.pixelFormat = FaceMeshPixelFormat.rgba,
     int? bytesPerRow,
-  }) : bytesPerRow = bytesPerRow ?? width * 4 {
+  }) : bytesPerRow =
+           bytesPerRow ??
+           width * (pixelFormat == FaceMeshPixelFormat.rgb ? 3 : 4) {
     final int requiredBytes = this.bytesPerRow * height;
     if (pixels.length < requiredBytes) {
       throw ArgumentError(
@@ -158,7 +222,8 @@ class FaceMeshImage {
       );
     }
     if (pixelFormat != FaceMeshPixelFormat.rgba &&
-        pixelFormat != FaceMeshPixelFormat.bgra) {
+        pixelFormat != FaceMeshPixelFormat.bgra &&
+        pixelFormat != FaceMeshPixelFormat.rgb) {
       throw ArgumentError('Unsupported pixel format: $pixelFormat');
     }
   }
@@ -239,6 +304,83 @@ class FaceMeshNv21Image {
       'yPlaneLength: ${yPlane.length}, vuPlaneLength: ${vuPlane.length})';
 }
 
+/// Holder for YUV 4:2:0 buffers with separate Y, U and V planes.
+///
+/// Covers Android `YUV_420_888` camera images (pass the three plane buffers
+/// with their row and pixel strides unchanged) as well as I420/YV12
+/// (pixel stride 1) and NV12/NV21 (pixel stride 2).
+class FaceMeshYuvImage {
+  /// Creates a YUV image from its three planes.
+  ///
+  /// Chroma sample `(x ~/ 2, y ~/ 2)` is read at
+  /// `(y ~/ 2) * uvBytesPerRow + (x ~/ 2) * uvPixelStride` in both [uPlane]
+  /// and [vPlane]. With a pixel stride of 2, planes that are views one byte
+  /// apart into the same buffer are passed on as one interleaved plane, which
+  /// the NV21 order (V first) converts fastest.
+  FaceMeshYuvImage({
+    required this.yPlane,
+    required this.uPlane,
+    required this.vPlane,
+    required this.width,
+    required this.height,
+    int? yBytesPerRow,
+    int? uvBytesPerRow,
+    this.uvPixelStride = 1,
+  }) : yBytesPerRow = yBytesPerRow ?? width,
+       uvBytesPerRow = uvBytesPerRow ?? ((width + 1) ~/ 2) * uvPixelStride {
+    if (width <= 0 || height <= 0) {
+      throw ArgumentError('Invalid image size: ${width}x$height');
+    }
+    if (uvPixelStride <= 0) {
+      throw ArgumentError('uvPixelStride must be positive.');
+    }
+    // Plane buffers may end right after their last sample (YUV_420_888).
+    final int requiredY = this.yBytesPerRow * (height - 1) + width;
+    final int requiredUv =
+        this.uvBytesPerRow * ((height + 1) ~/ 2 - 1) +
+        ((width + 1) ~/ 2 - 1) * uvPixelStride +
+        1;
+    if (yPlane.length < requiredY) {
+      throw ArgumentError('Y plane buffer too small (need $requiredY bytes).');
+    }
+    if (uPlane.length < requiredUv || vPlane.length < requiredUv) {
+      throw ArgumentError(
+        'U/V plane buffer too small (need $requiredUv bytes).',
+      );
+    }
+  }
+
+  /// Luma plane (full resolution).
+  final Uint8List yPlane;
+
+  /// Cb chroma plane.
+  final Uint8List uPlane;
+
+  /// Cr chroma plane.
+  final Uint8List vPlane;
+
+  /// Frame width in pixels.
+  final int width;
+
+  /// Frame height in pixels.
+  final int height;
+
+  /// Row stride for the Y plane.
+  final int yBytesPerRow;
+
+  /// Row stride shared by the U and V planes.
+  final int uvBytesPerRow;
+
+  /// Distance in bytes between consecutive chroma samples of one plane.
+  final int uvPixelStride;
+
+  @override
+  String toString() =>
+      'FaceMeshYuvImage(width: $width, height: $height, '
+      'yBytesPerRow: $yBytesPerRow, uvBytesPerRow: $uvBytesPerRow, '
+      'uvPixelStride: $uvPixelStride)';
+}
+
 /// A single 3D landmark returned by MediaPipe.
 class FaceMeshLandmark {
   /// Builds a landmark from normalized coordinates returned by MediaPipe.
@@ -309,6 +451,47 @@ class FaceMeshResult {
       '$imageWidth, imageHeight: $imageHeight)';
 }
 
+/// Aligned face crop the model last ran on.
+class FaceMeshCrop {
+  /// Creates a crop from its pixels or tensor values and transform.
+  FaceMeshCrop({
+    required this.width,
+    required this.height,
+    required this.transform,
+    required this.imageWidth,
+    required this.imageHeight,
+    this.pixels,
+    this.tensor,
+  });
+
+  /// Crop width (the model input width).
+  final int width;
+
+  /// Crop height (the model input height).
+  final int height;
+
+  /// RGB bytes, `width * 3` per row, for [FaceMeshCropFormat.rgb].
+  final Uint8List? pixels;
+
+  /// NHWC float values in [-1, 1] for [FaceMeshCropFormat.float].
+  final Float32List? tensor;
+
+  /// Affine map `[a, b, c, d, e, f]` from crop pixel `(x, y)` to image pixel
+  /// `(a * x + b * y + c, d * x + e * y + f)`.
+  final List<double> transform;
+
+  /// Width of the logical image the transform maps into.
+  final int imageWidth;
+
+  /// Height of the logical image the transform maps into.
+  final int imageHeight;
+
+  @override
+  String toString() =>
+      'FaceMeshCrop(width: $width, height: $height, transform: $transform, '
+      'imageWidth: $imageWidth, imageHeight: $imageHeight)';
+}
+
 /// Base exception thrown by this plugin when native calls fail.
 class MediapipeFaceMeshException implements Exception {
   /// Creates an exception with a human-readable [message].
@@ -321,6 +504,98 @@ class MediapipeFaceMeshException implements Exception {
   String toString() => 'MediapipeFaceMeshException($message)';
 }
 
+/// Converts a whole NV21 frame to RGBA for display.
+///
+/// Same as [convertYuvToRgba] for the Y and interleaved VU planes of [image].
+FaceMeshImage convertNv21ToRgba(
+  FaceMeshNv21Image image, {
+  int rotationDegrees = 0,
+  bool mirrorHorizontal = false,
+  int downscale = 1,
+}) {
+  return convertYuvToRgba(
+    FaceMeshYuvImage(
+      yPlane: image.yPlane,
+      uPlane: Uint8List.sublistView(image.vuPlane, 1),
+      vPlane: image.vuPlane,
+      width: image.width,
+      height: image.height,
+      yBytesPerRow: image.yBytesPerRow,
+      uvBytesPerRow: image.vuBytesPerRow,
+      uvPixelStride: 2,
+    ),
+    rotationDegrees: rotationDegrees,
+    mirrorHorizontal: mirrorHorizontal,
+    downscale: downscale,
+  );
+}
+
+/// Converts a whole YUV 4:2:0 frame (NV21, NV12, I420, `YUV_420_888`) to
+/// RGBA for display.
+///
+/// The frame is box-downscaled by [downscale] (1, 2, 4, 8 or 16, rounding
+/// the size up) and then rotated/mirrored the same way
+/// [FaceMeshProcessor.processYuv] orients it, so landmarks returned for the
+/// same [rotationDegrees] and [mirrorHorizontal] line up with the result.
+FaceMeshImage convertYuvToRgba(
+  FaceMeshYuvImage image, {
+  int rotationDegrees = 0,
+  bool mirrorHorizontal = false,
+  int downscale = 1,
+}) {
+  if (rotationDegrees != 0 &&
+      rotationDegrees != 90 &&
+      rotationDegrees != 180 &&
+      rotationDegrees != 270) {
+    throw ArgumentError('rotationDegrees must be one of 0, 90, 180, 270.');
+  }
+  if (downscale != 1 &&
+      downscale != 2 &&
+      downscale != 4 &&
+      downscale != 8 &&
+      downscale != 16) {
+    throw ArgumentError('downscale must be one of 1, 2, 4, 8, 16.');
+  }
+  final int scaledWidth = (image.width + downscale - 1) ~/ downscale;
+  final int scaledHeight = (image.height + downscale - 1) ~/ downscale;
+  final bool transposed = rotationDegrees == 90 || rotationDegrees == 270;
+  final int width = transposed ? scaledHeight : scaledWidth;
+  final int height = transposed ? scaledWidth : scaledHeight;
+  final int bytesPerRow = width * 4;
+  final int byteCount = bytesPerRow * height;
+  final _NativeYuvImage nativeImage = _toNativeYuvImage(image);
+  final ffi.Pointer<ffi.Uint8> pixelPtr = pkg_ffi.calloc<ffi.Uint8>(byteCount);
+  try {
+    final int ok = faceBindings.mp_convert_yuv_to_rgba(
+      nativeImage.image,
+      rotationDegrees,
+      mirrorHorizontal ? 1 : 0,
+      downscale,
+      pixelPtr,
+      bytesPerRow,
+      height,
+    );
+    if (ok == 0) {
+      throw MediapipeFaceMeshException(
+        _readCString(faceBindings.mp_face_mesh_last_global_error()) ??
+            'Failed to convert YUV image.',
+      );
+    }
+    return FaceMeshImage(
+      pixels: Uint8List.fromList(pixelPtr.asTypedList(byteCount)),
+      width: width,
+      height: height,
+    );
+  } finally {
+    pkg_ffi.calloc.free(pixelPtr);
+    pkg_ffi.calloc.free(nativeImage.yPlane);
+    for (final ffi.Pointer<ffi.Uint8> plane in nativeImage.chromaPlanes) {
+      pkg_ffi.calloc.free(plane);
+    }
+    pkg_ffi.calloc.free(nativeImage.image);
+  }
+}
+
 /// High-level wrapper around the native MediaPipe Face Mesh graph.
 class FaceMeshProcessor {
   FaceMeshProcessor._(this._context) {
@@ -333,20 +608,50 @@ class FaceMeshProcessor {
   bool _closed = false;
 
   /// Creates the native interpreter and loads a model.
+  ///
+  /// Loading the runtime and model, building the delegate and allocating
+  /// tensors run on a native thread, so the calling isolate stays responsive.
+  /// Start it before the camera and await it once the first frame is due to
+  /// overlap both.
   static Future<FaceMeshProcessor> create({
     int threads = 2,
     double minDetectionConfidence = 0.5,
     double minTrackingConfidence = 0.5,
     bool enableSmoothing = true,
     bool enableRoiTracking = true,
+    bool enableFixedPointPreprocessing = false,
     FaceMeshDelegate delegate = FaceMeshDelegate.cpu,
+    FaceMeshInterpolation interpolation = FaceMeshInterpolation.bilinear,
+    FaceMeshKernelIsa kernelIsa = FaceMeshKernelIsa.auto,
+    String? xnnpackWeightCacheDirectory,
   }) async {
-    final String resolvedModelPath = await _materializeModel();
+    // The native side copies the model, so the asset bytes go straight
+    // through without a cache file.
+    final ByteData modelData = await rootBundle.load(_defaultModelAsset);
+    final int modelSize = modelData.lengthInBytes;
 
     final optionsPtr = pkg_ffi.calloc<MpFaceMeshCreateOptions>();
-    final ffi.Pointer<pkg_ffi.Utf8> modelPathPtr = resolvedModelPath
-        .toNativeUtf8();
+    final ffi.Pointer<ffi.Uint8> modelPtr = pkg_ffi.malloc<ffi.Uint8>(
+      modelSize,
+    );
+    final ffi.Pointer<pkg_ffi.Utf8> cacheDirPtr =
+        xnnpackWeightCacheDirectory == null
+        ? ffi.nullptr
+        : xnnpackWeightCacheDirectory.toNativeUtf8();
+    final Completer<void> finished = Completer<void>();
+    final ffi.NativeCallable<MpFaceMeshCreateCallbackFunction> onFinished =
+        ffi.NativeCallable<MpFaceMeshCreateCallbackFunction>.listener(
+          (ffi.Pointer<ffi.Void> _) => finished.complete(),
+        );
+    ffi.Pointer<MpFaceMeshCreateTask> task = ffi.nullptr;
     try {
+      modelPtr
+          .asTypedList(modelSize)
+          .setAll(
+            0,
+            modelData.buffer.asUint8List(modelData.offsetInBytes, modelSize),
+          );
+
       optionsPtr.ref
         ..threads = threads
         ..min_detection_confidence = minDetectionConfidence
@@ -354,21 +659,56 @@ class FaceMeshProcessor {
         ..delegate = delegate.index
         ..enable_smoothing = enableSmoothing ? 1 : 0
         ..enable_roi_tracking = enableRoiTracking ? 1 : 0
+        ..enable_fixed_point_preprocessing =
+            enableFixedPointPreprocessing ? 1 : 0
+        ..interpolation = interpolation.index
+        ..kernel_isa = kernelIsa.index
+        ..xnnpack_weight_cache_dir = cacheDirPtr.cast()
         ..tflite_library_path = ffi.nullptr;
 
-      final ffi.Pointer<MpFaceMeshContext> context = faceBindings
-          .mp_face_mesh_create(modelPathPtr.cast(), optionsPtr);
-      if (context == ffi.nullptr) {
-        throw MediapipeFaceMeshException(
-          _readCString(faceBindings.mp_face_mesh_last_global_error()) ??
-              'Failed to create face mesh context.',
-        );
-      }
-      return FaceMeshProcessor._(context);
+      // The model and options are copied before this returns.
+      task = faceBindings.mp_face_mesh_create_async(
+        modelPtr.cast(),
+        modelSize,
+        optionsPtr,
+        onFinished.nativeFunction,
+        ffi.nullptr,
+      );
     } finally {
       pkg_ffi.calloc.free(optionsPtr);
-      pkg_ffi.malloc.free(modelPathPtr);
+      pkg_ffi.malloc.free(modelPtr);
+      if (cacheDirPtr != ffi.nullptr) {
+        pkg_ffi.malloc.free(cacheDirPtr);
+      }
+      if (task == ffi.nullptr) {
+        onFinished.close();
+      }
+    }
+    if (task == ffi.nullptr) {
+      throw MediapipeFaceMeshException(
+        _readCString(faceBindings.mp_face_mesh_last_global_error()) ??
+            'Failed to create face mesh context.',
+      );
     }
+
+    try {
+      await finished.future;
+    } finally {
+      onFinished.close();
+    }
+    // Creation has finished, so this does not block.
+    final ffi.Pointer<MpFaceMeshContext> context = faceBindings
+        .mp_face_mesh_create_task_wait(task);
+    final String? error = context == ffi.nullptr
+        ? _readCString(faceBindings.mp_face_mesh_last_global_error())
+        : null;
+    faceBindings.mp_face_mesh_create_task_destroy(task);
+    if (context == ffi.nullptr) {
+      throw MediapipeFaceMeshException(
+        error ?? 'Failed to create face mesh context.',
+      );
+    }
+    return FaceMeshProcessor._(context);
   }
 
   /// Processes an image and returns face landmarks.
@@ -525,6 +865,83 @@ class FaceMeshProcessor {
     return processed;
   }
 
+  /// Processes YUV 4:2:0 frames given as separate planes.
+  ///
+  /// Parameters mirror the [process] method. Android `YUV_420_888` camera
+  /// images can be passed plane by plane without repacking them into NV21.
+  /// The planes are read in place by native code rather than copied.
+  FaceMeshResult processYuv(
+    FaceMeshYuvImage image, {
+    NormalizedRect? roi,
+    FaceMeshBox? box,
+    double boxScale = _boxScale,
+    bool boxMakeSquare = true,
+    int rotationDegrees = 0,
+    bool mirrorHorizontal = false,
+  }) {
+    _ensureNotClosed();
+    if (roi != null && box != null) {
+      throw ArgumentError('Provide either roi or box, not both.');
+    }
+    if (rotationDegrees != 0 &&
+        rotationDegrees != 90 &&
+        rotationDegrees != 180 &&
+        rotationDegrees != 270) {
+      throw ArgumentError('rotationDegrees must be one of {0, 90, 180, 270}.');
+    }
+    final int logicalWidth = (rotationDegrees == 90 || rotationDegrees == 270)
+        ? image.height
+        : image.width;
+    final int logicalHeight = (rotationDegrees == 90 || rotationDegrees == 270)
+        ? image.width
+        : image.height;
+    final NormalizedRect? effectiveRoi =
+        roi ??
+        (box != null
+            ? _normalizedRectFromBox(
+                box,
+                imageWidth: logicalWidth,
+                imageHeight: logicalHeight,
+                scale: boxScale,
+                makeSquare: boxMakeSquare,
+              )
+            : null);
+    final ffi.Pointer<MpYuvImage> layoutPtr = _toNativeYuvLayout(image);
+    final ffi.Pointer<MpNormalizedRect> roiPtr = effectiveRoi != null
+        ? _toNativeRect(effectiveRoi)
+        : ffi.nullptr;
+    FaceMeshResult? processed;
+    try {
+      // The planes are read in place: a leaf call may pass typed data
+      // addresses because the garbage collector cannot move them meanwhile.
+      final ffi.Pointer<MpFaceMeshResult> resultPtr = faceBindings
+          .mp_face_mesh_process_yuv_planes(
+            _context,
+            image.yPlane.address,
+            image.uPlane.address,
+            image.vPlane.address,
+            layoutPtr,
+            roiPtr == ffi.nullptr ? ffi.nullptr : roiPtr,
+            rotationDegrees,
+            mirrorHorizontal ? 1 : 0,
+          );
+      if (resultPtr == ffi.nullptr) {
+        throw MediapipeFaceMeshException(
+          _readCString(faceBindings.mp_face_mesh_last_error(_context)) ??
+              'Native face mesh error.',
+        );
+      }
+      processed = _copyResult(resultPtr.ref);
+      faceBindings.mp_face_mesh_release_result(resultPtr);
+    } finally {
+      pkg_ffi.calloc.free(layoutPtr);
+      if (roiPtr != ffi.nullptr) {
+        pkg_ffi.calloc.free(roiPtr);
+      }
+    }
+    return processed;
+  }
+
   FaceMeshResult _copyResult(MpFaceMeshResult nativeResult) {
     final ffi.Pointer<MpLandmark> landmarkPtr = nativeResult.landmarks;
     final List<FaceMeshLandmark> landmarks =
@@ -546,6 +963,198 @@ class FaceMeshProcessor {
     );
   }
 
+  /// Runs the model on a face crop that is already aligned, skipping ROI
+  /// sampling.
+  ///
+  /// [crop] must be exactly [inputWidth] x [inputHeight] pixels (RGBA, BGRA
+  /// or [FaceMeshPixelFormat.rgb]). [roi] is the rectangle the crop was cut
+  /// from, normalized to an [imageWidth] x [imageHeight] image; landmarks are
+  /// returned in that image's coordinates. ROI tracking is not used or
+  /// updated.
+  FaceMeshResult processCrop(
+    FaceMeshImage crop, {
+    required NormalizedRect roi,
+    required int imageWidth,
+    required int imageHeight,
+  }) {
+    _ensureNotClosed();
+    final _NativeImage nativeImage = _toNativeImage(crop);
+    final ffi.Pointer<MpNormalizedRect> roiPtr = _toNativeRect(roi);
+    try {
+      return _takeResult(
+        faceBindings.mp_face_mesh_process_crop(
+          _context,
+          nativeImage.image,
+          roiPtr,
+          imageWidth,
+          imageHeight,
+        ),
+      );
+    } finally {
+      pkg_ffi.calloc.free(nativeImage.pixels);
+      pkg_ffi.calloc.free(nativeImage.image);
+      pkg_ffi.calloc.free(roiPtr);
+    }
+  }
+
+  /// Runs the model on an already normalized input tensor.
+  ///
+  /// [tensor] holds [inputHeight] x [inputWidth] x 3 float values in NHWC
+  /// order, scaled to [-1, 1]. It is copied straight into the model input.
+  /// [roi], [imageWidth] and [imageHeight] map the landmarks back as in
+  /// [processCrop].
+  FaceMeshResult processTensor(
+    Float32List tensor, {
+    required NormalizedRect roi,
+    required int imageWidth,
+    required int imageHeight,
+  }) {
+    _ensureNotClosed();
+    final ffi.Pointer<ffi.Int32> sizePtr = pkg_ffi.calloc<ffi.Int32>(2);
+    final ffi.Pointer<MpNormalizedRect> roiPtr = _toNativeRect(roi);
+    try {
+      final ffi.Pointer<ffi.Float> input = faceBindings
+          .mp_face_mesh_input_tensor(_context, sizePtr, sizePtr + 1);
+      final int count = sizePtr[0] * sizePtr[1] * 3;
+      if (tensor.length != count) {
+        throw ArgumentError(
+          'Tensor must hold $count values (${sizePtr[0]}x${sizePtr[1]}x3).',
+        );
+      }
+      input.asTypedList(count).setAll(0, tensor);
+      return _takeResult(
+        faceBindings.mp_face_mesh_process_tensor(
+          _context,
+          input,
+          roiPtr,
+          imageWidth,
+          imageHeight,
+        ),
+      );
+    } finally {
+      pkg_ffi.calloc.free(sizePtr);
+      pkg_ffi.calloc.free(roiPtr);
+    }
+  }
+
+  /// Model input width in pixels; crops passed to [processCrop] must match.
+  int get inputWidth => _inputSize()[0];
+
+  /// Model input height in pixels; crops passed to [processCrop] must match.
+  int get inputHeight => _inputSize()[1];
+
+  List<int> _inputSize() {
+    _ensureNotClosed();
+    final ffi.Pointer<ffi.Int32> sizePtr = pkg_ffi.calloc<ffi.Int32>(2);
+    try {
+      faceBindings.mp_face_mesh_input_tensor(_context, sizePtr, sizePtr + 1);
+      return <int>[sizePtr[0], sizePtr[1]];
+    } finally {
+      pkg_ffi.calloc.free(sizePtr);
+    }
+  }
+
+  FaceMeshResult _takeResult(ffi.Pointer<MpFaceMeshResult> resultPtr) {
+    if (resultPtr == ffi.nullptr) {
+      throw MediapipeFaceMeshException(
+        _readCString(faceBindings.mp_face_mesh_last_error(_context)) ??
+            'Native face mesh error.',
+      );
+    }
+    try {
+      return _copyResult(resultPtr.ref);
+    } finally {
+      faceBindings.mp_face_mesh_release_result(resultPtr);
+    }
+  }
+
+  /// Returns a copy of the aligned face crop the last process call fed to
+  /// the model, so other models can run on the same face without cropping
+  /// the frame again.
+  ///
+  /// [FaceMeshCropFormat.rgb] fills [FaceMeshCrop.pixels];
+  /// [FaceMeshCropFormat.float] fills [FaceMeshCrop.tensor].
+  FaceMeshCrop lastCrop({FaceMeshCropFormat format = FaceMeshCropFormat.rgb}) {
+    _ensureNotClosed();
+    final ffi.Pointer<MpFaceCrop> cropPtr = pkg_ffi.calloc<MpFaceCrop>();
+    try {
+      final int ok = faceBindings.mp_face_mesh_last_crop(
+        _context,
+        format.index,
+        cropPtr,
+      );
+      if (ok == 0) {
+        throw MediapipeFaceMeshException(
+          _readCString(faceBindings.mp_face_mesh_last_error(_context)) ??
+              'No face crop available.',
+        );
+      }
+      final MpFaceCrop crop = cropPtr.ref;
+      final int count = crop.width * crop.height * 3;
+      return FaceMeshCrop(
+        width: crop.width,
+        height: crop.height,
+        transform: List<double>.generate(6, (int i) => crop.transform[i]),
+        imageWidth: crop.image_width,
+        imageHeight: crop.image_height,
+        pixels: format == FaceMeshCropFormat.rgb
+            ? Uint8List.fromList(crop.data.cast<ffi.Uint8>().asTypedList(count))
+            : null,
+        tensor: format == FaceMeshCropFormat.float
+            ? Float32List.fromList(
+                crop.data.cast<ffi.Float>().asTypedList(count),
+              )
+            : null,
+      );
+    } finally {
+      pkg_ffi.calloc.free(cropPtr);
+    }
+  }
+
+  /// Runs [iterations] full process calls on a synthetic [format] frame so
+  /// the first camera frame does not pay for lazy allocation and cold caches,
+  /// and returns each call's duration in milliseconds. Pass the layout the
+  /// camera delivers, since YUV frames have their own conversion buffers.
+  /// ROI tracking state is left untouched. Call it right after [create],
+  /// e.g. while the camera starts.
+  List<double> warmUp({
+    int iterations = 3,
+    FaceMeshWarmUpFormat format = FaceMeshWarmUpFormat.rgba,
+  }) {
+    _ensureNotClosed();
+    if (iterations <= 0) {
+      throw ArgumentError('iterations must be > 0.');
+    }
+    final ffi.Pointer<ffi.Float> timingsPtr = pkg_ffi.calloc<ffi.Float>(
+      iterations,
+    );
+    try {
+      final int completed = faceBindings.mp_face_mesh_warmup(
+        _context,
+        iterations,
+        format.index,
+        timingsPtr,
+      );
+      if (completed < iterations) {
+        throw MediapipeFaceMeshException(
+          _readCString(faceBindings.mp_face_mesh_last_error(_context)) ??
+              'Warm-up failed.',
+        );
+      }
+      return List<double>.of(timingsPtr.asTypedList(iterations));
+    } finally {
+      pkg_ffi.calloc.free(timingsPtr);
+    }
+  }
+
+  /// Kernel set the native preprocessing runs with: `avx2`, `sse2`, `neon`
+  /// or `scalar`.
+  String get kernelIsa {
+    _ensureNotClosed();
+    return _readCString(faceBindings.mp_face_mesh_kernel_isa(_context)) ??
+        'scalar';
+  }
+
   /// Releases the native context and associated resources.
   void close() {
     if (_closed) {
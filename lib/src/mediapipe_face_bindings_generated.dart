@@ -50,6 +50,108 @@ class MediapipeFaceBindings {
         )
       >();
 
+  ffi.Pointer<MpFaceMeshContext> mp_face_mesh_create_from_buffer(
+    ffi.Pointer<ffi.Void> model_data,
+    int model_size,
+    ffi.Pointer<MpFaceMeshCreateOptions> options,
+  ) {
+    return _mp_face_mesh_create_from_buffer(model_data, model_size, options);
+  }
+
+  late final _mp_face_mesh_create_from_bufferPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<MpFaceMeshContext> Function(
+            ffi.Pointer<ffi.Void>,
+            ffi.Size,
+            ffi.Pointer<MpFaceMeshCreateOptions>,
+          )
+        >
+      >('mp_face_mesh_create_from_buffer');
+  late final _mp_face_mesh_create_from_buffer =
+      _mp_face_mesh_create_from_bufferPtr
+          .asFunction<
+            ffi.Pointer<MpFaceMeshContext> Function(
+              ffi.Pointer<ffi.Void>,
+              int,
+              ffi.Pointer<MpFaceMeshCreateOptions>,
+            )
+          >();
+
+  ffi.Pointer<MpFaceMeshCreateTask> mp_face_mesh_create_async(
+    ffi.Pointer<ffi.Void> model_data,
+    int model_size,
+    ffi.Pointer<MpFaceMeshCreateOptions> options,
+    MpFaceMeshCreateCallback callback,
+    ffi.Pointer<ffi.Void> user_data,
+  ) {
+    return _mp_face_mesh_create_async(
+      model_data,
+      model_size,
+      options,
+      callback,
+      user_data,
+    );
+  }
+
+  late final _mp_face_mesh_create_asyncPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<MpFaceMeshCreateTask> Function(
+            ffi.Pointer<ffi.Void>,
+            ffi.Size,
+            ffi.Pointer<MpFaceMeshCreateOptions>,
+            MpFaceMeshCreateCallback,
+            ffi.Pointer<ffi.Void>,
+          )
+        >
+      >('mp_face_mesh_create_async');
+  late final _mp_face_mesh_create_async = _mp_face_mesh_create_asyncPtr
+      .asFunction<
+        ffi.Pointer<MpFaceMeshCreateTask> Function(
+          ffi.Pointer<ffi.Void>,
+          int,
+          ffi.Pointer<MpFaceMeshCreateOptions>,
+          MpFaceMeshCreateCallback,
+          ffi.Pointer<ffi.Void>,
+        )
+      >();
+
+  ffi.Pointer<MpFaceMeshContext> mp_face_mesh_create_task_wait(
+    ffi.Pointer<MpFaceMeshCreateTask> task,
+  ) {
+    return _mp_face_mesh_create_task_wait(task);
+  }
+
+  late final _mp_face_mesh_create_task_waitPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<MpFaceMeshContext> Function(
+            ffi.Pointer<MpFaceMeshCreateTask>,
+          )
+        >
+      >('mp_face_mesh_create_task_wait');
+  late final _mp_face_mesh_create_task_wait = _mp_face_mesh_create_task_waitPtr
+      .asFunction<
+        ffi.Pointer<MpFaceMeshContext> Function(
+          ffi.Pointer<MpFaceMeshCreateTask>,
+        )
+      >();
+
+  void mp_face_mesh_create_task_destroy(
+    ffi.Pointer<MpFaceMeshCreateTask> task,
+  ) {
+    return _mp_face_mesh_create_task_destroy(task);
+  }
+
+  late final _mp_face_mesh_create_task_destroyPtr =
+      _lookup<
+        ffi.NativeFunction<ffi.Void Function(ffi.Pointer<MpFaceMeshCreateTask>)>
+      >('mp_face_mesh_create_task_destroy');
+  late final _mp_face_mesh_create_task_destroy =
+      _mp_face_mesh_create_task_destroyPtr
+          .asFunction<void Function(ffi.Pointer<MpFaceMeshCreateTask>)>();
+
   void mp_face_mesh_destroy(ffi.Pointer<MpFaceMeshContext> context) {
     return _mp_face_mesh_destroy(context);
   }
@@ -139,6 +241,306 @@ class MediapipeFaceBindings {
         )
       >();
 
+  ffi.Pointer<MpFaceMeshResult> mp_face_mesh_process_yuv(
+    ffi.Pointer<MpFaceMeshContext> context,
+    ffi.Pointer<MpYuvImage> image,
+    ffi.Pointer<MpNormalizedRect> override_rect,
+    int rotation_degrees,
+    int mirror_horizontal,
+  ) {
+    return _mp_face_mesh_process_yuv(
+      context,
+      image,
+      override_rect,
+      rotation_degrees,
+      mirror_horizontal,
+    );
+  }
+
+  late final _mp_face_mesh_process_yuvPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<MpFaceMeshResult> Function(
+            ffi.Pointer<MpFaceMeshContext>,
+            ffi.Pointer<MpYuvImage>,
+            ffi.Pointer<MpNormalizedRect>,
+            ffi.Int32,
+            ffi.Uint8,
+          )
+        >
+      >('mp_face_mesh_process_yuv');
+  late final _mp_face_mesh_process_yuv = _mp_face_mesh_process_yuvPtr
+      .asFunction<
+        ffi.Pointer<MpFaceMeshResult> Function(
+          ffi.Pointer<MpFaceMeshContext>,
+          ffi.Pointer<MpYuvImage>,
+          ffi.Pointer<MpNormalizedRect>,
+          int,
+          int,
+        )
+      >();
+
+  ffi.Pointer<MpFaceMeshResult> mp_face_mesh_process_yuv_planes(
+    ffi.Pointer<MpFaceMeshContext> context,
+    ffi.Pointer<ffi.Uint8> y,
+    ffi.Pointer<ffi.Uint8> u,
+    ffi.Pointer<ffi.Uint8> v,
+    ffi.Pointer<MpYuvImage> layout,
+    ffi.Pointer<MpNormalizedRect> override_rect,
+    int rotation_degrees,
+    int mirror_horizontal,
+  ) {
+    return _mp_face_mesh_process_yuv_planes(
+      context,
+      y,
+      u,
+      v,
+      layout,
+      override_rect,
+      rotation_degrees,
+      mirror_horizontal,
+    );
+  }
+
+  late final _mp_face_mesh_process_yuv_planesPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<MpFaceMeshResult> Function(
+            ffi.Pointer<MpFaceMeshContext>,
+            ffi.Pointer<ffi.Uint8>,
+            ffi.Pointer<ffi.Uint8>,
+            ffi.Pointer<ffi.Uint8>,
+            ffi.Pointer<MpYuvImage>,
+            ffi.Pointer<MpNormalizedRect>,
+            ffi.Int32,
+            ffi.Uint8,
+          )
+        >
+      >('mp_face_mesh_process_yuv_planes');
+  late final _mp_face_mesh_process_yuv_planes =
+      _mp_face_mesh_process_yuv_planesPtr
+          .asFunction<
+            ffi.Pointer<MpFaceMeshResult> Function(
+              ffi.Pointer<MpFaceMeshContext>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<ffi.Uint8>,
+              ffi.Pointer<MpYuvImage>,
+              ffi.Pointer<MpNormalizedRect>,
+              int,
+              int,
+            )
+          >(isLeaf: true);
+
+  ffi.Pointer<ffi.Float> mp_face_mesh_input_tensor(
+    ffi.Pointer<MpFaceMeshContext> context,
+    ffi.Pointer<ffi.Int32> width,
+    ffi.Pointer<ffi.Int32> height,
+  ) {
+    return _mp_face_mesh_input_tensor(context, width, height);
+  }
+
+  late final _mp_face_mesh_input_tensorPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<ffi.Float> Function(
+            ffi.Pointer<MpFaceMeshContext>,
+            ffi.Pointer<ffi.Int32>,
+            ffi.Pointer<ffi.Int32>,
+          )
+        >
+      >('mp_face_mesh_input_tensor');
+  late final _mp_face_mesh_input_tensor = _mp_face_mesh_input_tensorPtr
+      .asFunction<
+        ffi.Pointer<ffi.Float> Function(
+          ffi.Pointer<MpFaceMeshContext>,
+          ffi.Pointer<ffi.Int32>,
+          ffi.Pointer<ffi.Int32>,
+        )
+      >();
+
+  ffi.Pointer<MpFaceMeshResult> mp_face_mesh_process_crop(
+    ffi.Pointer<MpFaceMeshContext> context,
+    ffi.Pointer<MpImage> crop,
+    ffi.Pointer<MpNormalizedRect> crop_rect,
+    int image_width,
+    int image_height,
+  ) {
+    return _mp_face_mesh_process_crop(
+      context,
+      crop,
+      crop_rect,
+      image_width,
+      image_height,
+    );
+  }
+
+  late final _mp_face_mesh_process_cropPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<MpFaceMeshResult> Function(
+            ffi.Pointer<MpFaceMeshContext>,
+            ffi.Pointer<MpImage>,
+            ffi.Pointer<MpNormalizedRect>,
+            ffi.Int32,
+            ffi.Int32,
+          )
+        >
+      >('mp_face_mesh_process_crop');
+  late final _mp_face_mesh_process_crop = _mp_face_mesh_process_cropPtr
+      .asFunction<
+        ffi.Pointer<MpFaceMeshResult> Function(
+          ffi.Pointer<MpFaceMeshContext>,
+          ffi.Pointer<MpImage>,
+          ffi.Pointer<MpNormalizedRect>,
+          int,
+          int,
+        )
+      >();
+
+  ffi.Pointer<MpFaceMeshResult> mp_face_mesh_process_tensor(
+    ffi.Pointer<MpFaceMeshContext> context,
+    ffi.Pointer<ffi.Float> tensor,
+    ffi.Pointer<MpNormalizedRect> crop_rect,
+    int image_width,
+    int image_height,
+  ) {
+    return _mp_face_mesh_process_tensor(
+      context,
+      tensor,
+      crop_rect,
+      image_width,
+      image_height,
+    );
+  }
+
+  late final _mp_face_mesh_process_tensorPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<MpFaceMeshResult> Function(
+            ffi.Pointer<MpFaceMeshContext>,
+            ffi.Pointer<ffi.Float>,
+            ffi.Pointer<MpNormalizedRect>,
+            ffi.Int32,
+            ffi.Int32,
+          )
+        >
+      >('mp_face_mesh_process_tensor');
+  late final _mp_face_mesh_process_tensor = _mp_face_mesh_process_tensorPtr
+      .asFunction<
+        ffi.Pointer<MpFaceMeshResult> Function(
+          ffi.Pointer<MpFaceMeshContext>,
+          ffi.Pointer<ffi.Float>,
+          ffi.Pointer<MpNormalizedRect>,
+          int,
+          int,
+        )
+      >();
+
+  int mp_face_mesh_last_crop(
+    ffi.Pointer<MpFaceMeshContext> context,
+    int format,
+    ffi.Pointer<MpFaceCrop> crop,
+  ) {
+    return _mp_face_mesh_last_crop(context, format, crop);
+  }
+
+  late final _mp_face_mesh_last_cropPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int32 Function(
+            ffi.Pointer<MpFaceMeshContext>,
+            ffi.UnsignedInt,
+            ffi.Pointer<MpFaceCrop>,
+          )
+        >
+      >('mp_face_mesh_last_crop');
+  late final _mp_face_mesh_last_crop = _mp_face_mesh_last_cropPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<MpFaceMeshContext>,
+          int,
+          ffi.Pointer<MpFaceCrop>,
+        )
+      >();
+
+  int mp_face_mesh_warmup(
+    ffi.Pointer<MpFaceMeshContext> context,
+    int iterations,
+    int format,
+    ffi.Pointer<ffi.Float> timings_ms,
+  ) {
+    return _mp_face_mesh_warmup(context, iterations, format, timings_ms);
+  }
+
+  late final _mp_face_mesh_warmupPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int32 Function(
+            ffi.Pointer<MpFaceMeshContext>,
+            ffi.Int32,
+            ffi.UnsignedInt,
+            ffi.Pointer<ffi.Float>,
+          )
+        >
+      >('mp_face_mesh_warmup');
+  late final _mp_face_mesh_warmup = _mp_face_mesh_warmupPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<MpFaceMeshContext>,
+          int,
+          int,
+          ffi.Pointer<ffi.Float>,
+        )
+      >();
+
+  int mp_convert_yuv_to_rgba(
+    ffi.Pointer<MpYuvImage> image,
+    int rotation_degrees,
+    int mirror_horizontal,
+    int downscale,
+    ffi.Pointer<ffi.Uint8> dst,
+    int dst_bytes_per_row,
+    int dst_height,
+  ) {
+    return _mp_convert_yuv_to_rgba(
+      image,
+      rotation_degrees,
+      mirror_horizontal,
+      downscale,
+      dst,
+      dst_bytes_per_row,
+      dst_height,
+    );
+  }
+
+  late final _mp_convert_yuv_to_rgbaPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Int32 Function(
+            ffi.Pointer<MpYuvImage>,
+            ffi.Int32,
+            ffi.Uint8,
+            ffi.Int32,
+            ffi.Pointer<ffi.Uint8>,
+            ffi.Int32,
+            ffi.Int32,
+          )
+        >
+      >('mp_convert_yuv_to_rgba');
+  late final _mp_convert_yuv_to_rgba = _mp_convert_yuv_to_rgbaPtr
+      .asFunction<
+        int Function(
+          ffi.Pointer<MpYuvImage>,
+          int,
+          int,
+          int,
+          ffi.Pointer<ffi.Uint8>,
+          int,
+          int,
+        )
+      >();
+
   void mp_face_mesh_release_result(ffi.Pointer<MpFaceMeshResult> result) {
     return _mp_face_mesh_release_result(result);
   }
@@ -167,6 +569,23 @@ class MediapipeFaceBindings {
         ffi.Pointer<ffi.Char> Function(ffi.Pointer<MpFaceMeshContext>)
       >();
 
+  ffi.Pointer<ffi.Char> mp_face_mesh_kernel_isa(
+    ffi.Pointer<MpFaceMeshContext> context,
+  ) {
+    return _mp_face_mesh_kernel_isa(context);
+  }
+
+  late final _mp_face_mesh_kernel_isaPtr =
+      _lookup<
+        ffi.NativeFunction<
+          ffi.Pointer<ffi.Char> Function(ffi.Pointer<MpFaceMeshContext>)
+        >
+      >('mp_face_mesh_kernel_isa');
+  late final _mp_face_mesh_kernel_isa = _mp_face_mesh_kernel_isaPtr
+      .asFunction<
+        ffi.Pointer<ffi.Char> Function(ffi.Pointer<MpFaceMeshContext>)
+      >();
+
   ffi.Pointer<ffi.Char> mp_face_mesh_last_global_error() {
     return _mp_face_mesh_last_global_error();
   }
@@ -182,9 +601,12 @@ class MediapipeFaceBindings {
 
 final class MpFaceMeshContext extends ffi.Opaque {}
 
+final class MpFaceMeshCreateTask extends ffi.Opaque {}
+
 enum MpPixelFormat {
   MP_PIXEL_FORMAT_RGBA(0),
-  MP_PIXEL_FORMAT_BGRA(1);
+  MP_PIXEL_FORMAT_BGRA(1),
+  MP_PIXEL_FORMAT_RGB(2);
 
   final int value;
   const MpPixelFormat(this.value);
@@ -192,6 +614,7 @@ enum MpPixelFormat {
   static MpPixelFormat fromValue(int value) => switch (value) {
     0 => MP_PIXEL_FORMAT_RGBA,
     1 => MP_PIXEL_FORMAT_BGRA,
+    2 => MP_PIXEL_FORMAT_RGB,
     _ => throw ArgumentError("Unknown value for MpPixelFormat: $value"),
   };
 }
@@ -212,6 +635,72 @@ enum MpDelegateType {
   };
 }
 
+enum MpInterpolation {
+  MP_INTERPOLATION_BILINEAR(0),
+  MP_INTERPOLATION_NEAREST(1),
+  MP_INTERPOLATION_AREA(2),
+  MP_INTERPOLATION_AUTO(3);
+
+  final int value;
+  const MpInterpolation(this.value);
+
+  static MpInterpolation fromValue(int value) => switch (value) {
+    0 => MP_INTERPOLATION_BILINEAR,
+    1 => MP_INTERPOLATION_NEAREST,
+    2 => MP_INTERPOLATION_AREA,
+    3 => MP_INTERPOLATION_AUTO,
+    _ => throw ArgumentError("Unknown value for MpInterpolation: $value"),
+  };
+}
+
+enum MpKernelIsa {
+  MP_KERNEL_ISA_AUTO(0),
+  MP_KERNEL_ISA_BASELINE(1),
+  MP_KERNEL_ISA_AVX2(2);
+
+  final int value;
+  const MpKernelIsa(this.value);
+
+  static MpKernelIsa fromValue(int value) => switch (value) {
+    0 => MP_KERNEL_ISA_AUTO,
+    1 => MP_KERNEL_ISA_BASELINE,
+    2 => MP_KERNEL_ISA_AVX2,
+    _ => throw ArgumentError("Unknown value for MpKernelIsa: $value"),
+  };
+}
+
+enum MpWarmupFormat {
+  MP_WARMUP_FORMAT_RGBA(0),
+  MP_WARMUP_FORMAT_BGRA(1),
+  MP_WARMUP_FORMAT_NV21(2),
+  MP_WARMUP_FORMAT_I420(3);
+
+  final int value;
+  const MpWarmupFormat(this.value);
+
+  static MpWarmupFormat fromValue(int value) => switch (value) {
+    0 => MP_WARMUP_FORMAT_RGBA,
+    1 => MP_WARMUP_FORMAT_BGRA,
+    2 => MP_WARMUP_FORMAT_NV21,
+    3 => MP_WARMUP_FORMAT_I420,
+    _ => throw ArgumentError("Unknown value for MpWarmupFormat: $value"),
+  };
+}
+
+enum MpCropFormat {
+  MP_CROP_FORMAT_RGB(0),
+  MP_CROP_FORMAT_FLOAT(1);
+
+  final int value;
+  const MpCropFormat(this.value);
+
+  static MpCropFormat fromValue(int value) => switch (value) {
+    0 => MP_CROP_FORMAT_RGB,
+    1 => MP_CROP_FORMAT_FLOAT,
+    _ => throw ArgumentError("Unknown value for MpCropFormat: $value"),
+  };
+}
+
 final class MpImage extends ffi.Struct {
   external ffi.Pointer<ffi.Uint8> data;
 
@@ -247,6 +736,34 @@ final class MpNv21Image extends ffi.Struct {
   external int vu_bytes_per_row;
 }
 
+/// YUV 4:2:0 input with separate plane pointers (Android YUV_420_888, NV21,
+/// NV12, I420, YV12). Chroma sample (x / 2, y / 2) is read from
+/// u[(y / 2) * uv_bytes_per_row + (x / 2) * uv_pixel_stride], and likewise
+/// from v. Interleaved layouts pass pointers into the shared plane with a
+/// pixel stride of 2.
+final class MpYuvImage extends ffi.Struct {
+  external ffi.Pointer<ffi.Uint8> y;
+
+  external ffi.Pointer<ffi.Uint8> u;
+
+  external ffi.Pointer<ffi.Uint8> v;
+
+  @ffi.Int32()
+  external int width;
+
+  @ffi.Int32()
+  external int height;
+
+  @ffi.Int32()
+  external int y_bytes_per_row;
+
+  @ffi.Int32()
+  external int uv_bytes_per_row;
+
+  @ffi.Int32()
+  external int uv_pixel_stride;
+}
+
 final class MpNormalizedRect extends ffi.Struct {
   @ffi.Float()
   external double x_center;
@@ -293,6 +810,32 @@ final class MpFaceMeshResult extends ffi.Struct {
   external int image_height;
 }
 
+/// Face crop the model last ran on, borrowed from the context.
+final class MpFaceCrop extends ffi.Struct {
+  external ffi.Pointer<ffi.Void> data;
+
+  @ffi.Int32()
+  external int width;
+
+  @ffi.Int32()
+  external int height;
+
+  @ffi.Int32()
+  external int bytes_per_row;
+
+  @ffi.UnsignedInt()
+  external int format;
+
+  @ffi.Array.multi([6])
+  external ffi.Array<ffi.Float> transform;
+
+  @ffi.Int32()
+  external int image_width;
+
+  @ffi.Int32()
+  external int image_height;
+}
+
 final class MpFaceMeshCreateOptions extends ffi.Struct {
   external ffi.Pointer<ffi.Char> tflite_library_path;
 
@@ -313,4 +856,22 @@ final class MpFaceMeshCreateOptions extends ffi.Struct {
 
   @ffi.Uint8()
   external int enable_roi_tracking;
+
+  @ffi.Uint8()
+  external int enable_fixed_point_preprocessing;
+
+  @ffi.UnsignedInt()
+  external int interpolation;
+
+  @ffi.UnsignedInt()
+  external int kernel_isa;
+
+  external ffi.Pointer<ffi.Char> xnnpack_weight_cache_dir;
 }
+
+typedef MpFaceMeshCreateCallback =
+    ffi.Pointer<ffi.NativeFunction<MpFaceMeshCreateCallbackFunction>>;
+typedef MpFaceMeshCreateCallbackFunction =
+    ffi.Void Function(ffi.Pointer<ffi.Void> user_data);
+typedef DartMpFaceMeshCreateCallbackFunction =
+    void Function(ffi.Pointer<ffi.Void> user_data);
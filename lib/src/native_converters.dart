@@ -19,6 +19,21 @@ class _NativeNv21Image {
   final ffi.Pointer<ffi.Uint8> vuPlane;
 }
 
+class _NativeYuvImage {
+  _NativeYuvImage({
+    required this.image,
+    required this.yPlane,
+    required this.chromaPlanes,
+  });
+
+  final ffi.Pointer<MpYuvImage> image;
+  final ffi.Pointer<ffi.Uint8> yPlane;
+
+  /// Allocations behind the U and V pointers: one when the planes share an
+  /// interleaved buffer, two otherwise.
+  final List<ffi.Pointer<ffi.Uint8>> chromaPlanes;
+}
+
 _NativeImage _toNativeImage(FaceMeshImage image) {
   final ffi.Pointer<MpImage> imagePtr = pkg_ffi.calloc<MpImage>();
   final ffi.Pointer<ffi.Uint8> pixelPtr = pkg_ffi.calloc<ffi.Uint8>(
@@ -54,6 +69,71 @@ _NativeNv21Image _toNativeNv21Image(FaceMeshNv21Image image) {
   return _NativeNv21Image(image: imagePtr, yPlane: yPtr, vuPlane: vuPtr);
 }
 
+ffi.Pointer<ffi.Uint8> _copyPlane(Uint8List plane) {
+  final ffi.Pointer<ffi.Uint8> ptr = pkg_ffi.calloc<ffi.Uint8>(plane.length);
+  ptr.asTypedList(plane.length).setAll(0, plane);
+  return ptr;
+}
+
+_NativeYuvImage _toNativeYuvImage(FaceMeshYuvImage image) {
+  final ffi.Pointer<MpYuvImage> imagePtr = pkg_ffi.calloc<MpYuvImage>();
+  final ffi.Pointer<ffi.Uint8> yPtr = _copyPlane(image.yPlane);
+  final Uint8List u = image.uPlane;
+  final Uint8List v = image.vPlane;
+  final int uFromV = u.offsetInBytes - v.offsetInBytes;
+  final ffi.Pointer<ffi.Uint8> uPtr;
+  final ffi.Pointer<ffi.Uint8> vPtr;
+  final List<ffi.Pointer<ffi.Uint8>> chromaPlanes;
+  if (image.uvPixelStride == 2 &&
+      (uFromV == 1 || uFromV == -1) &&
+      u.buffer == v.buffer) {
+    // Views into one interleaved VU (NV21) or UV (NV12) buffer. Copying the
+    // shared range once keeps the planes one byte apart, so the native side
+    // still reads them as a single interleaved plane.
+    final int start = uFromV > 0 ? v.offsetInBytes : u.offsetInBytes;
+    final int uEnd = u.offsetInBytes + u.length;
+    final int vEnd = v.offsetInBytes + v.length;
+    final int end = uEnd > vEnd ? uEnd : vEnd;
+    final ffi.Pointer<ffi.Uint8> shared = _copyPlane(
+      u.buffer.asUint8List(start, end - start),
+    );
+    uPtr = shared + (u.offsetInBytes - start);
+    vPtr = shared + (v.offsetInBytes - start);
+    chromaPlanes = <ffi.Pointer<ffi.Uint8>>[shared];
+  } else {
+    uPtr = _copyPlane(u);
+    vPtr = _copyPlane(v);
+    chromaPlanes = <ffi.Pointer<ffi.Uint8>>[uPtr, vPtr];
+  }
+  imagePtr.ref
+    ..y = yPtr
+    ..u = uPtr
+    ..v = vPtr
+    ..width = image.width
+    ..height = image.height
+    ..y_bytes_per_row = image.yBytesPerRow
+    ..uv_bytes_per_row = image.uvBytesPerRow
+    ..uv_pixel_stride = image.uvPixelStride;
+  return _NativeYuvImage(
+    image: imagePtr,
+    yPlane: yPtr,
+    chromaPlanes: chromaPlanes,
+  );
+}
+
+/// Plane geometry of [image] for `mp_face_mesh_process_yuv_planes`, which
+/// takes the plane pointers themselves as leaf-call arguments.
+ffi.Pointer<MpYuvImage> _toNativeYuvLayout(FaceMeshYuvImage image) {
+  final ffi.Pointer<MpYuvImage> layoutPtr = pkg_ffi.calloc<MpYuvImage>();
+  layoutPtr.ref
+    ..width = image.width
+    ..height = image.height
+    ..y_bytes_per_row = image.yBytesPerRow
+    ..uv_bytes_per_row = image.uvBytesPerRow
+    ..uv_pixel_stride = image.uvPixelStride;
+  return layoutPtr;
+}
+
 ffi.Pointer<MpNormalizedRect> _toNativeRect(NormalizedRect rect) {
   final ffi.Pointer<MpNormalizedRect> roiPtr = pkg_ffi
       .calloc<MpNormalizedRect>();
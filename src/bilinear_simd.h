@@ -0,0 +1,460 @@
+#ifndef BILINEAR_SIMD_H_
+#define BILINEAR_SIMD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "cpu_features.h"
+#include "pixel_sources.h"
+
+namespace mp {
+
+// Vector span kernels. Each overload samples whole vectors of output pixels
+// from `begin` towards `end` and returns the index of the first pixel it did
+// not write; the caller finishes with SampleBilinearInterior. Every pixel in
+// [begin, end) must have all four taps inside the source (see
+// RowInteriorSpan), so the kernels neither test bounds nor clamp taps.
+// Sources without a vector kernel fall through to the scalar path.
+template <typename Source>
+inline int BilinearSpan(const Source&,
+                        float,
+                        float,
+                        float,
+                        float,
+                        float*,
+                        int begin,
+                        int) {
+  return begin;
+}
+
+// AVX2 counterparts, run before BilinearSpan when the context selected
+// KernelIsa::kAvx2; BilinearSpan then finishes what they leave.
+template <typename Source>
+inline int BilinearSpanAvx2(const Source&,
+                            float,
+                            float,
+                            float,
+                            float,
+                            float*,
+                            int begin,
+                            int) {
+  return begin;
+}
+
+// Nearest-neighbour counterparts with the same contract over the one-tap
+// interior span. `row_x`/`row_y` already include the +0.5 that turns
+// truncation into rounding; the caller finishes with SampleNearest.
+template <typename Source>
+inline int NearestSpan(const Source&,
+                       float,
+                       float,
+                       float,
+                       float,
+                       float*,
+                       int begin,
+                       int) {
+  return begin;
+}
+
+namespace simd_internal {
+
+inline uint32_t LoadPixel(const uint8_t* ptr) {
+  uint32_t value;
+  std::memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+// Loads the four bilinear taps of `lanes` pixels whose top-left tap is at
+// (xs[i], ys[i]). The caller has already checked that every tap is inside.
+template <int kR, int kB, int kLanes>
+inline void GatherPackedTaps(const PackedPixelSource<kR, kB>& source,
+                             const int32_t* xs,
+                             const int32_t* ys,
+                             uint32_t* p00,
+                             uint32_t* p10,
+                             uint32_t* p01,
+                             uint32_t* p11) {
+  const size_t down = static_cast<size_t>(source.bytes_per_row);
+  for (int i = 0; i < kLanes; ++i) {
+    const uint8_t* top = source.data + static_cast<size_t>(ys[i]) * down +
+                         static_cast<size_t>(xs[i]) * 4;
+    p00[i] = LoadPixel(top);
+    p10[i] = LoadPixel(top + 4);
+    p01[i] = LoadPixel(top + down);
+    p11[i] = LoadPixel(top + down + 4);
+  }
+}
+
+// Loads the pixels at (xs[i], ys[i]) for `lanes` nearest-neighbour taps.
+template <int kR, int kB, int kLanes>
+inline void GatherPackedPixels(const PackedPixelSource<kR, kB>& source,
+                               const int32_t* xs,
+                               const int32_t* ys,
+                               uint32_t* pixels) {
+  for (int i = 0; i < kLanes; ++i) {
+    pixels[i] = LoadPixel(source.data +
+                          static_cast<size_t>(ys[i]) * source.bytes_per_row +
+                          static_cast<size_t>(xs[i]) * 4);
+  }
+}
+
+}  // namespace simd_internal
+
+#if defined(MP_SIMD_SSE2)
+
+namespace simd_internal {
+
+template <int kShift>
+inline __m128 Channel(__m128i pixels) {
+  return _mm_cvtepi32_ps(
+      _mm_and_si128(_mm_srli_epi32(pixels, kShift), _mm_set1_epi32(0xFF)));
+}
+
+inline __m128 Blend(__m128 p00, __m128 p10, __m128 p01, __m128 p11,
+                    __m128 dx, __m128 dy) {
+  const __m128 top = _mm_add_ps(p00, _mm_mul_ps(_mm_sub_ps(p10, p00), dx));
+  const __m128 bottom = _mm_add_ps(p01, _mm_mul_ps(_mm_sub_ps(p11, p01), dx));
+  const __m128 value = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), dy));
+  return _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(kPixelScale)),
+                    _mm_set1_ps(kPixelOffset));
+}
+
+inline __m128 Normalize(__m128 value) {
+  return _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(kPixelScale)),
+                    _mm_set1_ps(kPixelOffset));
+}
+
+// Writes 4 planar RGB lanes as 12 interleaved floats.
+inline void StoreRgb(float* out, __m128 r, __m128 g, __m128 b) {
+  const __m128 rg_lo = _mm_unpacklo_ps(r, g);  // r0 g0 r1 g1
+  const __m128 rg_hi = _mm_unpackhi_ps(r, g);  // r2 g2 r3 g3
+  const __m128 b0r1 = _mm_shuffle_ps(b, r, _MM_SHUFFLE(1, 1, 0, 0));
+  const __m128 g1b1 = _mm_shuffle_ps(g, b, _MM_SHUFFLE(1, 1, 1, 1));
+  const __m128 b2r3 = _mm_shuffle_ps(b, r, _MM_SHUFFLE(3, 3, 2, 2));
+  const __m128 g3b3 = _mm_shuffle_ps(g, b, _MM_SHUFFLE(3, 3, 3, 3));
+  _mm_storeu_ps(out, _mm_shuffle_ps(rg_lo, b0r1, _MM_SHUFFLE(2, 0, 1, 0)));
+  _mm_storeu_ps(out + 4, _mm_shuffle_ps(g1b1, rg_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+  _mm_storeu_ps(out + 8, _mm_shuffle_ps(b2r3, g3b3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+template <int kR, int kB>
+inline void BlendPacked4(__m128i q00, __m128i q10, __m128i q01, __m128i q11,
+                         __m128 dx, __m128 dy, float* out) {
+  using Source = PackedPixelSource<kR, kB>;
+  constexpr int kRed = Source::kRedShift;
+  constexpr int kBlue = Source::kBlueShift;
+  const __m128 r = Blend(Channel<kRed>(q00), Channel<kRed>(q10),
+                         Channel<kRed>(q01), Channel<kRed>(q11), dx, dy);
+  const __m128 g = Blend(Channel<8>(q00), Channel<8>(q10), Channel<8>(q01),
+                         Channel<8>(q11), dx, dy);
+  const __m128 b = Blend(Channel<kBlue>(q00), Channel<kBlue>(q10),
+                         Channel<kBlue>(q01), Channel<kBlue>(q11), dx, dy);
+  StoreRgb(out, r, g, b);
+}
+
+template <int kR, int kB>
+inline void StorePacked4(__m128i pixels, float* out) {
+  using Source = PackedPixelSource<kR, kB>;
+  StoreRgb(out, Normalize(Channel<Source::kRedShift>(pixels)),
+           Normalize(Channel<8>(pixels)),
+           Normalize(Channel<Source::kBlueShift>(pixels)));
+}
+
+// Calls `kernel(xi, yi, dx, dy, out)` for each group of 4 output pixels
+// from `begin` while a whole group fits before `end`, where (xi, yi) is the
+// top-left tap and (dx, dy) the blend weights. Returns the index of the first
+// pixel not written.
+template <typename Kernel>
+inline int ForEachQuad(float row_x,
+                       float row_y,
+                       float step_x,
+                       float step_y,
+                       float* out,
+                       int begin,
+                       int end,
+                       Kernel&& kernel) {
+  const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+  int x = begin;
+  for (; x + 4 <= end; x += 4) {
+    const __m128 index = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lane);
+    const __m128 sx =
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(step_x), index), _mm_set1_ps(row_x));
+    const __m128 sy =
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(step_y), index), _mm_set1_ps(row_y));
+    const __m128i xi = _mm_cvttps_epi32(sx);
+    const __m128i yi = _mm_cvttps_epi32(sy);
+    kernel(xi, yi, _mm_sub_ps(sx, _mm_cvtepi32_ps(xi)),
+           _mm_sub_ps(sy, _mm_cvtepi32_ps(yi)), out + x * 3);
+  }
+  return x;
+}
+
+}  // namespace simd_internal
+
+#if defined(MP_SIMD_AVX2)
+
+template <int kR, int kB>
+MP_TARGET_AVX2 inline int BilinearSpanAvx2(
+    const PackedPixelSource<kR, kB>& source,
+    float row_x,
+    float row_y,
+    float step_x,
+    float step_y,
+    float* out,
+    int begin,
+    int end) {
+  // Gathers use 32-bit byte offsets from the start of the buffer.
+  if (static_cast<int64_t>(source.height) * source.bytes_per_row >
+      INT32_MAX) {
+    return begin;
+  }
+  const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i stride = _mm256_set1_epi32(source.bytes_per_row);
+  const __m256i right = _mm256_set1_epi32(4);
+  const int* base = reinterpret_cast<const int*>(source.data);
+  int x = begin;
+  for (; x + 8 <= end; x += 8) {
+    const __m256 index = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)),
+                                       lane);
+    const __m256 sx = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(step_x), index),
+                                    _mm256_set1_ps(row_x));
+    const __m256 sy = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(step_y), index),
+                                    _mm256_set1_ps(row_y));
+    const __m256i xi = _mm256_cvttps_epi32(sx);
+    const __m256i yi = _mm256_cvttps_epi32(sy);
+    const __m256 dx = _mm256_sub_ps(sx, _mm256_cvtepi32_ps(xi));
+    const __m256 dy = _mm256_sub_ps(sy, _mm256_cvtepi32_ps(yi));
+    const __m256i offset = _mm256_add_epi32(_mm256_mullo_epi32(yi, stride),
+                                            _mm256_slli_epi32(xi, 2));
+    const __m256i bottom = _mm256_add_epi32(offset, stride);
+    const __m256i q00 = _mm256_i32gather_epi32(base, offset, 1);
+    const __m256i q10 =
+        _mm256_i32gather_epi32(base, _mm256_add_epi32(offset, right), 1);
+    const __m256i q01 = _mm256_i32gather_epi32(base, bottom, 1);
+    const __m256i q11 =
+        _mm256_i32gather_epi32(base, _mm256_add_epi32(bottom, right), 1);
+    for (int half = 0; half < 2; ++half) {
+      const __m128i h00 = half ? _mm256_extracti128_si256(q00, 1)
+                               : _mm256_castsi256_si128(q00);
+      const __m128i h10 = half ? _mm256_extracti128_si256(q10, 1)
+                               : _mm256_castsi256_si128(q10);
+      const __m128i h01 = half ? _mm256_extracti128_si256(q01, 1)
+                               : _mm256_castsi256_si128(q01);
+      const __m128i h11 = half ? _mm256_extracti128_si256(q11, 1)
+                               : _mm256_castsi256_si128(q11);
+      const __m128 hdx = half ? _mm256_extractf128_ps(dx, 1)
+                              : _mm256_castps256_ps128(dx);
+      const __m128 hdy = half ? _mm256_extractf128_ps(dy, 1)
+                              : _mm256_castps256_ps128(dy);
+      simd_internal::BlendPacked4<kR, kB>(h00, h10, h01, h11, hdx, hdy,
+                                          out + (x + half * 4) * 3);
+    }
+  }
+  return x;
+}
+
+#endif  // MP_SIMD_AVX2
+
+template <int kR, int kB>
+inline int BilinearSpan(const PackedPixelSource<kR, kB>& source,
+                        float row_x,
+                        float row_y,
+                        float step_x,
+                        float step_y,
+                        float* out,
+                        int begin,
+                        int end) {
+  return simd_internal::ForEachQuad(
+      row_x, row_y, step_x, step_y, out, begin, end,
+      [&source](__m128i xi, __m128i yi, __m128 dx, __m128 dy, float* dst) {
+        alignas(16) int32_t xs[4];
+        alignas(16) int32_t ys[4];
+        alignas(16) uint32_t p00[4];
+        alignas(16) uint32_t p10[4];
+        alignas(16) uint32_t p01[4];
+        alignas(16) uint32_t p11[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(xs), xi);
+        _mm_store_si128(reinterpret_cast<__m128i*>(ys), yi);
+        simd_internal::GatherPackedTaps<kR, kB, 4>(source, xs, ys, p00, p10,
+                                                   p01, p11);
+        simd_internal::BlendPacked4<kR, kB>(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(p00)),
+            _mm_load_si128(reinterpret_cast<const __m128i*>(p10)),
+            _mm_load_si128(reinterpret_cast<const __m128i*>(p01)),
+            _mm_load_si128(reinterpret_cast<const __m128i*>(p11)), dx, dy,
+            dst);
+      });
+}
+
+template <int kR, int kB>
+inline int NearestSpan(const PackedPixelSource<kR, kB>& source,
+                       float row_x,
+                       float row_y,
+                       float step_x,
+                       float step_y,
+                       float* out,
+                       int begin,
+                       int end) {
+  return simd_internal::ForEachQuad(
+      row_x, row_y, step_x, step_y, out, begin, end,
+      [&source](__m128i xi, __m128i yi, __m128, __m128, float* dst) {
+        alignas(16) int32_t xs[4];
+        alignas(16) int32_t ys[4];
+        alignas(16) uint32_t pixels[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(xs), xi);
+        _mm_store_si128(reinterpret_cast<__m128i*>(ys), yi);
+        simd_internal::GatherPackedPixels<kR, kB, 4>(source, xs, ys, pixels);
+        simd_internal::StorePacked4<kR, kB>(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(pixels)), dst);
+      });
+}
+
+#elif defined(MP_SIMD_NEON)
+
+namespace simd_internal {
+
+template <int kShift>
+inline float32x4_t Channel(uint32x4_t pixels) {
+  if constexpr (kShift == 0) {
+    return vcvtq_f32_u32(vandq_u32(pixels, vdupq_n_u32(0xFF)));
+  } else {
+    return vcvtq_f32_u32(
+        vandq_u32(vshrq_n_u32(pixels, kShift), vdupq_n_u32(0xFF)));
+  }
+}
+
+inline float32x4_t Blend(float32x4_t p00, float32x4_t p10, float32x4_t p01,
+                         float32x4_t p11, float32x4_t dx, float32x4_t dy) {
+  const float32x4_t top = vaddq_f32(p00, vmulq_f32(vsubq_f32(p10, p00), dx));
+  const float32x4_t bottom =
+      vaddq_f32(p01, vmulq_f32(vsubq_f32(p11, p01), dx));
+  const float32x4_t value =
+      vaddq_f32(top, vmulq_f32(vsubq_f32(bottom, top), dy));
+  return vaddq_f32(vmulq_n_f32(value, kPixelScale), vdupq_n_f32(kPixelOffset));
+}
+
+inline void StoreRgb(float* out, float32x4_t r, float32x4_t g, float32x4_t b) {
+  float32x4x3_t rgb;
+  rgb.val[0] = r;
+  rgb.val[1] = g;
+  rgb.val[2] = b;
+  vst3q_f32(out, rgb);
+}
+
+inline float32x4_t Normalize(float32x4_t value) {
+  return vaddq_f32(vmulq_n_f32(value, kPixelScale), vdupq_n_f32(kPixelOffset));
+}
+
+template <int kR, int kB>
+inline void StorePacked4(uint32x4_t pixels, float* out) {
+  using Source = PackedPixelSource<kR, kB>;
+  StoreRgb(out, Normalize(Channel<Source::kRedShift>(pixels)),
+           Normalize(Channel<8>(pixels)),
+           Normalize(Channel<Source::kBlueShift>(pixels)));
+}
+
+// Calls `kernel(xi, yi, dx, dy, out)` for each group of 4 output pixels
+// from `begin` while a whole group fits before `end`, where (xi, yi) is the
+// top-left tap and (dx, dy) the blend weights. Returns the index of the first
+// pixel not written.
+template <typename Kernel>
+inline int ForEachQuad(float row_x,
+                       float row_y,
+                       float step_x,
+                       float step_y,
+                       float* out,
+                       int begin,
+                       int end,
+                       Kernel&& kernel) {
+  static const float kLane[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+  const float32x4_t lane = vld1q_f32(kLane);
+  int x = begin;
+  for (; x + 4 <= end; x += 4) {
+    const float32x4_t index =
+        vaddq_f32(vdupq_n_f32(static_cast<float>(x)), lane);
+    const float32x4_t sx =
+        vaddq_f32(vmulq_n_f32(index, step_x), vdupq_n_f32(row_x));
+    const float32x4_t sy =
+        vaddq_f32(vmulq_n_f32(index, step_y), vdupq_n_f32(row_y));
+    const int32x4_t xi = vcvtq_s32_f32(sx);
+    const int32x4_t yi = vcvtq_s32_f32(sy);
+    kernel(xi, yi, vsubq_f32(sx, vcvtq_f32_s32(xi)),
+           vsubq_f32(sy, vcvtq_f32_s32(yi)), out + x * 3);
+  }
+  return x;
+}
+
+}  // namespace simd_internal
+
+template <int kR, int kB>
+inline int BilinearSpan(const PackedPixelSource<kR, kB>& source,
+                        float row_x,
+                        float row_y,
+                        float step_x,
+                        float step_y,
+                        float* out,
+                        int begin,
+                        int end) {
+  return simd_internal::ForEachQuad(
+      row_x, row_y, step_x, step_y, out, begin, end,
+      [&source](int32x4_t xi, int32x4_t yi, float32x4_t dx, float32x4_t dy,
+                float* dst) {
+        using simd_internal::Blend;
+        using simd_internal::Channel;
+        using Source = PackedPixelSource<kR, kB>;
+        constexpr int kRed = Source::kRedShift;
+        constexpr int kBlue = Source::kBlueShift;
+        int32_t xs[4];
+        int32_t ys[4];
+        uint32_t p00[4];
+        uint32_t p10[4];
+        uint32_t p01[4];
+        uint32_t p11[4];
+        vst1q_s32(xs, xi);
+        vst1q_s32(ys, yi);
+        simd_internal::GatherPackedTaps<kR, kB, 4>(source, xs, ys, p00, p10,
+                                                   p01, p11);
+        const uint32x4_t q00 = vld1q_u32(p00);
+        const uint32x4_t q10 = vld1q_u32(p10);
+        const uint32x4_t q01 = vld1q_u32(p01);
+        const uint32x4_t q11 = vld1q_u32(p11);
+        simd_internal::StoreRgb(
+            dst,
+            Blend(Channel<kRed>(q00), Channel<kRed>(q10), Channel<kRed>(q01),
+                  Channel<kRed>(q11), dx, dy),
+            Blend(Channel<8>(q00), Channel<8>(q10), Channel<8>(q01),
+                  Channel<8>(q11), dx, dy),
+            Blend(Channel<kBlue>(q00), Channel<kBlue>(q10),
+                  Channel<kBlue>(q01), Channel<kBlue>(q11), dx, dy));
+      });
+}
+
+template <int kR, int kB>
+inline int NearestSpan(const PackedPixelSource<kR, kB>& source,
+                       float row_x,
+                       float row_y,
+                       float step_x,
+                       float step_y,
+                       float* out,
+                       int begin,
+                       int end) {
+  return simd_internal::ForEachQuad(
+      row_x, row_y, step_x, step_y, out, begin, end,
+      [&source](int32x4_t xi, int32x4_t yi, float32x4_t, float32x4_t,
+                float* dst) {
+        int32_t xs[4];
+        int32_t ys[4];
+        uint32_t pixels[4];
+        vst1q_s32(xs, xi);
+        vst1q_s32(ys, yi);
+        simd_internal::GatherPackedPixels<kR, kB, 4>(source, xs, ys, pixels);
+        simd_internal::StorePacked4<kR, kB>(vld1q_u32(pixels), dst);
+      });
+}
+
+#endif  // MP_SIMD_SSE2 / MP_SIMD_NEON
+
+}  // namespace mp
+
+#endif  // BILINEAR_SIMD_H_
@@ -0,0 +1,133 @@
+#ifndef CPU_FEATURES_H_
+#define CPU_FEATURES_H_
+
+#include <cstdint>
+
+// Vector kernel sets compiled into this build. The baseline set follows the
+// ABI's compiler flags: NEON on ARM, SSE2 on x86. AVX2 kernels are built on
+// every x86 target and only run after CpuSupportsAvx2() says so; GCC/Clang
+// compile them per function through MP_TARGET_AVX2, MSVC needs no flag for
+// the intrinsics.
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MP_SIMD_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MP_SIMD_SSE2 1
+#if defined(__AVX2__) || defined(__GNUC__) || defined(_MSC_VER)
+#include <immintrin.h>
+#define MP_SIMD_AVX2 1
+#endif
+#endif
+
+#if defined(MP_SIMD_AVX2) && defined(__GNUC__) && !defined(__AVX2__)
+#define MP_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#else
+#define MP_TARGET_AVX2
+#endif
+
+#if defined(MP_SIMD_AVX2)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace mp {
+
+// Kernel set a context runs its preprocessing and tensor conversion with.
+enum class KernelIsa {
+  kScalar,
+  kSse2,
+  kAvx2,
+  kNeon,
+};
+
+#if defined(MP_SIMD_NEON)
+constexpr KernelIsa kBaselineKernelIsa = KernelIsa::kNeon;
+#elif defined(MP_SIMD_SSE2)
+constexpr KernelIsa kBaselineKernelIsa = KernelIsa::kSse2;
+#else
+constexpr KernelIsa kBaselineKernelIsa = KernelIsa::kScalar;
+#endif
+
+inline const char* KernelIsaName(KernelIsa isa) {
+  switch (isa) {
+    case KernelIsa::kSse2:
+      return "sse2";
+    case KernelIsa::kAvx2:
+      return "avx2";
+    case KernelIsa::kNeon:
+      return "neon";
+    case KernelIsa::kScalar:
+    default:
+      return "scalar";
+  }
+}
+
+// AVX2 and F16C, with the OS saving YMM state across switches. FMA is left
+// out of the kernel target, and the build passes -ffp-contract=off, so
+// neither the vector nor the scalar coordinate math is fused: both round the
+// same way and the vector kernels sample the taps the scalar interior checks
+// admitted.
+inline bool CpuSupportsAvx2() {
+#if defined(MP_SIMD_AVX2)
+  uint32_t leaf1[4] = {0, 0, 0, 0};
+  uint32_t leaf7[4] = {0, 0, 0, 0};
+  uint64_t xcr0 = 0;
+#if defined(_MSC_VER)
+  int regs[4];
+  __cpuid(regs, 0);
+  const uint32_t max_leaf = static_cast<uint32_t>(regs[0]);
+  __cpuidex(regs, 1, 0);
+  for (int i = 0; i < 4; ++i) {
+    leaf1[i] = static_cast<uint32_t>(regs[i]);
+  }
+  if (max_leaf >= 7) {
+    __cpuidex(regs, 7, 0);
+    for (int i = 0; i < 4; ++i) {
+      leaf7[i] = static_cast<uint32_t>(regs[i]);
+    }
+  }
+  const bool osxsave = (leaf1[2] & (1u << 27)) != 0;
+  if (osxsave) {
+    xcr0 = _xgetbv(0);
+  }
+#else
+  const uint32_t max_leaf = __get_cpuid_max(0, nullptr);
+  if (max_leaf < 1) {
+    return false;
+  }
+  __cpuid_count(1, 0, leaf1[0], leaf1[1], leaf1[2], leaf1[3]);
+  if (max_leaf >= 7) {
+    __cpuid_count(7, 0, leaf7[0], leaf7[1], leaf7[2], leaf7[3]);
+  }
+  const bool osxsave = (leaf1[2] & (1u << 27)) != 0;
+  if (osxsave) {
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    xcr0 = (static_cast<uint64_t>(hi) << 32) | lo;
+  }
+#endif
+  const bool avx = (leaf1[2] & (1u << 28)) != 0;
+  const bool f16c = (leaf1[2] & (1u << 29)) != 0;
+  const bool avx2 = (leaf7[1] & (1u << 5)) != 0;
+  return osxsave && (xcr0 & 0x6) == 0x6 && avx && avx2 && f16c;
+#else
+  return false;
+#endif
+}
+
+// Best kernel set this build and CPU can run.
+inline KernelIsa DetectKernelIsa() {
+  static const KernelIsa detected =
+      CpuSupportsAvx2() ? KernelIsa::kAvx2 : kBaselineKernelIsa;
+  return detected;
+}
+
+}  // namespace mp
+
+#endif  // CPU_FEATURES_H_
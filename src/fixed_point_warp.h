@@ -0,0 +1,343 @@
+#ifndef FIXED_POINT_WARP_H_
+#define FIXED_POINT_WARP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "image_warp.h"
+
+namespace mp {
+
+// Opt-in integer bilinear sampling for packed sources. Blend weights are
+// quantized to Q8 and both interpolation passes run on 16-bit lanes with
+// rounding back to 8 bits, so only the final store converts to float. The
+// scalar and vector paths are bit-exact with each other. Against the float
+// path each pass adds at most one level of weight quantization and rounding
+// error, so outputs differ by at most 2 levels (0.016 after normalization).
+constexpr int kFixedWeightOne = 256;
+
+inline int QuantizeWeightQ8(float weight) {
+  return static_cast<int>(weight * static_cast<float>(kFixedWeightOne) +
+                          0.5f);
+}
+
+inline int LerpQ8(int a, int b, int weight) {
+  return (a * (kFixedWeightOne - weight) + b * weight + 128) >> 8;
+}
+
+template <int kR, int kB>
+inline void BlendFixedPixel(const uint8_t* p00,
+                            const uint8_t* p10,
+                            const uint8_t* p01,
+                            const uint8_t* p11,
+                            int weight_x,
+                            int weight_y,
+                            float* out) {
+  const int channel[3] = {kR, 1, kB};
+  for (int c = 0; c < 3; ++c) {
+    const int k = channel[c];
+    const int top = LerpQ8(p00[k], p10[k], weight_x);
+    const int bottom = LerpQ8(p01[k], p11[k], weight_x);
+    out[c] = static_cast<float>(LerpQ8(top, bottom, weight_y)) * kPixelScale +
+             kPixelOffset;
+  }
+}
+
+// Fixed-point counterpart of SampleBilinear.
+template <int kR, int kB>
+inline void SampleBilinearFixed(const PackedPixelSource<kR, kB>& source,
+                                float sx,
+                                float sy,
+                                float* out) {
+  if (!(sx >= 0.0f && sy >= 0.0f &&
+        sx <= static_cast<float>(source.width - 1) &&
+        sy <= static_cast<float>(source.height - 1))) {
+    out[0] = kPixelOffset;
+    out[1] = kPixelOffset;
+    out[2] = kPixelOffset;
+    return;
+  }
+  const int x0 = static_cast<int>(sx);
+  const int y0 = static_cast<int>(sy);
+  const size_t right = x0 < source.width - 1 ? 4 : 0;
+  const size_t down = y0 < source.height - 1
+                          ? static_cast<size_t>(source.bytes_per_row)
+                          : 0;
+  const uint8_t* top = source.data +
+                       static_cast<size_t>(y0) * source.bytes_per_row +
+                       static_cast<size_t>(x0) * 4;
+  BlendFixedPixel<kR, kB>(top, top + right, top + down, top + down + right,
+                          QuantizeWeightQ8(sx - static_cast<float>(x0)),
+                          QuantizeWeightQ8(sy - static_cast<float>(y0)), out);
+}
+
+// Fixed-point counterpart of SampleBilinearInterior.
+template <int kR, int kB>
+inline void SampleBilinearFixedInterior(const PackedPixelSource<kR, kB>& source,
+                                        float sx,
+                                        float sy,
+                                        float* out) {
+  const int x0 = static_cast<int>(sx);
+  const int y0 = static_cast<int>(sy);
+  const size_t down = static_cast<size_t>(source.bytes_per_row);
+  const uint8_t* top = source.data + static_cast<size_t>(y0) * down +
+                       static_cast<size_t>(x0) * 4;
+  BlendFixedPixel<kR, kB>(top, top + 4, top + down, top + down + 4,
+                          QuantizeWeightQ8(sx - static_cast<float>(x0)),
+                          QuantizeWeightQ8(sy - static_cast<float>(y0)), out);
+}
+
+#if defined(MP_SIMD_SSE2)
+
+namespace simd_internal {
+
+// (a * (256 - w) + b * w + 128) >> 8 on 8 unsigned 16-bit lanes. Every
+// intermediate stays below 2^16.
+inline __m128i LerpQ8x8(__m128i a, __m128i b, __m128i weight) {
+  const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(kFixedWeightOne), weight);
+  const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, inverse),
+                                    _mm_mullo_epi16(b, weight));
+  return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+// Fixed-point blend of 4 packed pixels per tap with Q8 weights held in 32-bit
+// lanes; writes 12 normalized floats.
+template <int kR, int kB>
+inline void BlendFixed4(__m128i q00, __m128i q10, __m128i q01, __m128i q11,
+                        __m128i weight_x, __m128i weight_y, float* out) {
+  using Source = PackedPixelSource<kR, kB>;
+  const __m128i zero = _mm_setzero_si128();
+  // Spread each pixel's weight over its four channels.
+  const __m128i wx = _mm_unpacklo_epi16(_mm_packs_epi32(weight_x, weight_x),
+                                        _mm_packs_epi32(weight_x, weight_x));
+  const __m128i wy = _mm_unpacklo_epi16(_mm_packs_epi32(weight_y, weight_y),
+                                        _mm_packs_epi32(weight_y, weight_y));
+  const __m128i wx_lo = _mm_unpacklo_epi32(wx, wx);
+  const __m128i wx_hi = _mm_unpackhi_epi32(wx, wx);
+  const __m128i wy_lo = _mm_unpacklo_epi32(wy, wy);
+  const __m128i wy_hi = _mm_unpackhi_epi32(wy, wy);
+  const __m128i lo = LerpQ8x8(
+      LerpQ8x8(_mm_unpacklo_epi8(q00, zero), _mm_unpacklo_epi8(q10, zero),
+               wx_lo),
+      LerpQ8x8(_mm_unpacklo_epi8(q01, zero), _mm_unpacklo_epi8(q11, zero),
+               wx_lo),
+      wy_lo);
+  const __m128i hi = LerpQ8x8(
+      LerpQ8x8(_mm_unpackhi_epi8(q00, zero), _mm_unpackhi_epi8(q10, zero),
+               wx_hi),
+      LerpQ8x8(_mm_unpackhi_epi8(q01, zero), _mm_unpackhi_epi8(q11, zero),
+               wx_hi),
+      wy_hi);
+  const __m128i pixels = _mm_packus_epi16(lo, hi);
+  const __m128 scale = _mm_set1_ps(kPixelScale);
+  const __m128 offset = _mm_set1_ps(kPixelOffset);
+  StoreRgb(out,
+           _mm_add_ps(_mm_mul_ps(Channel<Source::kRedShift>(pixels), scale),
+                      offset),
+           _mm_add_ps(_mm_mul_ps(Channel<8>(pixels), scale), offset),
+           _mm_add_ps(_mm_mul_ps(Channel<Source::kBlueShift>(pixels), scale),
+                      offset));
+}
+
+inline __m128i QuantizeWeightQ8x4(__m128 weight) {
+  return _mm_cvttps_epi32(_mm_add_ps(
+      _mm_mul_ps(weight, _mm_set1_ps(static_cast<float>(kFixedWeightOne))),
+      _mm_set1_ps(0.5f)));
+}
+
+}  // namespace simd_internal
+
+template <int kR, int kB>
+inline int BilinearSpanFixed(const PackedPixelSource<kR, kB>& source,
+                             float row_x,
+                             float row_y,
+                             float step_x,
+                             float step_y,
+                             float* out,
+                             int begin,
+                             int end) {
+  return simd_internal::ForEachQuad(
+      row_x, row_y, step_x, step_y, out, begin, end,
+      [&source](__m128i xi, __m128i yi, __m128 dx, __m128 dy, float* dst) {
+        alignas(16) int32_t xs[4];
+        alignas(16) int32_t ys[4];
+        alignas(16) uint32_t p00[4];
+        alignas(16) uint32_t p10[4];
+        alignas(16) uint32_t p01[4];
+        alignas(16) uint32_t p11[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(xs), xi);
+        _mm_store_si128(reinterpret_cast<__m128i*>(ys), yi);
+        simd_internal::GatherPackedTaps<kR, kB, 4>(source, xs, ys, p00, p10,
+                                                   p01, p11);
+        simd_internal::BlendFixed4<kR, kB>(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(p00)),
+            _mm_load_si128(reinterpret_cast<const __m128i*>(p10)),
+            _mm_load_si128(reinterpret_cast<const __m128i*>(p01)),
+            _mm_load_si128(reinterpret_cast<const __m128i*>(p11)),
+            simd_internal::QuantizeWeightQ8x4(dx),
+            simd_internal::QuantizeWeightQ8x4(dy), dst);
+      });
+}
+
+#elif defined(MP_SIMD_NEON)
+
+namespace simd_internal {
+
+// (a * (256 - w) + b * w + 128) >> 8 on 8 unsigned 16-bit lanes. Every
+// intermediate stays below 2^16.
+inline uint16x8_t LerpQ8x8(uint16x8_t a, uint16x8_t b, uint16x8_t weight) {
+  const uint16x8_t inverse = vsubq_u16(vdupq_n_u16(kFixedWeightOne), weight);
+  return vrshrq_n_u16(vmlaq_u16(vmulq_u16(a, inverse), b, weight), 8);
+}
+
+// Fixed-point blend of 4 packed pixels per tap with Q8 weights held in 32-bit
+// lanes; writes 12 normalized floats.
+template <int kR, int kB>
+inline void BlendFixed4(uint32x4_t q00, uint32x4_t q10, uint32x4_t q01,
+                        uint32x4_t q11, uint32x4_t weight_x,
+                        uint32x4_t weight_y, float* out) {
+  using Source = PackedPixelSource<kR, kB>;
+  // Spread each pixel's weight over its four channels.
+  const uint16x4_t wx4 = vmovn_u32(weight_x);
+  const uint16x4_t wy4 = vmovn_u32(weight_y);
+  const uint16x4x2_t wx2 = vzip_u16(wx4, wx4);
+  const uint16x4x2_t wy2 = vzip_u16(wy4, wy4);
+  const uint16x8_t wx_lo =
+      vcombine_u16(vzip_u16(wx2.val[0], wx2.val[0]).val[0],
+                   vzip_u16(wx2.val[0], wx2.val[0]).val[1]);
+  const uint16x8_t wx_hi =
+      vcombine_u16(vzip_u16(wx2.val[1], wx2.val[1]).val[0],
+                   vzip_u16(wx2.val[1], wx2.val[1]).val[1]);
+  const uint16x8_t wy_lo =
+      vcombine_u16(vzip_u16(wy2.val[0], wy2.val[0]).val[0],
+                   vzip_u16(wy2.val[0], wy2.val[0]).val[1]);
+  const uint16x8_t wy_hi =
+      vcombine_u16(vzip_u16(wy2.val[1], wy2.val[1]).val[0],
+                   vzip_u16(wy2.val[1], wy2.val[1]).val[1]);
+  const uint8x16_t b00 = vreinterpretq_u8_u32(q00);
+  const uint8x16_t b10 = vreinterpretq_u8_u32(q10);
+  const uint8x16_t b01 = vreinterpretq_u8_u32(q01);
+  const uint8x16_t b11 = vreinterpretq_u8_u32(q11);
+  const uint16x8_t lo = LerpQ8x8(
+      LerpQ8x8(vmovl_u8(vget_low_u8(b00)), vmovl_u8(vget_low_u8(b10)), wx_lo),
+      LerpQ8x8(vmovl_u8(vget_low_u8(b01)), vmovl_u8(vget_low_u8(b11)), wx_lo),
+      wy_lo);
+  const uint16x8_t hi = LerpQ8x8(
+      LerpQ8x8(vmovl_u8(vget_high_u8(b00)), vmovl_u8(vget_high_u8(b10)),
+               wx_hi),
+      LerpQ8x8(vmovl_u8(vget_high_u8(b01)), vmovl_u8(vget_high_u8(b11)),
+               wx_hi),
+      wy_hi);
+  const uint32x4_t pixels =
+      vreinterpretq_u32_u8(vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+  const float32x4_t offset = vdupq_n_f32(kPixelOffset);
+  StoreRgb(out,
+           vaddq_f32(vmulq_n_f32(Channel<Source::kRedShift>(pixels),
+                                 kPixelScale),
+                     offset),
+           vaddq_f32(vmulq_n_f32(Channel<8>(pixels), kPixelScale), offset),
+           vaddq_f32(vmulq_n_f32(Channel<Source::kBlueShift>(pixels),
+                                 kPixelScale),
+                     offset));
+}
+
+inline uint32x4_t QuantizeWeightQ8x4(float32x4_t weight) {
+  return vcvtq_u32_f32(
+      vaddq_f32(vmulq_n_f32(weight, static_cast<float>(kFixedWeightOne)),
+                vdupq_n_f32(0.5f)));
+}
+
+}  // namespace simd_internal
+
+template <int kR, int kB>
+inline int BilinearSpanFixed(const PackedPixelSource<kR, kB>& source,
+                             float row_x,
+                             float row_y,
+                             float step_x,
+                             float step_y,
+                             float* out,
+                             int begin,
+                             int end) {
+  return simd_internal::ForEachQuad(
+      row_x, row_y, step_x, step_y, out, begin, end,
+      [&source](int32x4_t xi, int32x4_t yi, float32x4_t dx, float32x4_t dy,
+                float* dst) {
+        int32_t xs[4];
+        int32_t ys[4];
+        uint32_t p00[4];
+        uint32_t p10[4];
+        uint32_t p01[4];
+        uint32_t p11[4];
+        vst1q_s32(xs, xi);
+        vst1q_s32(ys, yi);
+        simd_internal::GatherPackedTaps<kR, kB, 4>(source, xs, ys, p00, p10,
+                                                   p01, p11);
+        simd_internal::BlendFixed4<kR, kB>(
+            vld1q_u32(p00), vld1q_u32(p10), vld1q_u32(p01), vld1q_u32(p11),
+            simd_internal::QuantizeWeightQ8x4(dx),
+            simd_internal::QuantizeWeightQ8x4(dy), dst);
+      });
+}
+
+#else
+
+template <int kR, int kB>
+inline int BilinearSpanFixed(const PackedPixelSource<kR, kB>&,
+                             float,
+                             float,
+                             float,
+                             float,
+                             float*,
+                             int begin,
+                             int) {
+  return begin;
+}
+
+#endif  // MP_SIMD_SSE2 / MP_SIMD_NEON
+
+// Fixed-point counterpart of WarpBilinear.
+template <int kR, int kB>
+void WarpBilinearFixed(const PackedPixelSource<kR, kB>& source,
+                       const WarpTransform& m,
+                       float* dst,
+                       int dst_width,
+                       int row_begin,
+                       int row_end) {
+  const int tile = WarpTileWidth(m, dst_width);
+  for (int x_begin = 0; x_begin < dst_width; x_begin += tile) {
+    const int count = std::min(tile, dst_width - x_begin);
+    const float tile_x = m.xx * static_cast<float>(x_begin);
+    const float tile_y = m.yx * static_cast<float>(x_begin);
+    for (int y = row_begin; y < row_end; ++y) {
+      float* out =
+          dst + (static_cast<size_t>(y) * dst_width + x_begin) * 3;
+      const float row_x = m.xy * static_cast<float>(y) + tile_x + m.xt;
+      const float row_y = m.yy * static_cast<float>(y) + tile_y + m.yt;
+      const RowSpan interior = RowInteriorSpan(
+          row_x, row_y, m.xx, m.yx, count, source.width, source.height, 2);
+      int x = 0;
+      for (; x < interior.begin; ++x) {
+        SampleBilinearFixed(source, m.xx * static_cast<float>(x) + row_x,
+                            m.yx * static_cast<float>(x) + row_y,
+                            out + x * 3);
+      }
+      x = BilinearSpanFixed(source, row_x, row_y, m.xx, m.yx, out, x,
+                            interior.end);
+      for (; x < interior.end; ++x) {
+        SampleBilinearFixedInterior(
+            source, m.xx * static_cast<float>(x) + row_x,
+            m.yx * static_cast<float>(x) + row_y, out + x * 3);
+      }
+      for (; x < count; ++x) {
+        SampleBilinearFixed(source, m.xx * static_cast<float>(x) + row_x,
+                            m.yx * static_cast<float>(x) + row_y,
+                            out + x * 3);
+      }
+    }
+  }
+}
+
+}  // namespace mp
+
+#endif  // FIXED_POINT_WARP_H_
@@ -0,0 +1,355 @@
+#ifndef IMAGE_WARP_H_
+#define IMAGE_WARP_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "yuv_simd.h"
+
+namespace mp {
+
+struct RectInPixels {
+  float center_x = 0.0f;
+  float center_y = 0.0f;
+  float width = 0.0f;
+  float height = 0.0f;
+  float rotation = 0.0f;
+};
+
+// Affine map from an output tensor pixel index (x, y) to raw source pixel
+// coordinates:
+//   source_x = xx * x + xy * y + xt
+//   source_y = yx * x + yy * y + yt
+// ROI rotation, camera rotation and mirroring are all folded into it, so the
+// sampling loops never branch on them.
+struct WarpTransform {
+  float xx = 1.0f;
+  float xy = 0.0f;
+  float xt = 0.0f;
+  float yx = 0.0f;
+  float yy = 1.0f;
+  float yt = 0.0f;
+};
+
+// Returns `outer(inner(p))`.
+inline WarpTransform Compose(const WarpTransform& outer,
+                             const WarpTransform& inner) {
+  WarpTransform out;
+  out.xx = outer.xx * inner.xx + outer.xy * inner.yx;
+  out.xy = outer.xx * inner.xy + outer.xy * inner.yy;
+  out.xt = outer.xx * inner.xt + outer.xy * inner.yt + outer.xt;
+  out.yx = outer.yx * inner.xx + outer.yy * inner.yx;
+  out.yy = outer.yx * inner.xy + outer.yy * inner.yy;
+  out.yt = outer.yx * inner.xt + outer.yy * inner.yt + outer.yt;
+  return out;
+}
+
+// Maps logical (rotated, optionally mirrored) pixel coordinates back to the
+// raw buffer. `rotation_degrees` must be one of 0, 90, 180, 270.
+inline WarpTransform OrientationTransform(int rotation_degrees,
+                                          bool mirror_horizontal,
+                                          int raw_width,
+                                          int raw_height) {
+  const int logical_width =
+      (rotation_degrees == 90 || rotation_degrees == 270) ? raw_height
+                                                          : raw_width;
+  WarpTransform mirror;
+  if (mirror_horizontal) {
+    mirror.xx = -1.0f;
+    mirror.xt = static_cast<float>(logical_width - 1);
+  }
+  WarpTransform rotate;
+  const float last_x = static_cast<float>(raw_width - 1);
+  const float last_y = static_cast<float>(raw_height - 1);
+  switch (rotation_degrees) {
+    case 90:
+      rotate = {0.0f, 1.0f, 0.0f, -1.0f, 0.0f, last_y};
+      break;
+    case 180:
+      rotate = {-1.0f, 0.0f, last_x, 0.0f, -1.0f, last_y};
+      break;
+    case 270:
+      rotate = {0.0f, -1.0f, last_x, 1.0f, 0.0f, 0.0f};
+      break;
+    case 0:
+    default:
+      break;
+  }
+  return Compose(rotate, mirror);
+}
+
+// Builds the full output -> raw source transform for `roi`, which is given in
+// logical pixel coordinates.
+inline WarpTransform MakeWarpTransform(const RectInPixels& roi,
+                                       int target_width,
+                                       int target_height,
+                                       int rotation_degrees,
+                                       bool mirror_horizontal,
+                                       int raw_width,
+                                       int raw_height) {
+  const float cos_r = std::cos(roi.rotation);
+  const float sin_r = std::sin(roi.rotation);
+  const float step_x = roi.width / static_cast<float>(target_width);
+  const float step_y = roi.height / static_cast<float>(target_height);
+  // Offsets of output pixel (0, 0)'s center from the ROI center.
+  const float origin_x = step_x * 0.5f - roi.width * 0.5f;
+  const float origin_y = step_y * 0.5f - roi.height * 0.5f;
+
+  WarpTransform logical;
+  logical.xx = cos_r * step_x;
+  logical.xy = -sin_r * step_y;
+  logical.xt = cos_r * origin_x - sin_r * origin_y + roi.center_x;
+  logical.yx = sin_r * step_x;
+  logical.yy = cos_r * step_y;
+  logical.yt = sin_r * origin_x + cos_r * origin_y + roi.center_y;
+  return Compose(OrientationTransform(rotation_degrees, mirror_horizontal,
+                                      raw_width, raw_height),
+                 logical);
+}
+
+// Raw-space bounding box of the corner positions a warp samples.
+struct SourceBounds {
+  float min_x = 0.0f;
+  float min_y = 0.0f;
+  float max_x = 0.0f;
+  float max_y = 0.0f;
+};
+
+inline SourceBounds WarpSourceBounds(const WarpTransform& m,
+                                     int target_width,
+                                     int target_height) {
+  const float last_x = static_cast<float>(target_width - 1);
+  const float last_y = static_cast<float>(target_height - 1);
+  const float corner_x[4] = {0.0f, last_x, 0.0f, last_x};
+  const float corner_y[4] = {0.0f, 0.0f, last_y, last_y};
+  SourceBounds bounds;
+  bounds.min_x = INFINITY;
+  bounds.min_y = INFINITY;
+  bounds.max_x = -INFINITY;
+  bounds.max_y = -INFINITY;
+  for (int i = 0; i < 4; ++i) {
+    const float sx = m.xx * corner_x[i] + m.xy * corner_y[i] + m.xt;
+    const float sy = m.yx * corner_x[i] + m.yy * corner_y[i] + m.yt;
+    bounds.min_x = std::min(bounds.min_x, sx);
+    bounds.max_x = std::max(bounds.max_x, sx);
+    bounds.min_y = std::min(bounds.min_y, sy);
+    bounds.max_y = std::max(bounds.max_y, sy);
+  }
+  return bounds;
+}
+
+// Source pixels per output pixel along the denser output axis.
+inline float WarpScale(const WarpTransform& m) {
+  return std::min(std::hypot(m.xx, m.yx), std::hypot(m.xy, m.yy));
+}
+
+// Resampling filter for the crop. kBilinear box-reduces the ROI (RoiPyramid,
+// YuvRoiStager) only once bilinear taps would start skipping source pixels;
+// kArea reduces until the warp samples 1-2 source pixels per output pixel;
+// kNearest reads a single tap per output pixel and never reduces.
+enum class Interpolation { kNearest, kBilinear, kArea };
+
+// Source pixels per output pixel from which `interpolation` box-reduces the
+// ROI before warping.
+inline float ReductionScale(Interpolation interpolation) {
+  switch (interpolation) {
+    case Interpolation::kNearest:
+      return INFINITY;
+    case Interpolation::kArea:
+      return 2.0f;
+    case Interpolation::kBilinear:
+    default:
+      return 4.0f;
+  }
+}
+
+// Automatic choice from the ROI-to-input scale: nearest while the ROI is
+// within kAutoNearestScale of the model input size, where it loses little,
+// area once it covers at least kAutoAreaScale source pixels per output pixel,
+// and bilinear in between and when upsampling.
+constexpr float kAutoNearestScale = 1.25f;
+constexpr float kAutoAreaScale = 2.0f;
+
+inline Interpolation AutoInterpolation(const WarpTransform& m) {
+  const float scale = WarpScale(m);
+  if (scale >= kAutoAreaScale) {
+    return Interpolation::kArea;
+  }
+  if (scale >= 1.0f / kAutoNearestScale && scale <= kAutoNearestScale) {
+    return Interpolation::kNearest;
+  }
+  return Interpolation::kBilinear;
+}
+
+// Output columns per tile when output rows walk down source columns.
+constexpr int kWarpTileWidth = 32;
+
+// Width of the column tiles a warp over `m` walks the output in. When an
+// output row advances mostly along source y (90/270 camera rotation, steep
+// ROI angles) every tap lands on a different source line; narrow tiles keep
+// the lines one row pulls in resident for the next row, which samples the
+// neighbouring source column. Other transforms use whole rows.
+inline int WarpTileWidth(const WarpTransform& m, int dst_width) {
+  return std::fabs(m.yx) > std::fabs(m.xx) ? std::min(dst_width, kWarpTileWidth)
+                                           : dst_width;
+}
+
+// Output pixels [begin, end) of one row.
+struct RowSpan {
+  int begin = 0;
+  int end = 0;
+};
+
+// Pixels of a `count`-pixel output row, sampled at (row_x + step_x * x,
+// row_y + step_y * x), whose taps all lie inside a `width` x `height`
+// source, for kernels reading `taps` x `taps` pixels from the truncated
+// position (2 for bilinear, 1 for nearest). Positions are kept at most
+// (width - taps, height - taps) so the vector kernels, which recompute them
+// with possibly different rounding, can never step past the last pixel.
+// Pixels outside the span go through the guarded samplers.
+inline RowSpan RowInteriorSpan(float row_x,
+                               float row_y,
+                               float step_x,
+                               float step_y,
+                               int count,
+                               int width,
+                               int height,
+                               int taps) {
+  RowSpan span;
+  if (count <= 0 || width < taps || height < taps) {
+    return span;
+  }
+  const float max_x = static_cast<float>(width - taps);
+  const float max_y = static_cast<float>(height - taps);
+  const auto inside = [&](int x) {
+    const float sx = step_x * static_cast<float>(x) + row_x;
+    const float sy = step_y * static_cast<float>(x) + row_y;
+    return sx >= 0.0f && sy >= 0.0f && sx <= max_x && sy <= max_y;
+  };
+  // Solve 0 <= start + step * x <= limit on each axis, then settle the ends
+  // against the exact per-pixel positions. Both coordinates are monotonic
+  // in x, so checking the two ends covers the whole span.
+  double lo = 0.0;
+  double hi = static_cast<double>(count - 1);
+  const auto clip = [&](float start, float step, float limit) {
+    if (step == 0.0f) {
+      if (!(start >= 0.0f && start <= limit)) {
+        hi = -1.0;
+      }
+      return;
+    }
+    const double a = -static_cast<double>(start) / step;
+    const double b = (static_cast<double>(limit) - start) / step;
+    lo = std::max(lo, std::min(a, b));
+    hi = std::min(hi, std::max(a, b));
+  };
+  clip(row_x, step_x, max_x);
+  clip(row_y, step_y, max_y);
+  if (!(lo <= hi)) {
+    return span;
+  }
+  span.begin = static_cast<int>(std::ceil(lo));
+  span.end = static_cast<int>(std::floor(hi)) + 1;
+  while (span.begin < span.end && !inside(span.begin)) {
+    ++span.begin;
+  }
+  while (span.end > span.begin && !inside(span.end - 1)) {
+    --span.end;
+  }
+  if (span.begin == span.end) {
+    span = RowSpan();
+  }
+  return span;
+}
+
+// Bilinear warp of `source` into rows [row_begin, row_end) of an interleaved
+// RGB float tensor that is `dst_width` pixels wide. Samples that fall outside
+// the source are written as black. `isa` picks the vector kernels.
+template <typename Source>
+void WarpBilinear(const Source& source,
+                  const WarpTransform& m,
+                  float* dst,
+                  int dst_width,
+                  int row_begin,
+                  int row_end,
+                  KernelIsa isa = kBaselineKernelIsa) {
+  const int tile = WarpTileWidth(m, dst_width);
+  for (int x_begin = 0; x_begin < dst_width; x_begin += tile) {
+    const int count = std::min(tile, dst_width - x_begin);
+    const float tile_x = m.xx * static_cast<float>(x_begin);
+    const float tile_y = m.yx * static_cast<float>(x_begin);
+    for (int y = row_begin; y < row_end; ++y) {
+      float* out =
+          dst + (static_cast<size_t>(y) * dst_width + x_begin) * 3;
+      const float row_x = m.xy * static_cast<float>(y) + tile_x + m.xt;
+      const float row_y = m.yy * static_cast<float>(y) + tile_y + m.yt;
+      const RowSpan interior = RowInteriorSpan(
+          row_x, row_y, m.xx, m.yx, count, source.width, source.height, 2);
+      int x = 0;
+      for (; x < interior.begin; ++x) {
+        SampleBilinear(source, m.xx * static_cast<float>(x) + row_x,
+                       m.yx * static_cast<float>(x) + row_y, out + x * 3);
+      }
+      if (isa == KernelIsa::kAvx2) {
+        x = BilinearSpanAvx2(source, row_x, row_y, m.xx, m.yx, out, x,
+                             interior.end);
+      }
+      x = BilinearSpan(source, row_x, row_y, m.xx, m.yx, out, x,
+                       interior.end);
+      for (; x < interior.end; ++x) {
+        SampleBilinearInterior(source, m.xx * static_cast<float>(x) + row_x,
+                               m.yx * static_cast<float>(x) + row_y,
+                               out + x * 3);
+      }
+      for (; x < count; ++x) {
+        SampleBilinear(source, m.xx * static_cast<float>(x) + row_x,
+                       m.yx * static_cast<float>(x) + row_y, out + x * 3);
+      }
+    }
+  }
+}
+
+// Nearest-neighbour counterpart of WarpBilinear: each output pixel reads the
+// source pixel its position rounds to. Covers the same positions as the
+// bilinear warp; everything else is black.
+template <typename Source>
+void WarpNearest(const Source& source,
+                 const WarpTransform& m,
+                 float* dst,
+                 int dst_width,
+                 int row_begin,
+                 int row_end) {
+  const int tile = WarpTileWidth(m, dst_width);
+  for (int x_begin = 0; x_begin < dst_width; x_begin += tile) {
+    const int count = std::min(tile, dst_width - x_begin);
+    const float tile_x = m.xx * static_cast<float>(x_begin);
+    const float tile_y = m.yx * static_cast<float>(x_begin);
+    for (int y = row_begin; y < row_end; ++y) {
+      float* out =
+          dst + (static_cast<size_t>(y) * dst_width + x_begin) * 3;
+      const float row_x = m.xy * static_cast<float>(y) + tile_x + m.xt;
+      const float row_y = m.yy * static_cast<float>(y) + tile_y + m.yt;
+      const RowSpan inside = RowInteriorSpan(
+          row_x, row_y, m.xx, m.yx, count, source.width, source.height, 1);
+      std::fill(out, out + inside.begin * 3, kPixelOffset);
+      // Truncating position + 0.5 rounds to the nearest tap.
+      const float round_x = row_x + 0.5f;
+      const float round_y = row_y + 0.5f;
+      int x = NearestSpan(source, round_x, round_y, m.xx, m.yx, out,
+                          inside.begin, inside.end);
+      for (; x < inside.end; ++x) {
+        SampleNearest(source,
+                      static_cast<int>(m.xx * static_cast<float>(x) + round_x),
+                      static_cast<int>(m.yx * static_cast<float>(x) + round_y),
+                      out + x * 3);
+      }
+      std::fill(out + inside.end * 3, out + count * 3, kPixelOffset);
+    }
+  }
+}
+
+}  // namespace mp
+
+#endif  // IMAGE_WARP_H_
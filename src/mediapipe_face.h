@@ -1,6 +1,7 @@
 #ifndef MEDIAPIPE_FACE_MESH_H_
 #define MEDIAPIPE_FACE_MESH_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #if _WIN32
@@ -14,10 +15,13 @@ extern "C" {
 #endif
 
 typedef struct MpFaceMeshContext MpFaceMeshContext;
+typedef struct MpFaceMeshCreateTask MpFaceMeshCreateTask;
 
 typedef enum {
   MP_PIXEL_FORMAT_RGBA = 0,
   MP_PIXEL_FORMAT_BGRA = 1,
+  // Packed 3-byte pixels; accepted by mp_face_mesh_process_crop only.
+  MP_PIXEL_FORMAT_RGB = 2,
 } MpPixelFormat;
 
 typedef enum {
@@ -26,6 +30,39 @@ typedef enum {
   MP_DELEGATE_GPU_V2 = 2,
 } MpDelegateType;
 
+typedef enum {
+  MP_INTERPOLATION_BILINEAR = 0,
+  MP_INTERPOLATION_NEAREST = 1,
+  MP_INTERPOLATION_AREA = 2,
+  MP_INTERPOLATION_AUTO = 3,
+} MpInterpolation;
+
+// Kernel sets for MpFaceMeshCreateOptions.kernel_isa. x86 builds carry SSE2
+// and AVX2 kernels, ARM builds ARMv8.0 NEON kernels. ARMv8.2 dot-product and
+// fp16 kernels, AVX-512 kernels and a vector landmark transform are not
+// implemented: no kernel does int8 dot products, fp16 would round the 8-bit
+// pixel math, and the 468-point transform is too small to gain from it.
+typedef enum {
+  MP_KERNEL_ISA_AUTO = 0,
+  MP_KERNEL_ISA_BASELINE = 1,
+  MP_KERNEL_ISA_AVX2 = 2,
+} MpKernelIsa;
+
+// Frame layouts mp_face_mesh_warmup can drive: the packed paths of
+// mp_face_mesh_process, or the 4:2:0 paths of mp_face_mesh_process_nv21 /
+// mp_face_mesh_process_yuv with interleaved VU or planar chroma.
+typedef enum {
+  MP_WARMUP_FORMAT_RGBA = 0,
+  MP_WARMUP_FORMAT_BGRA = 1,
+  MP_WARMUP_FORMAT_NV21 = 2,
+  MP_WARMUP_FORMAT_I420 = 3,
+} MpWarmupFormat;
+
+typedef enum {
+  MP_CROP_FORMAT_RGB = 0,
+  MP_CROP_FORMAT_FLOAT = 1,
+} MpCropFormat;
+
 typedef struct {
   const uint8_t* data;
   int32_t width;
@@ -44,6 +81,22 @@ typedef struct {
   int32_t vu_bytes_per_row;
 } MpNv21Image;
 
+// YUV 4:2:0 input with separate plane pointers (Android YUV_420_888, NV21,
+// NV12, I420, YV12). Chroma sample (x / 2, y / 2) is read from
+// u[(y / 2) * uv_bytes_per_row + (x / 2) * uv_pixel_stride], and likewise
+// from v. Interleaved layouts pass pointers into the shared plane with a
+// pixel stride of 2.
+typedef struct {
+  const uint8_t* y;
+  const uint8_t* u;
+  const uint8_t* v;
+  int32_t width;
+  int32_t height;
+  int32_t y_bytes_per_row;
+  int32_t uv_bytes_per_row;
+  int32_t uv_pixel_stride;
+} MpYuvImage;
+
 typedef struct {
   float x_center;
   float y_center;
@@ -67,6 +120,23 @@ typedef struct {
   int32_t image_height;
 } MpFaceMeshResult;
 
+// Face crop the model last ran on, borrowed from the context.
+typedef struct {
+  // MP_CROP_FORMAT_RGB: packed 3-byte RGB. MP_CROP_FORMAT_FLOAT: the model's
+  // NHWC float input, normalized to [-1, 1].
+  const void* data;
+  int32_t width;
+  int32_t height;
+  int32_t bytes_per_row;
+  MpCropFormat format;
+  // Maps crop pixel (x, y) to pixel (transform[0] * x + transform[1] * y +
+  // transform[2], transform[3] * x + transform[4] * y + transform[5]) of the
+  // image_width x image_height logical image landmarks are normalized to.
+  float transform[6];
+  int32_t image_width;
+  int32_t image_height;
+} MpFaceCrop;
+
 typedef struct {
   const char* tflite_library_path;
   int32_t threads;
@@ -75,11 +145,70 @@ typedef struct {
   MpDelegateType delegate;
   uint8_t enable_smoothing;
   uint8_t enable_roi_tracking;
+  // Samples the crop with Q8 integer weights instead of float. Outputs
+  // differ from the float path by at most 2/255 of the input range.
+  uint8_t enable_fixed_point_preprocessing;
+  // Filter used to sample the crop. NEAREST reads one pixel per input value;
+  // AREA box-averages ROIs larger than twice the model input first; AUTO
+  // picks per frame from the ROI scale.
+  MpInterpolation interpolation;
+  // Vector kernels for preprocessing and tensor conversion. AUTO picks the
+  // best set the CPU supports; BASELINE forces the ABI's SSE2/NEON kernels;
+  // AVX2 forces the AVX2 kernels and fails to create on CPUs without AVX2
+  // and F16C. Landmark postprocessing is scalar under every setting. See
+  // mp_face_mesh_kernel_isa.
+  MpKernelIsa kernel_isa;
+  // Existing writable directory for the XNNPACK weight cache, or null. With
+  // MP_DELEGATE_XNNPACK the first run stores the repacked weights there and
+  // later runs map them instead of repacking; the file is keyed by model and
+  // runtime version and rebuilt when either changes. Processes sharing the
+  // directory take turns building it through an advisory file lock.
+  const char* xnnpack_weight_cache_dir;
 } MpFaceMeshCreateOptions;
 
 FFI_PLUGIN_EXPORT MpFaceMeshContext* mp_face_mesh_create(
     const char* model_path, const MpFaceMeshCreateOptions* options);
 
+// Like mp_face_mesh_create, but builds the model from `model_size` bytes at
+// `model_data` instead of a file. The bytes are copied, so the caller may
+// free its buffer once this returns; contexts created from the same bytes
+// share one copy.
+FFI_PLUGIN_EXPORT MpFaceMeshContext* mp_face_mesh_create_from_buffer(
+    const void* model_data,
+    size_t model_size,
+    const MpFaceMeshCreateOptions* options);
+
+// Called on the worker thread once an mp_face_mesh_create_async task has
+// finished, successfully or not.
+typedef void (*MpFaceMeshCreateCallback)(void* user_data);
+
+// Starts mp_face_mesh_create_from_buffer on a native thread and returns at
+// once, so loading the runtime and model, building the delegate and
+// allocating tensors overlap with the caller's own startup (camera, UI).
+// The model bytes and options are copied before this returns. `callback`
+// (may be null) runs on the worker thread when creation ends; collect the
+// result with mp_face_mesh_create_task_wait, which blocks until then.
+// Returns null when the arguments are invalid, see
+// mp_face_mesh_last_global_error.
+FFI_PLUGIN_EXPORT MpFaceMeshCreateTask* mp_face_mesh_create_async(
+    const void* model_data,
+    size_t model_size,
+    const MpFaceMeshCreateOptions* options,
+    MpFaceMeshCreateCallback callback,
+    void* user_data);
+
+// Waits for `task` to finish and hands over its context, which the caller
+// then owns. Returns null when creation failed (or the context was already
+// taken); mp_face_mesh_last_global_error on the calling thread then holds
+// the reason.
+FFI_PLUGIN_EXPORT MpFaceMeshContext* mp_face_mesh_create_task_wait(
+    MpFaceMeshCreateTask* task);
+
+// Releases `task` without waiting. Safe while creation is still running and
+// from inside the callback; a context that was never taken is destroyed.
+FFI_PLUGIN_EXPORT void mp_face_mesh_create_task_destroy(
+    MpFaceMeshCreateTask* task);
+
 FFI_PLUGIN_EXPORT void mp_face_mesh_destroy(MpFaceMeshContext* context);
 
 FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process(
@@ -96,11 +225,108 @@ FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process_nv21(
     int32_t rotation_degrees,
     uint8_t mirror_horizontal);
 
+FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process_yuv(
+    MpFaceMeshContext* context,
+    const MpYuvImage* image,
+    const MpNormalizedRect* override_rect,
+    int32_t rotation_degrees,
+    uint8_t mirror_horizontal);
+
+// mp_face_mesh_process_yuv with the plane pointers passed as arguments; the
+// y/u/v fields of `layout` are ignored. Lets callers hand over buffers they
+// cannot store in a struct, such as Dart typed data in a leaf call, so the
+// planes are read in place instead of being copied first.
+FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process_yuv_planes(
+    MpFaceMeshContext* context,
+    const uint8_t* y,
+    const uint8_t* u,
+    const uint8_t* v,
+    const MpYuvImage* layout,
+    const MpNormalizedRect* override_rect,
+    int32_t rotation_degrees,
+    uint8_t mirror_horizontal);
+
+// Float NHWC input buffer of the model, `*width` x `*height` x 3 values
+// normalized to [-1, 1]. Callers producing their own input can fill it and
+// pass it to mp_face_mesh_process_tensor without a copy. Owned by the
+// context; every process call overwrites it.
+FFI_PLUGIN_EXPORT float* mp_face_mesh_input_tensor(MpFaceMeshContext* context,
+                                                   int32_t* width,
+                                                   int32_t* height);
+
+// Runs the model on an aligned face crop, skipping ROI sampling. `crop` must
+// be RGBA, BGRA or RGB at exactly the model input size (see
+// mp_face_mesh_input_tensor). `crop_rect` is the ROI the crop was cut from,
+// normalized to an `image_width` x `image_height` image; landmarks are mapped
+// back through it as in mp_face_mesh_process. ROI tracking state is neither
+// used nor updated.
+FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process_crop(
+    MpFaceMeshContext* context,
+    const MpImage* crop,
+    const MpNormalizedRect* crop_rect,
+    int32_t image_width,
+    int32_t image_height);
+
+// Like mp_face_mesh_process_crop for an input that is already a normalized
+// float NHWC tensor of the model input size. Passing the buffer returned by
+// mp_face_mesh_input_tensor runs it in place.
+FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process_tensor(
+    MpFaceMeshContext* context,
+    const float* tensor,
+    const MpNormalizedRect* crop_rect,
+    int32_t image_width,
+    int32_t image_height);
+
+// Fills `crop` with the aligned face crop the last process call fed to the
+// model, for reuse by other models on the same face. The data stays valid
+// until the next process call or mp_face_mesh_destroy. Returns 1 on success
+// and 0 when no crop is available, see mp_face_mesh_last_error.
+FFI_PLUGIN_EXPORT int32_t mp_face_mesh_last_crop(MpFaceMeshContext* context,
+                                                 MpCropFormat format,
+                                                 MpFaceCrop* crop);
+
+// Runs `iterations` full process calls (preprocess, invoke, postprocess) on a
+// synthetic `format` frame so the first real frame does not pay for lazy
+// allocation and cold caches. Pass the layout the camera delivers, since each
+// one has its own conversion and staging buffers. Half of the calls use a
+// rotated ROI and half an unrotated one, covering both warp paths. ROI
+// tracking state is left as it was; the last crop is cleared. When
+// `timings_ms` is not null it receives each call's wall time in milliseconds,
+// one per iteration, to show when latency has settled. Returns the number of
+// iterations run; fewer than requested means one failed, see
+// mp_face_mesh_last_error.
+FFI_PLUGIN_EXPORT int32_t mp_face_mesh_warmup(MpFaceMeshContext* context,
+                                              int32_t iterations,
+                                              MpWarmupFormat format,
+                                              float* timings_ms);
+
+// Converts a YUV 4:2:0 frame (NV21, NV12, I420, YUV_420_888) to packed RGBA
+// (alpha 255) in `dst`, for display. The frame is box-downscaled by
+// `downscale` (1, 2, 4, 8 or 16) to ceil(width / downscale) x
+// ceil(height / downscale), then rotated and mirrored the same way
+// mp_face_mesh_process_yuv interprets `rotation_degrees` /
+// `mirror_horizontal`, so 90 and 270 swap the output width and height.
+// `dst` holds `dst_height` rows of `dst_bytes_per_row` bytes, which must
+// cover that output size. Needs no context. Returns 1 on success and 0 on
+// invalid arguments, see mp_face_mesh_last_global_error.
+FFI_PLUGIN_EXPORT int32_t mp_convert_yuv_to_rgba(const MpYuvImage* image,
+                                                 int32_t rotation_degrees,
+                                                 uint8_t mirror_horizontal,
+                                                 int32_t downscale,
+                                                 uint8_t* dst,
+                                                 int32_t dst_bytes_per_row,
+                                                 int32_t dst_height);
+
 FFI_PLUGIN_EXPORT void mp_face_mesh_release_result(MpFaceMeshResult* result);
 
 FFI_PLUGIN_EXPORT const char* mp_face_mesh_last_error(
     const MpFaceMeshContext* context);
 
+// Name of the kernel set the context runs: "avx2", "sse2", "neon" or
+// "scalar". Owned by the context.
+FFI_PLUGIN_EXPORT const char* mp_face_mesh_kernel_isa(
+    const MpFaceMeshContext* context);
+
 FFI_PLUGIN_EXPORT const char* mp_face_mesh_last_global_error(void);
 
 #ifdef __cplusplus
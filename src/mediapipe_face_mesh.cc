@@ -1,6 +1,8 @@
 #include "mediapipe_face.h"
 
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -24,10 +26,23 @@
 #include "tensorflow/lite/delegates/gpu/delegate.h"
 #include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
+#include "cpu_features.h"
+#include "image_warp.h"
+#include "roi_pyramid.h"
+#include "roi_staging.h"
+#include "row_worker_pool.h"
+#include "separable_resize.h"
+#include "tensor_io.h"
+#include "warp_plan.h"
+#include "yuv_convert.h"
 #include "tflite_runtime.h"
+#include "tflite_registry.h"
+#include "xnnpack_weight_cache.h"
 
 #if defined(__ANDROID__)
 #include <android/log.h>
@@ -41,28 +56,12 @@
 
 namespace {
 
-struct RectInPixels {
-  float center_x = 0.0f;
-  float center_y = 0.0f;
-  float width = 0.0f;
-  float height = 0.0f;
-  float rotation = 0.0f;
-};
-
-struct RgbPixel {
-  float r = 0.0f;
-  float g = 0.0f;
-  float b = 0.0f;
-};
+using mp::RectInPixels;
 
 float Clamp(float value, float min_value, float max_value) {
   return std::max(min_value, std::min(max_value, value));
 }
 
-int ClampInt(int value, int min_value, int max_value) {
-  return std::max(min_value, std::min(max_value, value));
-}
-
 float NormalizeAngle(float radians) {
   constexpr float kPi = 3.14159265358979323846f;
   constexpr float kTwoPi = kPi * 2.0f;
@@ -83,6 +82,39 @@ class FaceMeshContext {
 
   bool Initialize(const std::string& model_path,
                   const MpFaceMeshCreateOptions* options) {
+    return InitializeWithModel(
+        model_path, options, [&](std::string* error) {
+          return TfLiteRegistry::Get().AcquireModelFromFile(
+              runtime_, model_path, error);
+        });
+  }
+
+  /// Builds the model from a copy of `model_data`, so the caller may release
+  /// its buffer as soon as this returns.
+  bool Initialize(const void* model_data,
+                  size_t model_size,
+                  const MpFaceMeshCreateOptions* options) {
+    const auto* bytes = static_cast<const uint8_t*>(model_data);
+    return Initialize(std::vector<uint8_t>(bytes, bytes + model_size),
+                      options);
+  }
+
+  bool Initialize(std::vector<uint8_t> model_bytes,
+                  const MpFaceMeshCreateOptions* options) {
+    return InitializeWithModel(
+        std::to_string(model_bytes.size()) + "-byte buffer", options,
+        [&](std::string* error) {
+          return TfLiteRegistry::Get().AcquireModel(
+              runtime_, std::move(model_bytes), error);
+        });
+  }
+
+  /// Shared by both Initialize overloads. `acquire_model` runs once the
+  /// runtime is loaded and returns the shared model or null with `error` set.
+  template <typename AcquireModelFn>
+  bool InitializeWithModel(const std::string& model_name,
+                           const MpFaceMeshCreateOptions* options,
+                           const AcquireModelFn& acquire_model) {
     threads_ = 2;
     if (options && options->threads > 0) {
       threads_ = options->threads;
@@ -97,32 +129,66 @@ class FaceMeshContext {
             : 0.5f;
     smoothing_enabled_ = !options || options->enable_smoothing != 0;
     roi_tracking_enabled_ = !options || options->enable_roi_tracking != 0;
+    fixed_point_preprocessing_ =
+        options && options->enable_fixed_point_preprocessing != 0;
+    interpolation_ = options ? static_cast<MpInterpolation>(
+                                   options->interpolation)
+                             : MP_INTERPOLATION_BILINEAR;
+    if (interpolation_ < MP_INTERPOLATION_BILINEAR ||
+        interpolation_ > MP_INTERPOLATION_AUTO) {
+      SetError("Unknown interpolation mode.");
+      return false;
+    }
+    switch (options ? options->kernel_isa : MP_KERNEL_ISA_AUTO) {
+      case MP_KERNEL_ISA_AUTO:
+        kernel_isa_ = mp::DetectKernelIsa();
+        break;
+      case MP_KERNEL_ISA_AVX2:
+        if (!mp::CpuSupportsAvx2()) {
+          SetError("AVX2 kernels are not supported on this CPU.");
+          return false;
+        }
+        kernel_isa_ = mp::KernelIsa::kAvx2;
+        break;
+      case MP_KERNEL_ISA_BASELINE:
+        kernel_isa_ = mp::kBaselineKernelIsa;
+        break;
+      default:
+        SetError("Unknown kernel ISA.");
+        return false;
+    }
 
-    MP_LOGI("Initialize start: model=%s threads=%d\n", model_path.c_str(),
-            threads_);
+    MP_LOGI("Initialize start: model=%s threads=%d kernels=%s\n",
+            model_name.c_str(), threads_, mp::KernelIsaName(kernel_isa_));
 
     const char* runtime_path =
         (options && options->tflite_library_path)
             ? options->tflite_library_path
             : nullptr;
 
-    if (!runtime_.Load(runtime_path)) {
-      SetError("Failed to load TensorFlow Lite runtime: " + runtime_.error());
+    // The runtime and the model are shared with every other context in the
+    // process that uses the same library and model content.
+    std::string error;
+    runtime_ = TfLiteRegistry::Get().AcquireRuntime(runtime_path, &error);
+    if (!runtime_) {
+      SetError("Failed to load TensorFlow Lite runtime: " + error);
       return false;
     }
+    options_.get_deleter().runtime = runtime_.get();
+    interpreter_.get_deleter().runtime = runtime_.get();
 
-    model_.reset(runtime_.ModelCreateFromFile(model_path.c_str()));
+    model_ = acquire_model(&error);
     if (!model_) {
-      SetError("Unable to load model file: " + model_path);
+      SetError("Unable to load model: " + model_name + " (" + error + ")");
       return false;
     }
 
-    options_.reset(runtime_.InterpreterOptionsCreate());
+    options_.reset(runtime_->InterpreterOptionsCreate());
     if (!options_) {
       SetError("Failed to allocate interpreter options.");
       return false;
     }
-    runtime_.InterpreterOptionsSetThreads(options_.get(), threads_);
+    runtime_->InterpreterOptionsSetThreads(options_.get(), threads_);
 
     const MpDelegateType delegate_choice =
         options ? static_cast<MpDelegateType>(options->delegate)
@@ -135,7 +201,7 @@ class FaceMeshContext {
       }
       delegate_.get_deleter().deleter = deleter;
       delegate_.reset(created);
-      runtime_.InterpreterOptionsAddDelegate(
+      runtime_->InterpreterOptionsAddDelegate(
           options_.get(),
           reinterpret_cast<TfLiteOpaqueDelegate*>(delegate_.get()));
       MP_LOGI("%s delegate enabled.\n", name);
@@ -143,36 +209,50 @@ class FaceMeshContext {
     };
     switch (delegate_choice) {
       case MP_DELEGATE_XNNPACK: {
-        if (!runtime_.InterpreterOptionsAddDelegate ||
-            !runtime_.XnnpackDelegateOptionsDefault ||
-            !runtime_.XnnpackDelegateCreate || !runtime_.XnnpackDelegateDelete) {
+        if (!runtime_->InterpreterOptionsAddDelegate ||
+            !runtime_->XnnpackDelegateOptionsDefault ||
+            !runtime_->XnnpackDelegateCreate || !runtime_->XnnpackDelegateDelete) {
           MP_LOGI("XNNPACK delegate requested but not available in runtime.\n");
           break;
         }
         TfLiteXNNPackDelegateOptions xnnpack_options =
-            runtime_.XnnpackDelegateOptionsDefault();
+            runtime_->XnnpackDelegateOptionsDefault();
         xnnpack_options.num_threads = threads_;
+        const char* cache_dir = options && options->xnnpack_weight_cache_dir
+                                    ? options->xnnpack_weight_cache_dir
+                                    : "";
+        if (weight_cache_.Open(cache_dir, model_->hash, model_->size,
+                               runtime_->Version ? runtime_->Version()
+                                                 : nullptr)) {
+          xnnpack_options.weight_cache_file_path = weight_cache_.path();
+          MP_LOGI("XNNPACK weight cache %s: %s\n",
+                  weight_cache_.built() ? "found" : "building",
+                  weight_cache_.path());
+        } else if (cache_dir[0] != '\0') {
+          MP_LOGE("XNNPACK weight cache unavailable in %s.\n", cache_dir);
+        }
         TfLiteDelegate* created_delegate =
-            runtime_.XnnpackDelegateCreate(&xnnpack_options);
-        if (!AttachDelegate(created_delegate, runtime_.XnnpackDelegateDelete,
+            runtime_->XnnpackDelegateCreate(&xnnpack_options);
+        if (!AttachDelegate(created_delegate, runtime_->XnnpackDelegateDelete,
                             "XNNPACK")) {
+          weight_cache_.Close();
           MP_LOGE("Failed to create XNNPACK delegate. Falling back to CPU.\n");
         }
         break;
       }
       case MP_DELEGATE_GPU_V2: {
-        if (!runtime_.InterpreterOptionsAddDelegate ||
-            !runtime_.GpuDelegateV2OptionsDefault ||
-            !runtime_.GpuDelegateV2Create || !runtime_.GpuDelegateV2Delete) {
+        if (!runtime_->InterpreterOptionsAddDelegate ||
+            !runtime_->GpuDelegateV2OptionsDefault ||
+            !runtime_->GpuDelegateV2Create || !runtime_->GpuDelegateV2Delete) {
           MP_LOGI("GPU delegate (V2) requested but not available in runtime.\n");
           break;
         }
         TfLiteGpuDelegateOptionsV2 gpu_options =
-            runtime_.GpuDelegateV2OptionsDefault();
+            runtime_->GpuDelegateV2OptionsDefault();
         gpu_options.experimental_flags |= TFLITE_GPU_EXPERIMENTAL_FLAGS_ENABLE_QUANT;
         TfLiteDelegate* created_delegate =
-            runtime_.GpuDelegateV2Create(&gpu_options);
-        if (!AttachDelegate(created_delegate, runtime_.GpuDelegateV2Delete,
+            runtime_->GpuDelegateV2Create(&gpu_options);
+        if (!AttachDelegate(created_delegate, runtime_->GpuDelegateV2Delete,
                             "GPU V2")) {
           MP_LOGE("Failed to create GPU delegate. Falling back to CPU.\n");
         }
@@ -183,81 +263,121 @@ class FaceMeshContext {
         break;
     }
 
-    interpreter_.reset(runtime_.InterpreterCreate(model_.get(), options_.get()));
+    interpreter_.reset(
+        runtime_->InterpreterCreate(model_->model, options_.get()));
     if (!interpreter_) {
       SetError("Failed to create interpreter.");
       return false;
     }
 
-    if (runtime_.InterpreterAllocateTensors(interpreter_.get()) != kTfLiteOk) {
+    if (runtime_->InterpreterAllocateTensors(interpreter_.get()) != kTfLiteOk) {
       SetError("Tensor allocation failed.");
       return false;
     }
 
-    if (runtime_.InterpreterGetInputTensorCount(interpreter_.get()) < 1) {
+    if (runtime_->InterpreterGetInputTensorCount(interpreter_.get()) < 1) {
       SetError("Interpreter input tensor missing.");
       return false;
     }
-    input_tensor_ = runtime_.InterpreterGetInputTensor(interpreter_.get(), 0);
+    input_tensor_ = runtime_->InterpreterGetInputTensor(interpreter_.get(), 0);
     if (!input_tensor_) {
       SetError("Input tensor unavailable.");
       return false;
     }
-    if (runtime_.TensorType(input_tensor_) != kTfLiteFloat32) {
-      SetError("Model input must be float32.");
+    if (!ReadTensorEncoding(input_tensor_, &input_encoding_)) {
+      SetError("Model input must be float32, float16, uint8 or int8.");
       return false;
     }
-    if (runtime_.TensorNumDims(input_tensor_) != 4) {
+    if (runtime_->TensorNumDims(input_tensor_) != 4) {
       SetError("Expected NHWC tensor layout.");
       return false;
     }
-    const int batch = runtime_.TensorDim(input_tensor_, 0);
-    input_height_ = runtime_.TensorDim(input_tensor_, 1);
-    input_width_ = runtime_.TensorDim(input_tensor_, 2);
-    const int channels = runtime_.TensorDim(input_tensor_, 3);
+    const int batch = runtime_->TensorDim(input_tensor_, 0);
+    input_height_ = runtime_->TensorDim(input_tensor_, 1);
+    input_width_ = runtime_->TensorDim(input_tensor_, 2);
+    const int channels = runtime_->TensorDim(input_tensor_, 3);
     if (batch != 1 || channels != 3) {
       SetError("Model expects 1xHxWx3 input.");
       return false;
     }
-    input_buffer_.resize(static_cast<size_t>(input_height_ * input_width_ * channels));
+    // Warp straight into the tensor when its memory is CPU-visible; otherwise
+    // stage in `input_upload_` and copy before each invoke. Quantized and
+    // float16 inputs are warped into `input_buffer_` and encoded band by band.
+    const size_t input_count =
+        static_cast<size_t>(input_height_) * input_width_ * channels;
+    const size_t input_bytes = input_count * input_encoding_.element_size();
+    void* input_tensor_data = runtime_->TensorData(input_tensor_);
+    if (!input_tensor_data ||
+        runtime_->TensorByteSize(input_tensor_) < input_bytes) {
+      input_upload_.resize(input_bytes);
+      input_tensor_data = input_upload_.data();
+    }
+    if (input_encoding_.needs_conversion()) {
+      input_buffer_.resize(input_count);
+      input_data_ = input_buffer_.data();
+      input_encoded_ = static_cast<uint8_t*>(input_tensor_data);
+    } else {
+      input_data_ = static_cast<float*>(input_tensor_data);
+    }
+    row_pool_.Start(threads_);
+    resamplers_.resize(static_cast<size_t>(row_pool_.thread_count()));
 
     const int output_count =
-        runtime_.InterpreterGetOutputTensorCount(interpreter_.get());
+        runtime_->InterpreterGetOutputTensorCount(interpreter_.get());
     if (output_count < 1) {
       SetError("Model outputs are missing.");
       return false;
     }
     output_landmarks_tensor_ =
-        runtime_.InterpreterGetOutputTensor(interpreter_.get(), 0);
+        runtime_->InterpreterGetOutputTensor(interpreter_.get(), 0);
     if (!output_landmarks_tensor_) {
       SetError("Landmark tensor missing.");
       return false;
     }
-    if (runtime_.TensorType(output_landmarks_tensor_) != kTfLiteFloat32) {
-      SetError("Landmark tensor must be float32.");
+    if (!ReadTensorEncoding(output_landmarks_tensor_, &landmarks_encoding_)) {
+      SetError("Landmark tensor must be float32, float16, uint8 or int8.");
       return false;
     }
     int total = 1;
-    const int dims = runtime_.TensorNumDims(output_landmarks_tensor_);
+    const int dims = runtime_->TensorNumDims(output_landmarks_tensor_);
     for (int i = 0; i < dims; ++i) {
-      total *= runtime_.TensorDim(output_landmarks_tensor_, i);
+      total *= runtime_->TensorDim(output_landmarks_tensor_, i);
     }
     if (total % 3 != 0) {
       SetError("Unexpected landmark size.");
       return false;
     }
     output_landmark_count_ = total / 3;
-    landmarks_buffer_.resize(static_cast<size_t>(total));
+    // Quantized and float16 landmarks are decoded into `landmarks_buffer_`
+    // after each invoke; float32 ones are read in place.
+    const size_t landmark_bytes =
+        static_cast<size_t>(total) * landmarks_encoding_.element_size();
+    const void* landmark_data = runtime_->TensorData(output_landmarks_tensor_);
+    if (!landmark_data ||
+        runtime_->TensorByteSize(output_landmarks_tensor_) < landmark_bytes) {
+      landmarks_download_.resize(landmark_bytes);
+      landmark_data = landmarks_download_.data();
+    }
+    if (landmarks_encoding_.needs_conversion()) {
+      landmarks_buffer_.resize(static_cast<size_t>(total));
+      landmarks_ = landmarks_buffer_.data();
+      landmarks_encoded_ = landmark_data;
+    } else {
+      landmarks_ = static_cast<const float*>(landmark_data);
+    }
 
     if (output_count > 1) {
       output_score_tensor_ =
-          runtime_.InterpreterGetOutputTensor(interpreter_.get(), 1);
+          runtime_->InterpreterGetOutputTensor(interpreter_.get(), 1);
       if (output_score_tensor_ &&
-          runtime_.TensorType(output_score_tensor_) != kTfLiteFloat32) {
+          !ReadTensorEncoding(output_score_tensor_, &score_encoding_)) {
         output_score_tensor_ = nullptr;
       }
     }
 
+    // The delegate has packed every weight by now.
+    weight_cache_.Commit();
+
     roi_ = DefaultRect();
     has_valid_rect_ = roi_tracking_enabled_;
     MP_LOGI("Initialize success\n");
@@ -312,71 +432,30 @@ class FaceMeshContext {
       rect = DefaultRect();
     }
 
-    const bool needs_transform = rot != 0 || mirror_horizontal;
-    if (needs_transform) {
-      if (!PreprocessRotated(image, rect, rot, mirror_horizontal,
-                             logical_width, logical_height)) {
-        return nullptr;
-      }
-    } else {
-      if (!Preprocess(image, rect)) {
-        return nullptr;
-      }
-    }
-
-    const size_t bytes = input_buffer_.size() * sizeof(float);
-    if (runtime_.TensorCopyFromBuffer(input_tensor_, input_buffer_.data(),
-                                      bytes) != kTfLiteOk) {
-      SetError("Failed to copy input buffer.");
-      return nullptr;
-    }
-
-    if (runtime_.InterpreterInvoke(interpreter_.get()) != kTfLiteOk) {
-      SetError("Interpreter invocation failed.");
-      return nullptr;
-    }
-
-    if (runtime_.TensorCopyToBuffer(output_landmarks_tensor_,
-                                    landmarks_buffer_.data(),
-                                    landmarks_buffer_.size() * sizeof(float)) !=
-        kTfLiteOk) {
-      SetError("Unable to read landmark output.");
+    RectInPixels roi;
+    const bool preprocessed =
+        image.format == MP_PIXEL_FORMAT_RGBA
+            ? Preprocess(mp::RgbaSource::From(image), rect, rot,
+                         mirror_horizontal, logical_width, logical_height,
+                         &roi)
+            : Preprocess(mp::BgraSource::From(image), rect, rot,
+                         mirror_horizontal, logical_width, logical_height,
+                         &roi);
+    if (!preprocessed) {
       return nullptr;
     }
 
     float score = 1.0f;
-    if (output_score_tensor_) {
-      if (runtime_.TensorCopyToBuffer(output_score_tensor_, &score,
-                                      sizeof(float)) != kTfLiteOk) {
-        SetError("Unable to read confidence output.");
-        return nullptr;
-      }
+    if (!RunInference(&score)) {
+      return nullptr;
     }
 
-    MpFaceMeshResult* result =
-        BuildResultFromSize(logical_width, logical_height, rect, score);
+    MpFaceMeshResult* result = BuildResultFromRoi(
+        logical_width, logical_height, rect, roi, score);
     if (!result) {
       return nullptr;
     }
 
-    // Debug: log raw landmark ranges before normalization.
-    if (!landmarks_buffer_.empty()) {
-      float min_x = landmarks_buffer_[0];
-      float max_x = landmarks_buffer_[0];
-      float min_y = landmarks_buffer_[1];
-      float max_y = landmarks_buffer_[1];
-      for (int i = 0; i < output_landmark_count_; ++i) {
-        const float rx = landmarks_buffer_[i * 3];
-        const float ry = landmarks_buffer_[i * 3 + 1];
-        min_x = std::min(min_x, rx);
-        max_x = std::max(max_x, rx);
-        min_y = std::min(min_y, ry);
-        max_y = std::max(max_y, ry);
-      }
-      MP_LOGI("Raw landmarks: count=%d min_x=%.3f max_x=%.3f min_y=%.3f max_y=%.3f\n",
-              output_landmark_count_, min_x, max_x, min_y, max_y);
-    }
-
     if (roi_tracking_enabled_) {
       if (!override_rect) {
         UpdateTrackingState(*result, score);
@@ -402,7 +481,275 @@ class FaceMeshContext {
       SetError("Invalid NV21 image buffer.");
       return nullptr;
     }
+    return ProcessYuvSource(mp::YuvSource::From(image), override_rect,
+                            rotation_degrees, mirror_horizontal);
+  }
 
+  MpFaceMeshResult* ProcessYuv(const MpYuvImage& image,
+                              const MpNormalizedRect* override_rect,
+                              int rotation_degrees = 0,
+                              bool mirror_horizontal = false) {
+    if (!interpreter_) {
+      SetError("Interpreter is not initialized.");
+      return nullptr;
+    }
+    if (!image.y || !image.u || !image.v || image.width <= 0 ||
+        image.height <= 0 || image.y_bytes_per_row <= 0 ||
+        image.uv_bytes_per_row <= 0 || image.uv_pixel_stride <= 0) {
+      SetError("Invalid YUV image buffer.");
+      return nullptr;
+    }
+    return ProcessYuvSource(mp::YuvSource::From(image), override_rect,
+                            rotation_degrees, mirror_horizontal);
+  }
+
+  /// Pre-cropped RGBA/BGRA/RGB at the model input size.
+  MpFaceMeshResult* ProcessCrop(const MpImage& crop,
+                                const MpNormalizedRect& crop_rect,
+                                int image_width,
+                                int image_height) {
+    crop_valid_ = false;
+    if (!CheckCropInput(crop_rect, image_width, image_height)) {
+      return nullptr;
+    }
+    if (!crop.data || crop.width != input_width_ ||
+        crop.height != input_height_) {
+      SetError("Crop must be " + std::to_string(input_width_) + "x" +
+               std::to_string(input_height_) + " pixels.");
+      return nullptr;
+    }
+    if (crop.format != MP_PIXEL_FORMAT_RGBA &&
+        crop.format != MP_PIXEL_FORMAT_BGRA &&
+        crop.format != MP_PIXEL_FORMAT_RGB) {
+      SetError("Unsupported pixel format. Use RGBA/BGRA/RGB.");
+      return nullptr;
+    }
+    const int bytes_per_pixel = crop.format == MP_PIXEL_FORMAT_RGB ? 3 : 4;
+    if (crop.bytes_per_row < crop.width * bytes_per_pixel) {
+      SetError("Invalid crop buffer.");
+      return nullptr;
+    }
+    switch (crop.format) {
+      case MP_PIXEL_FORMAT_RGBA:
+        CopyCrop(mp::RgbaSource::From(crop));
+        break;
+      case MP_PIXEL_FORMAT_BGRA:
+        CopyCrop(mp::BgraSource::From(crop));
+        break;
+      default:
+        CopyCrop(mp::RgbSource::From(crop));
+        break;
+    }
+    SetCrop(ToPixelRect(crop_rect, image_width, image_height), image_width,
+            image_height);
+    return InferCrop(crop_rect, image_width, image_height);
+  }
+
+  /// Normalized float NHWC input at the model input size.
+  MpFaceMeshResult* ProcessTensor(const float* tensor,
+                                  const MpNormalizedRect& crop_rect,
+                                  int image_width,
+                                  int image_height) {
+    crop_valid_ = false;
+    if (!CheckCropInput(crop_rect, image_width, image_height)) {
+      return nullptr;
+    }
+    if (!tensor) {
+      SetError("Input tensor is null.");
+      return nullptr;
+    }
+    float* dst = input_data_;
+    const size_t row_values = static_cast<size_t>(input_width_) * 3;
+    // Bands still run for quantized and float16 models, which encode each
+    // band into the tensor.
+    RunInputBands([&](int, int row_begin, int row_end) {
+      if (tensor == dst) {
+        return;
+      }
+      const size_t offset = static_cast<size_t>(row_begin) * row_values;
+      std::memcpy(dst + offset, tensor + offset,
+                  (row_end - row_begin) * row_values * sizeof(float));
+    });
+    SetCrop(ToPixelRect(crop_rect, image_width, image_height), image_width,
+            image_height);
+    return InferCrop(crop_rect, image_width, image_height);
+  }
+
+  // The float crop is the input buffer itself; RGB is converted from it on
+  // request.
+  bool LastCrop(MpCropFormat format, MpFaceCrop* crop) {
+    if (!crop_valid_) {
+      SetError("No face crop available. Process a frame first.");
+      return false;
+    }
+    const int count = input_width_ * input_height_ * 3;
+    switch (format) {
+      case MP_CROP_FORMAT_RGB:
+        crop_rgb_.resize(static_cast<size_t>(count));
+        mp::DenormalizePixels(input_data_, count, crop_rgb_.data());
+        crop->data = crop_rgb_.data();
+        crop->bytes_per_row = input_width_ * 3;
+        break;
+      case MP_CROP_FORMAT_FLOAT:
+        crop->data = input_data_;
+        crop->bytes_per_row =
+            input_width_ * 3 * static_cast<int>(sizeof(float));
+        break;
+      default:
+        SetError("Unknown crop format.");
+        return false;
+    }
+    crop->width = input_width_;
+    crop->height = input_height_;
+    crop->format = format;
+    crop->transform[0] = crop_transform_.xx;
+    crop->transform[1] = crop_transform_.xy;
+    crop->transform[2] = crop_transform_.xt;
+    crop->transform[3] = crop_transform_.yx;
+    crop->transform[4] = crop_transform_.yy;
+    crop->transform[5] = crop_transform_.yt;
+    crop->image_width = crop_image_width_;
+    crop->image_height = crop_image_height_;
+    return true;
+  }
+
+  // Runs `iterations` process calls on a synthetic `format` frame so the
+  // first real frame does not pay for lazy delegate allocation, weight page
+  // faults and cold preprocessing buffers. The frame is four times the model
+  // input. The first half of the calls use a rotated ROI, so the warp plan is
+  // built; the rest use the whole frame unrotated, which goes through the
+  // reduction pyramid or downsampled YUV staging and the separable
+  // resampler. Each call's wall time in milliseconds goes to `timings_ms`
+  // when given. Tracking state is restored afterwards; the last crop is
+  // dropped since the input buffer now holds the synthetic one.
+  int Warmup(int iterations, MpWarmupFormat format, float* timings_ms) {
+    if (!interpreter_) {
+      SetError("Interpreter is not initialized.");
+      return 0;
+    }
+    if (iterations <= 0) {
+      SetError("Warm-up iterations must be positive.");
+      return 0;
+    }
+    if (format < MP_WARMUP_FORMAT_RGBA || format > MP_WARMUP_FORMAT_I420) {
+      SetError("Unknown warm-up format.");
+      return 0;
+    }
+    const int size = std::max(input_width_, input_height_) * 4;
+    const bool yuv = format == MP_WARMUP_FORMAT_NV21 ||
+                     format == MP_WARMUP_FORMAT_I420;
+    const size_t plane = static_cast<size_t>(size) * size;
+    // Mid-grey: the packed frame, or Y followed by 4:2:0 chroma at 128.
+    std::vector<uint8_t> pixels(yuv ? plane + plane / 2 : plane * 4, 128);
+    MpImage image;
+    image.data = pixels.data();
+    image.width = size;
+    image.height = size;
+    image.bytes_per_row = size * 4;
+    image.format = format == MP_WARMUP_FORMAT_BGRA ? MP_PIXEL_FORMAT_BGRA
+                                                   : MP_PIXEL_FORMAT_RGBA;
+    MpYuvImage yuv_image;
+    yuv_image.y = pixels.data();
+    yuv_image.width = size;
+    yuv_image.height = size;
+    yuv_image.y_bytes_per_row = size;
+    if (format == MP_WARMUP_FORMAT_NV21) {
+      yuv_image.v = pixels.data() + plane;
+      yuv_image.u = yuv_image.v + 1;
+      yuv_image.uv_bytes_per_row = size;
+      yuv_image.uv_pixel_stride = 2;
+    } else {
+      yuv_image.u = pixels.data() + plane;
+      yuv_image.v = yuv_image.u + plane / 4;
+      yuv_image.uv_bytes_per_row = size / 2;
+      yuv_image.uv_pixel_stride = 1;
+    }
+    MpNormalizedRect rotated = DefaultRect();
+    rotated.width = 0.6f;
+    rotated.height = 0.6f;
+    rotated.rotation = 0.3f;
+    MpNormalizedRect whole = DefaultRect();
+    whole.width = 1.0f;
+    whole.height = 1.0f;
+    whole.rotation = 0.0f;
+
+    const MpNormalizedRect saved_roi = roi_;
+    const bool saved_has_valid_rect = has_valid_rect_;
+    const int saved_rotation_degrees = last_rotation_degrees_;
+    const bool saved_mirror_horizontal = last_mirror_horizontal_;
+    int completed = 0;
+    for (; completed < iterations; ++completed) {
+      const MpNormalizedRect* rect =
+          completed < (iterations + 1) / 2 ? &rotated : &whole;
+      const auto start = std::chrono::steady_clock::now();
+      MpFaceMeshResult* result =
+          yuv ? ProcessYuvSource(mp::YuvSource::From(yuv_image), rect, 0,
+                                 false)
+              : Process(image, rect, 0, false);
+      const auto end = std::chrono::steady_clock::now();
+      if (!result) {
+        break;
+      }
+      mp_face_mesh_release_result(result);
+      if (timings_ms) {
+        timings_ms[completed] =
+            std::chrono::duration<float, std::milli>(end - start).count();
+      }
+    }
+    roi_ = saved_roi;
+    has_valid_rect_ = saved_has_valid_rect;
+    last_rotation_degrees_ = saved_rotation_degrees;
+    last_mirror_horizontal_ = saved_mirror_horizontal;
+    crop_valid_ = false;
+    // The synthetic ROI must not count as the first sighting of a key, nor
+    // snap a real frame's ROI to it; the built grids stay allocated.
+    warp_plan_.Reset();
+    MP_LOGI("Warm-up ran %d of %d iterations\n", completed, iterations);
+    return completed;
+  }
+
+  float* input_tensor(int* width, int* height) {
+    *width = input_width_;
+    *height = input_height_;
+    return input_data_;
+  }
+
+  const char* last_error() const { return last_error_.c_str(); }
+  const char* kernel_isa() const { return mp::KernelIsaName(kernel_isa_); }
+
+ private:
+  struct TfLiteOptionsDeleter {
+    TfLiteRuntime* runtime = nullptr;
+    void operator()(TfLiteInterpreterOptions* options) const {
+      if (runtime && options) {
+        runtime->InterpreterOptionsDelete(options);
+      }
+    }
+  };
+
+  struct TfLiteInterpreterDeleter {
+    TfLiteRuntime* runtime = nullptr;
+    void operator()(TfLiteInterpreter* interpreter) const {
+      if (runtime && interpreter) {
+        runtime->InterpreterDelete(interpreter);
+      }
+    }
+  };
+
+  struct TfLiteDelegateDeleter {
+    using DeleteFn = void (*)(TfLiteDelegate*);
+    DeleteFn deleter = nullptr;
+    void operator()(TfLiteDelegate* delegate) const {
+      if (deleter && delegate) {
+        deleter(delegate);
+      }
+    }
+  };
+
+  MpFaceMeshResult* ProcessYuvSource(const mp::YuvSource& image,
+                                     const MpNormalizedRect* override_rect,
+                                     int rotation_degrees,
+                                     bool mirror_horizontal) {
     const int rot = NormalizeRotationDegrees(rotation_degrees);
     if (rot < 0) {
       SetError("rotation_degrees must be one of 0, 90, 180, 270.");
@@ -431,49 +778,19 @@ class FaceMeshContext {
       rect = DefaultRect();
     }
 
-    const bool needs_transform = rot != 0 || mirror_horizontal;
-    if (needs_transform) {
-      if (!PreprocessNv21Rotated(image, rect, rot, mirror_horizontal,
-                                 logical_width, logical_height)) {
-        return nullptr;
-      }
-    } else {
-      if (!PreprocessNv21(image, rect)) {
-        return nullptr;
-      }
-    }
-
-    const size_t bytes = input_buffer_.size() * sizeof(float);
-    if (runtime_.TensorCopyFromBuffer(input_tensor_, input_buffer_.data(),
-                                      bytes) != kTfLiteOk) {
-      SetError("Failed to copy input buffer.");
-      return nullptr;
-    }
-
-    if (runtime_.InterpreterInvoke(interpreter_.get()) != kTfLiteOk) {
-      SetError("Interpreter invocation failed.");
-      return nullptr;
-    }
-
-    if (runtime_.TensorCopyToBuffer(output_landmarks_tensor_,
-                                    landmarks_buffer_.data(),
-                                    landmarks_buffer_.size() * sizeof(float)) !=
-        kTfLiteOk) {
-      SetError("Unable to read landmark output.");
+    RectInPixels roi;
+    if (!Preprocess(image, rect, rot, mirror_horizontal, logical_width,
+                    logical_height, &roi)) {
       return nullptr;
     }
 
     float score = 1.0f;
-    if (output_score_tensor_) {
-      if (runtime_.TensorCopyToBuffer(output_score_tensor_, &score,
-                                      sizeof(float)) != kTfLiteOk) {
-        SetError("Unable to read confidence output.");
-        return nullptr;
-      }
+    if (!RunInference(&score)) {
+      return nullptr;
     }
 
-    MpFaceMeshResult* result =
-        BuildResultFromSize(logical_width, logical_height, rect, score);
+    MpFaceMeshResult* result = BuildResultFromRoi(
+        logical_width, logical_height, rect, roi, score);
     if (!result) {
       return nullptr;
     }
@@ -490,52 +807,58 @@ class FaceMeshContext {
     return result;
   }
 
-  const char* last_error() const { return last_error_.c_str(); }
-
- private:
-  struct TfLiteModelDeleter {
-    TfLiteRuntime* runtime;
-    void operator()(TfLiteModel* model) const {
-      if (runtime && model) {
-        runtime->ModelDelete(model);
-      }
+  bool CheckCropInput(const MpNormalizedRect& crop_rect,
+                      int image_width,
+                      int image_height) {
+    if (!interpreter_) {
+      SetError("Interpreter is not initialized.");
+      return false;
     }
-  };
-
-  struct TfLiteOptionsDeleter {
-    TfLiteRuntime* runtime;
-    void operator()(TfLiteInterpreterOptions* options) const {
-      if (runtime && options) {
-        runtime->InterpreterOptionsDelete(options);
-      }
+    if (image_width <= 0 || image_height <= 0) {
+      SetError("Invalid image size.");
+      return false;
     }
-  };
-
-  struct TfLiteInterpreterDeleter {
-    TfLiteRuntime* runtime;
-    void operator()(TfLiteInterpreter* interpreter) const {
-      if (runtime && interpreter) {
-        runtime->InterpreterDelete(interpreter);
-      }
+    if (!(crop_rect.width > 0.f) || !(crop_rect.height > 0.f) ||
+        !std::isfinite(crop_rect.x_center) ||
+        !std::isfinite(crop_rect.y_center) ||
+        !std::isfinite(crop_rect.rotation)) {
+      SetError("Invalid crop rect.");
+      return false;
     }
-  };
+    return true;
+  }
 
-  struct TfLiteDelegateDeleter {
-    using DeleteFn = void (*)(TfLiteDelegate*);
-    DeleteFn deleter = nullptr;
-    void operator()(TfLiteDelegate* delegate) const {
-      if (deleter && delegate) {
-        deleter(delegate);
-      }
+  // The crop already has the input size, so an identity nearest warp is a
+  // plain per-pixel conversion on the same vector kernels.
+  template <typename Source>
+  void CopyCrop(const Source& source) {
+    float* dst = input_data_;
+    const int width = input_width_;
+    const mp::WarpTransform identity;
+    RunInputBands([&](int, int row_begin, int row_end) {
+      mp::WarpNearest(source, identity, dst, width, row_begin, row_end);
+    });
+  }
+
+  // Runs the model on a caller-cropped input and maps the landmarks through
+  // the crop's rect. The rect is used as given and tracking is left alone.
+  MpFaceMeshResult* InferCrop(const MpNormalizedRect& crop_rect,
+                              int image_width,
+                              int image_height) {
+    float score = 1.0f;
+    if (!RunInference(&score)) {
+      return nullptr;
     }
-  };
+    return BuildResultFromSize(image_width, image_height, crop_rect, score);
+  }
 
   void Shutdown() {
+    row_pool_.Stop();
     interpreter_.reset();
     options_.reset();
     model_.reset();
     delegate_.reset();
-    runtime_.Release();
+    runtime_.reset();
   }
 
   MpNormalizedRect DefaultRect() const {
@@ -572,402 +895,224 @@ class FaceMeshContext {
     }
   }
 
-  bool Preprocess(const MpImage& image, const MpNormalizedRect& rect) {
-    const RectInPixels roi = ToPixelRect(rect, image.width, image.height);
-    if (roi.width <= 0.f || roi.height <= 0.f) {
+  // Warps the crop for `rect` into the input tensor. `roi` receives the
+  // logical pixel ROI actually sampled: the snapped plan key ROI when a warp
+  // plan may be applied, the exact ROI otherwise. Landmarks and LastCrop()
+  // map through the same ROI.
+  template <typename Source>
+  bool Preprocess(const Source& source,
+                  const MpNormalizedRect& rect,
+                  int rotation_degrees,
+                  bool mirror_horizontal,
+                  int logical_width,
+                  int logical_height,
+                  RectInPixels* roi) {
+    crop_valid_ = false;
+    const RectInPixels exact =
+        ToPixelRect(rect, logical_width, logical_height);
+    mp::WarpPlanKey key = mp::MakeWarpPlanKey(
+        source, rotation_degrees, mirror_horizontal, mp::QuantizeRoi(exact));
+    if (key.roi.width <= 0.f || key.roi.height <= 0.f) {
       SetError("Invalid ROI dimension.");
       return false;
     }
-    const float cos_r = std::cos(roi.rotation);
-    const float sin_r = std::sin(roi.rotation);
-    const float half_w = roi.width * 0.5f;
-    const float half_h = roi.height * 0.5f;
+    const mp::WarpTransform snapped = mp::MakeWarpTransform(
+        key.roi, input_width_, input_height_, rotation_degrees,
+        mirror_horizontal, source.width, source.height);
+    key.interpolation = ResolveInterpolation(snapped);
+    if (warp_plan_.Expects(key)) {
+      *roi = key.roi;
+      Warp(source, snapped, key);
+    } else {
+      *roi = exact;
+      Warp(source,
+           mp::MakeWarpTransform(exact, input_width_, input_height_,
+                                 rotation_degrees, mirror_horizontal,
+                                 source.width, source.height),
+           key);
+    }
+    SetCrop(*roi, logical_width, logical_height);
+    return true;
+  }
 
-    float* dst = input_buffer_.data();
-    const int target_w = input_width_;
-    const int target_h = input_height_;
-
-    size_t offset = 0;
-    for (int y = 0; y < target_h; ++y) {
-      const float ny =
-          ((static_cast<float>(y) + 0.5f) / static_cast<float>(target_h) - 0.5f) *
-          2.0f;
-      for (int x = 0; x < target_w; ++x) {
-        const float nx = ((static_cast<float>(x) + 0.5f) /
-                              static_cast<float>(target_w) -
-                          0.5f) *
-                         2.0f;
-        const float rx = nx * half_w;
-        const float ry = ny * half_h;
-        const float source_x = cos_r * rx - sin_r * ry + roi.center_x;
-        const float source_y = sin_r * rx + cos_r * ry + roi.center_y;
-        const RgbPixel pixel = BilinearSample(image, source_x, source_y);
-        dst[offset++] = pixel.r / 127.5f - 1.0f;
-        dst[offset++] = pixel.g / 127.5f - 1.0f;
-        dst[offset++] = pixel.b / 127.5f - 1.0f;
-      }
+  // Records where the crop now in `input_data_` came from, in logical image
+  // pixels, for LastCrop().
+  void SetCrop(const RectInPixels& roi, int image_width, int image_height) {
+    crop_transform_ = mp::MakeWarpTransform(
+        roi, input_width_, input_height_, 0, false, image_width, image_height);
+    crop_image_width_ = image_width;
+    crop_image_height_ = image_height;
+    crop_valid_ = true;
+  }
+
+  mp::Interpolation ResolveInterpolation(
+      const mp::WarpTransform& transform) const {
+    switch (interpolation_) {
+      case MP_INTERPOLATION_NEAREST:
+        return mp::Interpolation::kNearest;
+      case MP_INTERPOLATION_AREA:
+        return mp::Interpolation::kArea;
+      case MP_INTERPOLATION_AUTO:
+        return mp::AutoInterpolation(transform);
+      case MP_INTERPOLATION_BILINEAR:
+      default:
+        return mp::Interpolation::kBilinear;
     }
-    return true;
   }
 
-  bool PreprocessRotated(const MpImage& image,
-                         const MpNormalizedRect& rect,
-                         int rotation_degrees,
-                         bool mirror_horizontal,
-                         int rotated_width,
-                         int rotated_height) {
-    const RectInPixels roi = ToPixelRect(rect, rotated_width, rotated_height);
-    if (roi.width <= 0.f || roi.height <= 0.f) {
-      SetError("Invalid ROI dimension.");
-      return false;
+  // ROIs that cover far more source pixels than the model input are first
+  // reduced through the box pyramid so the warp samples close to 1:1. The
+  // interpolation mode sets how far is "far more"; nearest never reduces.
+  template <int kR, int kB>
+  void Warp(const mp::PackedPixelSource<kR, kB>& source,
+            const mp::WarpTransform& transform,
+            const mp::WarpPlanKey& key) {
+    if (pyramid_.Build(source, transform, input_width_, input_height_,
+                       mp::ReductionScale(key.interpolation), row_pool_)) {
+      WarpPacked(pyramid_.level<kR, kB>(), pyramid_.transform(), key);
+      return;
     }
-    const float cos_r = std::cos(roi.rotation);
-    const float sin_r = std::sin(roi.rotation);
-    const float half_w = roi.width * 0.5f;
-    const float half_h = roi.height * 0.5f;
+    WarpPacked(source, transform, key);
+  }
 
-    float* dst = input_buffer_.data();
-    const int target_w = input_width_;
-    const int target_h = input_height_;
-
-    size_t offset = 0;
-    for (int y = 0; y < target_h; ++y) {
-      const float ny =
-          ((static_cast<float>(y) + 0.5f) / static_cast<float>(target_h) -
-           0.5f) *
-          2.0f;
-      for (int x = 0; x < target_w; ++x) {
-        const float nx =
-            ((static_cast<float>(x) + 0.5f) / static_cast<float>(target_w) -
-             0.5f) *
-            2.0f;
-        const float rx = nx * half_w;
-        const float ry = ny * half_h;
-        const float source_x = cos_r * rx - sin_r * ry + roi.center_x;
-        const float source_y = sin_r * rx + cos_r * ry + roi.center_y;
-        const RgbPixel pixel = BilinearSampleRotated(
-            image, source_x, source_y, rotation_degrees, mirror_horizontal,
-            rotated_width, rotated_height);
-        dst[offset++] = pixel.r / 127.5f - 1.0f;
-        dst[offset++] = pixel.g / 127.5f - 1.0f;
-        dst[offset++] = pixel.b / 127.5f - 1.0f;
-      }
+  // Nearest sampling is a single gather per pixel and needs none of the
+  // bilinear caches. Otherwise unrotated ROIs (detector boxes, tracking
+  // disabled) take the separable path. Rotated ROIs use the cached warp plan
+  // once the same geometry has been seen twice in a row, and the general warp
+  // otherwise. The separable path stays in float: it is exact and already
+  // cheaper than an integer warp. Output rows are split into bands across
+  // `row_pool_`; each band has its own resampler row cache, everything else
+  // is read-only while it runs.
+  template <int kR, int kB>
+  void WarpPacked(const mp::PackedPixelSource<kR, kB>& source,
+                  const mp::WarpTransform& transform,
+                  const mp::WarpPlanKey& key) {
+    float* dst = input_data_;
+    const int width = input_width_;
+    if (key.interpolation == mp::Interpolation::kNearest) {
+      RunInputBands([&](int, int row_begin, int row_end) {
+        mp::WarpNearest(source, transform, dst, width, row_begin, row_end);
+      });
+      return;
     }
-    return true;
+    if (mp::SeparableResampler::Supports(transform)) {
+      RunInputBands([&](int band, int row_begin, int row_end) {
+        resamplers_[static_cast<size_t>(band)].Run(source, transform, dst,
+                                                   width, row_begin, row_end);
+      });
+      return;
+    }
+    if (warp_plan_.Prepare(key, source.width, source.height,
+                           source.bytes_per_row, transform, input_width_,
+                           input_height_)) {
+      const bool fixed_point = fixed_point_preprocessing_;
+      RunInputBands([&](int, int row_begin, int row_end) {
+        warp_plan_.Apply(source, dst, row_begin, row_end, fixed_point,
+                         kernel_isa_);
+      });
+      return;
+    }
+    if (fixed_point_preprocessing_) {
+      RunInputBands([&](int, int row_begin, int row_end) {
+        mp::WarpBilinearFixed(source, transform, dst, width, row_begin,
+                              row_end);
+      });
+      return;
+    }
+    RunInputBands([&](int, int row_begin, int row_end) {
+      mp::WarpBilinear(source, transform, dst, width, row_begin, row_end,
+                       kernel_isa_);
+    });
   }
 
-  bool PreprocessNv21(const MpNv21Image& image, const MpNormalizedRect& rect) {
-    const RectInPixels roi = ToPixelRect(rect, image.width, image.height);
-    if (roi.width <= 0.f || roi.height <= 0.f) {
-      SetError("Invalid ROI dimension.");
-      return false;
+  // YUV goes through the RGBA staging buffer whenever that is cheaper than
+  // converting every bilinear tap. Nearest converts each tap once either
+  // way, so it always samples the planes directly.
+  void Warp(const mp::YuvSource& source,
+            const mp::WarpTransform& transform,
+            const mp::WarpPlanKey& key) {
+    float* dst = input_data_;
+    const int width = input_width_;
+    if (key.interpolation == mp::Interpolation::kNearest) {
+      RunInputBands([&](int, int row_begin, int row_end) {
+        mp::WarpNearest(source, transform, dst, width, row_begin, row_end);
+      });
+      return;
     }
-    const float cos_r = std::cos(roi.rotation);
-    const float sin_r = std::sin(roi.rotation);
-    const float half_w = roi.width * 0.5f;
-    const float half_h = roi.height * 0.5f;
+    if (yuv_stager_.Stage(source, transform, input_width_, input_height_,
+                          mp::ReductionScale(key.interpolation),
+                          kernel_isa_)) {
+      Warp(yuv_stager_.staged(), yuv_stager_.transform(), key);
+      return;
+    }
+    RunInputBands([&](int, int row_begin, int row_end) {
+      mp::WarpBilinear(source, transform, dst, width, row_begin, row_end,
+                       kernel_isa_);
+    });
+  }
 
-    float* dst = input_buffer_.data();
-    const int target_w = input_width_;
-    const int target_h = input_height_;
-
-    size_t offset = 0;
-    for (int y = 0; y < target_h; ++y) {
-      const float ny =
-          ((static_cast<float>(y) + 0.5f) / static_cast<float>(target_h) -
-           0.5f) *
-          2.0f;
-      for (int x = 0; x < target_w; ++x) {
-        const float nx =
-            ((static_cast<float>(x) + 0.5f) / static_cast<float>(target_w) -
-             0.5f) *
-            2.0f;
-        const float rx = nx * half_w;
-        const float ry = ny * half_h;
-        const float source_x = cos_r * rx - sin_r * ry + roi.center_x;
-        const float source_y = sin_r * rx + cos_r * ry + roi.center_y;
-        const RgbPixel pixel = BilinearSampleNv21(image, source_x, source_y);
-        dst[offset++] = pixel.r / 127.5f - 1.0f;
-        dst[offset++] = pixel.g / 127.5f - 1.0f;
-        dst[offset++] = pixel.b / 127.5f - 1.0f;
+  // Runs `warp_rows` over bands of input rows on `row_pool_`. Quantized and
+  // float16 inputs are encoded into the tensor as each band finishes, while
+  // its float rows are still in cache.
+  template <typename WarpRows>
+  void RunInputBands(const WarpRows& warp_rows) {
+    row_pool_.Run(input_height_, [&](int band, int row_begin, int row_end) {
+      warp_rows(band, row_begin, row_end);
+      if (input_encoded_) {
+        const size_t row_values = static_cast<size_t>(input_width_) * 3;
+        const size_t offset = static_cast<size_t>(row_begin) * row_values;
+        mp::EncodeTensorValues(
+            input_data_ + offset,
+            static_cast<int>((row_end - row_begin) * row_values),
+            input_encoding_,
+            input_encoded_ + offset * input_encoding_.element_size(),
+            kernel_isa_);
       }
-    }
-    return true;
+    });
   }
 
-  bool PreprocessNv21Rotated(const MpNv21Image& image,
-                             const MpNormalizedRect& rect,
-                             int rotation_degrees,
-                             bool mirror_horizontal,
-                             int rotated_width,
-                             int rotated_height) {
-    const RectInPixels roi = ToPixelRect(rect, rotated_width, rotated_height);
-    if (roi.width <= 0.f || roi.height <= 0.f) {
-      SetError("Invalid ROI dimension.");
+  // Invokes the interpreter on the preprocessed input. Tensors without
+  // CPU-visible memory go through the copy buffers; everything else is read
+  // and written in place.
+  bool RunInference(float* score) {
+    if (!input_upload_.empty() &&
+        runtime_->TensorCopyFromBuffer(input_tensor_, input_upload_.data(),
+                                      input_upload_.size()) != kTfLiteOk) {
+      SetError("Failed to copy input buffer.");
       return false;
     }
-    const float cos_r = std::cos(roi.rotation);
-    const float sin_r = std::sin(roi.rotation);
-    const float half_w = roi.width * 0.5f;
-    const float half_h = roi.height * 0.5f;
 
-    float* dst = input_buffer_.data();
-    const int target_w = input_width_;
-    const int target_h = input_height_;
-
-    size_t offset = 0;
-    for (int y = 0; y < target_h; ++y) {
-      const float ny =
-          ((static_cast<float>(y) + 0.5f) / static_cast<float>(target_h) -
-           0.5f) *
-          2.0f;
-      for (int x = 0; x < target_w; ++x) {
-        const float nx =
-            ((static_cast<float>(x) + 0.5f) / static_cast<float>(target_w) -
-             0.5f) *
-            2.0f;
-        const float rx = nx * half_w;
-        const float ry = ny * half_h;
-        const float source_x = cos_r * rx - sin_r * ry + roi.center_x;
-        const float source_y = sin_r * rx + cos_r * ry + roi.center_y;
-        const RgbPixel pixel = BilinearSampleNv21Rotated(
-            image, source_x, source_y, rotation_degrees, mirror_horizontal,
-            rotated_width, rotated_height);
-        dst[offset++] = pixel.r / 127.5f - 1.0f;
-        dst[offset++] = pixel.g / 127.5f - 1.0f;
-        dst[offset++] = pixel.b / 127.5f - 1.0f;
-      }
+    if (runtime_->InterpreterInvoke(interpreter_.get()) != kTfLiteOk) {
+      SetError("Interpreter invocation failed.");
+      return false;
     }
-    return true;
-  }
 
-  RgbPixel BilinearSample(const MpImage& image, float x, float y) const {
-    if (x < 0.0f || y < 0.0f || x > static_cast<float>(image.width - 1) ||
-        y > static_cast<float>(image.height - 1)) {
-      return {};
-    }
-    const int x0 = static_cast<int>(std::floor(x));
-    const int y0 = static_cast<int>(std::floor(y));
-    const int x1 = std::min(x0 + 1, image.width - 1);
-    const int y1 = std::min(y0 + 1, image.height - 1);
-    const float dx = x - static_cast<float>(x0);
-    const float dy = y - static_cast<float>(y0);
-
-    const RgbPixel p00 = ReadPixel(image, x0, y0);
-    const RgbPixel p10 = ReadPixel(image, x1, y0);
-    const RgbPixel p01 = ReadPixel(image, x0, y1);
-    const RgbPixel p11 = ReadPixel(image, x1, y1);
-
-    const RgbPixel top = Lerp(p00, p10, dx);
-    const RgbPixel bottom = Lerp(p01, p11, dx);
-    return Lerp(top, bottom, dy);
-  }
-
-  RgbPixel BilinearSampleRotated(const MpImage& image,
-                                 float x,
-                                 float y,
-                                 int rotation_degrees,
-                                 bool mirror_horizontal,
-                                 int rotated_width,
-                                 int rotated_height) const {
-    if (x < 0.0f || y < 0.0f || x > static_cast<float>(rotated_width - 1) ||
-        y > static_cast<float>(rotated_height - 1)) {
-      return {};
-    }
-    const int x0 = static_cast<int>(std::floor(x));
-    const int y0 = static_cast<int>(std::floor(y));
-    const int x1 = std::min(x0 + 1, rotated_width - 1);
-    const int y1 = std::min(y0 + 1, rotated_height - 1);
-    const float dx = x - static_cast<float>(x0);
-    const float dy = y - static_cast<float>(y0);
-
-    const RgbPixel p00 = ReadPixelRotated(
-        image, x0, y0, rotation_degrees, mirror_horizontal, rotated_width);
-    const RgbPixel p10 = ReadPixelRotated(
-        image, x1, y0, rotation_degrees, mirror_horizontal, rotated_width);
-    const RgbPixel p01 = ReadPixelRotated(
-        image, x0, y1, rotation_degrees, mirror_horizontal, rotated_width);
-    const RgbPixel p11 = ReadPixelRotated(
-        image, x1, y1, rotation_degrees, mirror_horizontal, rotated_width);
-
-    const RgbPixel top = Lerp(p00, p10, dx);
-    const RgbPixel bottom = Lerp(p01, p11, dx);
-    return Lerp(top, bottom, dy);
-  }
-
-  RgbPixel BilinearSampleNv21(const MpNv21Image& image,
-                              float x,
-                              float y) const {
-    if (x < 0.0f || y < 0.0f || x > static_cast<float>(image.width - 1) ||
-        y > static_cast<float>(image.height - 1)) {
-      return {};
-    }
-    const int x0 = static_cast<int>(std::floor(x));
-    const int y0 = static_cast<int>(std::floor(y));
-    const int x1 = std::min(x0 + 1, image.width - 1);
-    const int y1 = std::min(y0 + 1, image.height - 1);
-    const float dx = x - static_cast<float>(x0);
-    const float dy = y - static_cast<float>(y0);
-
-    const RgbPixel p00 = ReadPixelNv21(image, x0, y0);
-    const RgbPixel p10 = ReadPixelNv21(image, x1, y0);
-    const RgbPixel p01 = ReadPixelNv21(image, x0, y1);
-    const RgbPixel p11 = ReadPixelNv21(image, x1, y1);
-
-    const RgbPixel top = Lerp(p00, p10, dx);
-    const RgbPixel bottom = Lerp(p01, p11, dx);
-    return Lerp(top, bottom, dy);
-  }
-
-  RgbPixel BilinearSampleNv21Rotated(const MpNv21Image& image,
-                                     float x,
-                                     float y,
-                                     int rotation_degrees,
-                                     bool mirror_horizontal,
-                                     int rotated_width,
-                                     int rotated_height) const {
-    if (x < 0.0f || y < 0.0f || x > static_cast<float>(rotated_width - 1) ||
-        y > static_cast<float>(rotated_height - 1)) {
-      return {};
-    }
-    const int x0 = static_cast<int>(std::floor(x));
-    const int y0 = static_cast<int>(std::floor(y));
-    const int x1 = std::min(x0 + 1, rotated_width - 1);
-    const int y1 = std::min(y0 + 1, rotated_height - 1);
-    const float dx = x - static_cast<float>(x0);
-    const float dy = y - static_cast<float>(y0);
-
-    const RgbPixel p00 = ReadPixelNv21Rotated(
-        image, x0, y0, rotation_degrees, mirror_horizontal, rotated_width);
-    const RgbPixel p10 = ReadPixelNv21Rotated(
-        image, x1, y0, rotation_degrees, mirror_horizontal, rotated_width);
-    const RgbPixel p01 = ReadPixelNv21Rotated(
-        image, x0, y1, rotation_degrees, mirror_horizontal, rotated_width);
-    const RgbPixel p11 = ReadPixelNv21Rotated(
-        image, x1, y1, rotation_degrees, mirror_horizontal, rotated_width);
-
-    const RgbPixel top = Lerp(p00, p10, dx);
-    const RgbPixel bottom = Lerp(p01, p11, dx);
-    return Lerp(top, bottom, dy);
-  }
-
-  RgbPixel ReadPixel(const MpImage& image, int x, int y) const {
-    const uint8_t* row =
-        image.data + static_cast<size_t>(y) * image.bytes_per_row;
-    const uint8_t* ptr = row + static_cast<size_t>(x) * 4;
-    RgbPixel pixel;
-    if (image.format == MP_PIXEL_FORMAT_RGBA) {
-      pixel.r = static_cast<float>(ptr[0]);
-      pixel.g = static_cast<float>(ptr[1]);
-      pixel.b = static_cast<float>(ptr[2]);
-    } else {
-      pixel.r = static_cast<float>(ptr[2]);
-      pixel.g = static_cast<float>(ptr[1]);
-      pixel.b = static_cast<float>(ptr[0]);
-    }
-    return pixel;
-  }
-
-  RgbPixel ReadPixelNv21(const MpNv21Image& image, int x, int y) const {
-    const uint8_t* y_row =
-        image.y + static_cast<size_t>(y) * image.y_bytes_per_row;
-    const uint8_t Y = y_row[static_cast<size_t>(x)];
-
-    const int uv_x = x >> 1;
-    const int uv_y = y >> 1;
-    const uint8_t* vu_row =
-        image.vu + static_cast<size_t>(uv_y) * image.vu_bytes_per_row;
-    const size_t vu_index = static_cast<size_t>(uv_x) * 2;
-    const uint8_t V = vu_row[vu_index];
-    const uint8_t U = vu_row[vu_index + 1];
-
-    const int C = static_cast<int>(Y) - 16;
-    const int D = static_cast<int>(U) - 128;
-    const int E = static_cast<int>(V) - 128;
-    const int c = C < 0 ? 0 : C;
-
-    const int r = (298 * c + 409 * E + 128) >> 8;
-    const int g = (298 * c - 100 * D - 208 * E + 128) >> 8;
-    const int b = (298 * c + 516 * D + 128) >> 8;
-
-    RgbPixel pixel;
-    pixel.r = static_cast<float>(ClampInt(r, 0, 255));
-    pixel.g = static_cast<float>(ClampInt(g, 0, 255));
-    pixel.b = static_cast<float>(ClampInt(b, 0, 255));
-    return pixel;
-  }
-
-  RgbPixel ReadPixelRotated(const MpImage& image,
-                            int x_rot,
-                            int y_rot,
-                            int rotation_degrees,
-                            bool mirror_horizontal,
-                            int rotated_width) const {
-    int x_raw = 0;
-    int y_raw = 0;
-    MapRotatedToRaw(x_rot, y_rot, rotation_degrees, mirror_horizontal,
-                    image.width, image.height, rotated_width, x_raw, y_raw);
-    return ReadPixel(image, x_raw, y_raw);
-  }
-
-  static inline void MapRotatedToRaw(int x_rot,
-                                     int y_rot,
-                                     int rotation_degrees,
-                                     bool mirror_horizontal,
-                                     int raw_width,
-                                     int raw_height,
-                                     int rotated_width,
-                                     int& out_x,
-                                     int& out_y) {
-    int xr = x_rot;
-    int yr = y_rot;
-    if (mirror_horizontal) {
-      xr = (rotated_width - 1) - xr;
+    if (!landmarks_download_.empty() &&
+        runtime_->TensorCopyToBuffer(output_landmarks_tensor_,
+                                    landmarks_download_.data(),
+                                    landmarks_download_.size()) != kTfLiteOk) {
+      SetError("Unable to read landmark output.");
+      return false;
     }
-    switch (rotation_degrees) {
-      case 90:
-        out_x = yr;
-        out_y = (raw_height - 1) - xr;
-        break;
-      case 180:
-        out_x = (raw_width - 1) - xr;
-        out_y = (raw_height - 1) - yr;
-        break;
-      case 270:
-        out_x = (raw_width - 1) - yr;
-        out_y = xr;
-        break;
-      case 0:
-      default:
-        out_x = xr;
-        out_y = yr;
-        break;
+    if (landmarks_encoded_) {
+      mp::DecodeTensorValues(landmarks_encoded_,
+                             static_cast<int>(landmarks_buffer_.size()),
+                             landmarks_encoding_, landmarks_buffer_.data(),
+                             kernel_isa_);
     }
-    out_x = ClampInt(out_x, 0, raw_width - 1);
-    out_y = ClampInt(out_y, 0, raw_height - 1);
-  }
 
-  RgbPixel ReadPixelNv21Rotated(const MpNv21Image& image,
-                                int x_rot,
-                                int y_rot,
-                                int rotation_degrees,
-                                bool mirror_horizontal,
-                                int rotated_width) const {
-    int x_raw = 0;
-    int y_raw = 0;
-    MapRotatedToRaw(x_rot, y_rot, rotation_degrees, mirror_horizontal,
-                    image.width, image.height, rotated_width,
-                    x_raw, y_raw);
-    return ReadPixelNv21(image, x_raw, y_raw);
-  }
-
-  RgbPixel Lerp(const RgbPixel& a, const RgbPixel& b, float t) const {
-    const float blend = Clamp(t, 0.0f, 1.0f);
-    RgbPixel out;
-    out.r = a.r + (b.r - a.r) * blend;
-    out.g = a.g + (b.g - a.g) * blend;
-    out.b = a.b + (b.b - a.b) * blend;
-    return out;
+    *score = 1.0f;
+    if (output_score_tensor_) {
+      float raw = 0.0f;
+      if (runtime_->TensorCopyToBuffer(output_score_tensor_, &raw,
+                                      score_encoding_.element_size()) !=
+          kTfLiteOk) {
+        SetError("Unable to read confidence output.");
+        return false;
+      }
+      mp::DecodeTensorValues(&raw, 1, score_encoding_, score);
+    }
+    return true;
   }
 
   MpFaceMeshResult* BuildResult(const MpImage& image,
@@ -980,6 +1125,17 @@ class FaceMeshContext {
                                         int height,
                                         const MpNormalizedRect& rect,
                                         float score) {
+    return BuildResultFromRoi(width, height, rect,
+                              ToPixelRect(rect, width, height), score);
+  }
+
+  // Maps the landmarks back through `roi`, the logical pixel ROI the crop
+  // was sampled from. `rect` is reported unchanged.
+  MpFaceMeshResult* BuildResultFromRoi(int width,
+                                       int height,
+                                       const MpNormalizedRect& rect,
+                                       const RectInPixels& roi,
+                                       float score) {
     auto* result = new MpFaceMeshResult();
     if (!result) {
       SetError("Unable to allocate result.");
@@ -997,7 +1153,6 @@ class FaceMeshContext {
     result->image_width = width;
     result->image_height = height;
 
-    const RectInPixels roi = ToPixelRect(rect, width, height);
     const float cos_r = std::cos(roi.rotation);
     const float sin_r = std::sin(roi.rotation);
     const float half_w = roi.width * 0.5f;
@@ -1006,9 +1161,9 @@ class FaceMeshContext {
     const float input_h = std::max(1, input_height_);
 
     for (int i = 0; i < output_landmark_count_; ++i) {
-      float raw_x = landmarks_buffer_[i * 3];
-      float raw_y = landmarks_buffer_[i * 3 + 1];
-      float raw_z = landmarks_buffer_[i * 3 + 2];
+      float raw_x = landmarks_[i * 3];
+      float raw_y = landmarks_[i * 3 + 1];
+      float raw_z = landmarks_[i * 3 + 2];
 
       // Some models emit normalized [0,1], others emit pixel coordinates in
       // input resolution. If values are outside [0,1], normalize using input
@@ -1132,18 +1287,53 @@ class FaceMeshContext {
     return std::atan2(dy, dx);
   }
 
+  // Fills `encoding` from the tensor's type and quantization. Returns false
+  // for unsupported types and for integer tensors without a usable scale.
+  bool ReadTensorEncoding(const TfLiteTensor* tensor,
+                          mp::TensorEncoding* encoding) const {
+    switch (runtime_->TensorType(tensor)) {
+      case kTfLiteFloat32:
+        *encoding = mp::TensorEncoding();
+        return true;
+      case kTfLiteFloat16:
+        *encoding = mp::TensorEncoding();
+        encoding->element = mp::TensorElement::kFloat16;
+        return true;
+      case kTfLiteUInt8:
+        encoding->element = mp::TensorElement::kUint8;
+        break;
+      case kTfLiteInt8:
+        encoding->element = mp::TensorElement::kInt8;
+        break;
+      default:
+        return false;
+    }
+    if (!runtime_->TensorQuantizationParams) {
+      return false;
+    }
+    const TfLiteQuantizationParams params =
+        runtime_->TensorQuantizationParams(tensor);
+    if (!(params.scale > 0.0f)) {
+      return false;
+    }
+    encoding->scale = params.scale;
+    encoding->zero_point = params.zero_point;
+    return true;
+  }
+
   void SetError(const std::string& message) {
     last_error_ = message;
     MP_LOGE("%s\n", message.c_str());
   }
 
-  TfLiteRuntime runtime_;
-  std::unique_ptr<TfLiteModel, TfLiteModelDeleter> model_{nullptr, {&runtime_}};
+  std::shared_ptr<TfLiteRuntime> runtime_;
+  std::shared_ptr<SharedTfLiteModel> model_;
   std::unique_ptr<TfLiteInterpreterOptions, TfLiteOptionsDeleter> options_{
-      nullptr, {&runtime_}};
+      nullptr, {}};
   std::unique_ptr<TfLiteInterpreter, TfLiteInterpreterDeleter> interpreter_{
-      nullptr, {&runtime_}};
+      nullptr, {}};
   std::unique_ptr<TfLiteDelegate, TfLiteDelegateDeleter> delegate_{nullptr, {}};
+  XnnpackWeightCache weight_cache_;
 
   TfLiteTensor* input_tensor_ = nullptr;
   const TfLiteTensor* output_landmarks_tensor_ = nullptr;
@@ -1158,9 +1348,37 @@ class FaceMeshContext {
   float min_tracking_confidence_ = 0.5f;
   bool smoothing_enabled_ = true;
   bool roi_tracking_enabled_ = true;
-
+  bool fixed_point_preprocessing_ = false;
+  MpInterpolation interpolation_ = MP_INTERPOLATION_BILINEAR;
+  mp::KernelIsa kernel_isa_ = mp::kBaselineKernelIsa;
+
+  // Point into the interpreter's tensors, or at the copy buffers below when
+  // the tensor memory is not CPU-visible. For converted tensors the float
+  // views live in `input_buffer_`/`landmarks_buffer_` and the `*_encoded_`
+  // pointers hold the tensor-side bytes.
+  float* input_data_ = nullptr;
+  const float* landmarks_ = nullptr;
+  uint8_t* input_encoded_ = nullptr;
+  const void* landmarks_encoded_ = nullptr;
+  mp::TensorEncoding input_encoding_;
+  mp::TensorEncoding landmarks_encoding_;
+  mp::TensorEncoding score_encoding_;
   std::vector<float> input_buffer_;
   std::vector<float> landmarks_buffer_;
+  std::vector<uint8_t> input_upload_;
+  std::vector<uint8_t> landmarks_download_;
+  mp::YuvRoiStager yuv_stager_;
+  mp::RoiPyramid pyramid_;
+  mp::WarpPlan warp_plan_;
+  mp::RowWorkerPool row_pool_;
+  std::vector<mp::SeparableResampler> resamplers_;
+
+  // Input crop of the last process call, see LastCrop().
+  bool crop_valid_ = false;
+  mp::WarpTransform crop_transform_;
+  int crop_image_width_ = 0;
+  int crop_image_height_ = 0;
+  std::vector<uint8_t> crop_rgb_;
 
   MpNormalizedRect roi_;
   bool has_valid_rect_ = false;
@@ -1175,12 +1393,32 @@ void SetGlobalError(const std::string& message) {
   g_last_global_error = message;
 }
 
+// Keeps the strip buffers of mp_convert_yuv_to_rgba across calls.
+thread_local mp::YuvFrameConverter g_frame_converter;
+
 }  // namespace
 
 struct MpFaceMeshContext {
   FaceMeshContext impl;
 };
 
+// State of one mp_face_mesh_create_async call, shared by the caller's task
+// handle and the worker thread so either may let go first. A context that
+// was never taken is destroyed with the state.
+struct AsyncCreateState {
+  ~AsyncCreateState() { delete context; }
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  bool done = false;
+  MpFaceMeshContext* context = nullptr;
+  std::string error;
+};
+
+struct MpFaceMeshCreateTask {
+  std::shared_ptr<AsyncCreateState> state;
+};
+
 extern "C" {
 
 FFI_PLUGIN_EXPORT MpFaceMeshContext* mp_face_mesh_create(
@@ -1203,6 +1441,113 @@ FFI_PLUGIN_EXPORT MpFaceMeshContext* mp_face_mesh_create(
   return context;
 }
 
+FFI_PLUGIN_EXPORT MpFaceMeshContext* mp_face_mesh_create_from_buffer(
+    const void* model_data,
+    size_t model_size,
+    const MpFaceMeshCreateOptions* options) {
+  if (!model_data || model_size == 0) {
+    SetGlobalError("Model buffer is empty.");
+    return nullptr;
+  }
+  auto* context = new MpFaceMeshContext();
+  if (!context) {
+    SetGlobalError("Unable to allocate context.");
+    return nullptr;
+  }
+  if (!context->impl.Initialize(model_data, model_size, options)) {
+    SetGlobalError(context->impl.last_error());
+    delete context;
+    return nullptr;
+  }
+  return context;
+}
+
+FFI_PLUGIN_EXPORT MpFaceMeshCreateTask* mp_face_mesh_create_async(
+    const void* model_data,
+    size_t model_size,
+    const MpFaceMeshCreateOptions* options,
+    MpFaceMeshCreateCallback callback,
+    void* user_data) {
+  if (!model_data || model_size == 0) {
+    SetGlobalError("Model buffer is empty.");
+    return nullptr;
+  }
+  // Everything the worker reads is copied now; the caller's buffers may be
+  // released as soon as this returns.
+  const auto* bytes = static_cast<const uint8_t*>(model_data);
+  std::vector<uint8_t> model_bytes(bytes, bytes + model_size);
+  MpFaceMeshCreateOptions copied_options{};
+  std::string library_path;
+  std::string weight_cache_dir;
+  const bool has_options = options != nullptr;
+  if (has_options) {
+    copied_options = *options;
+    library_path = options->tflite_library_path
+                       ? options->tflite_library_path
+                       : "";
+    weight_cache_dir = options->xnnpack_weight_cache_dir
+                           ? options->xnnpack_weight_cache_dir
+                           : "";
+  }
+
+  auto* task = new MpFaceMeshCreateTask();
+  task->state = std::make_shared<AsyncCreateState>();
+  std::thread([state = task->state, model_bytes = std::move(model_bytes),
+               copied_options, has_options,
+               library_path = std::move(library_path),
+               weight_cache_dir = std::move(weight_cache_dir), callback,
+               user_data]() mutable {
+    if (has_options) {
+      copied_options.tflite_library_path =
+          library_path.empty() ? nullptr : library_path.c_str();
+      copied_options.xnnpack_weight_cache_dir =
+          weight_cache_dir.empty() ? nullptr : weight_cache_dir.c_str();
+    }
+    auto* context = new MpFaceMeshContext();
+    std::string error;
+    if (!context->impl.Initialize(std::move(model_bytes),
+                                  has_options ? &copied_options : nullptr)) {
+      error = context->impl.last_error();
+      delete context;
+      context = nullptr;
+    }
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->context = context;
+      state->error = std::move(error);
+      state->done = true;
+    }
+    state->finished.notify_all();
+    if (callback) {
+      callback(user_data);
+    }
+  }).detach();
+  return task;
+}
+
+FFI_PLUGIN_EXPORT MpFaceMeshContext* mp_face_mesh_create_task_wait(
+    MpFaceMeshCreateTask* task) {
+  if (!task) {
+    SetGlobalError("Create task is null.");
+    return nullptr;
+  }
+  AsyncCreateState& state = *task->state;
+  std::unique_lock<std::mutex> lock(state.mutex);
+  state.finished.wait(lock, [&] { return state.done; });
+  MpFaceMeshContext* context = state.context;
+  state.context = nullptr;
+  if (!context) {
+    SetGlobalError(state.error.empty() ? "Context was already taken."
+                                       : state.error);
+  }
+  return context;
+}
+
+FFI_PLUGIN_EXPORT void mp_face_mesh_create_task_destroy(
+    MpFaceMeshCreateTask* task) {
+  delete task;
+}
+
 FFI_PLUGIN_EXPORT void mp_face_mesh_destroy(MpFaceMeshContext* context) {
   delete context;
 }
@@ -1243,6 +1588,167 @@ FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process_nv21(
                                    mirror_horizontal != 0);
 }
 
+FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process_yuv(
+    MpFaceMeshContext* context,
+    const MpYuvImage* image,
+    const MpNormalizedRect* override_rect,
+    int32_t rotation_degrees,
+    uint8_t mirror_horizontal) {
+  if (!context) {
+    SetGlobalError("Context is null.");
+    return nullptr;
+  }
+  if (!image) {
+    SetGlobalError("Image is null.");
+    return nullptr;
+  }
+  return context->impl.ProcessYuv(*image, override_rect, rotation_degrees,
+                                  mirror_horizontal != 0);
+}
+
+FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process_yuv_planes(
+    MpFaceMeshContext* context,
+    const uint8_t* y,
+    const uint8_t* u,
+    const uint8_t* v,
+    const MpYuvImage* layout,
+    const MpNormalizedRect* override_rect,
+    int32_t rotation_degrees,
+    uint8_t mirror_horizontal) {
+  if (!context) {
+    SetGlobalError("Context is null.");
+    return nullptr;
+  }
+  if (!layout) {
+    SetGlobalError("Image is null.");
+    return nullptr;
+  }
+  MpYuvImage image = *layout;
+  image.y = y;
+  image.u = u;
+  image.v = v;
+  return context->impl.ProcessYuv(image, override_rect, rotation_degrees,
+                                  mirror_horizontal != 0);
+}
+
+FFI_PLUGIN_EXPORT float* mp_face_mesh_input_tensor(MpFaceMeshContext* context,
+                                                   int32_t* width,
+                                                   int32_t* height) {
+  if (!context || !width || !height) {
+    SetGlobalError("Context or size output is null.");
+    return nullptr;
+  }
+  int input_width = 0;
+  int input_height = 0;
+  float* data = context->impl.input_tensor(&input_width, &input_height);
+  *width = input_width;
+  *height = input_height;
+  return data;
+}
+
+FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process_crop(
+    MpFaceMeshContext* context,
+    const MpImage* crop,
+    const MpNormalizedRect* crop_rect,
+    int32_t image_width,
+    int32_t image_height) {
+  if (!context) {
+    SetGlobalError("Context is null.");
+    return nullptr;
+  }
+  if (!crop || !crop_rect) {
+    SetGlobalError("Crop or crop rect is null.");
+    return nullptr;
+  }
+  return context->impl.ProcessCrop(*crop, *crop_rect, image_width,
+                                   image_height);
+}
+
+FFI_PLUGIN_EXPORT MpFaceMeshResult* mp_face_mesh_process_tensor(
+    MpFaceMeshContext* context,
+    const float* tensor,
+    const MpNormalizedRect* crop_rect,
+    int32_t image_width,
+    int32_t image_height) {
+  if (!context) {
+    SetGlobalError("Context is null.");
+    return nullptr;
+  }
+  if (!crop_rect) {
+    SetGlobalError("Crop rect is null.");
+    return nullptr;
+  }
+  return context->impl.ProcessTensor(tensor, *crop_rect, image_width,
+                                     image_height);
+}
+
+FFI_PLUGIN_EXPORT int32_t mp_face_mesh_last_crop(MpFaceMeshContext* context,
+                                                 MpCropFormat format,
+                                                 MpFaceCrop* crop) {
+  if (!context) {
+    SetGlobalError("Context is null.");
+    return 0;
+  }
+  if (!crop) {
+    SetGlobalError("Crop output is null.");
+    return 0;
+  }
+  return context->impl.LastCrop(format, crop) ? 1 : 0;
+}
+
+FFI_PLUGIN_EXPORT int32_t mp_convert_yuv_to_rgba(const MpYuvImage* image,
+                                                 int32_t rotation_degrees,
+                                                 uint8_t mirror_horizontal,
+                                                 int32_t downscale,
+                                                 uint8_t* dst,
+                                                 int32_t dst_bytes_per_row,
+                                                 int32_t dst_height) {
+  if (!image || !image->y || !image->u || !image->v || image->width <= 0 ||
+      image->height <= 0 || image->y_bytes_per_row < image->width ||
+      image->uv_pixel_stride <= 0 ||
+      image->uv_bytes_per_row <
+          ((image->width + 1) / 2 - 1) * image->uv_pixel_stride + 1) {
+    SetGlobalError("Invalid YUV image buffer.");
+    return 0;
+  }
+  if (rotation_degrees != 0 && rotation_degrees != 90 &&
+      rotation_degrees != 180 && rotation_degrees != 270) {
+    SetGlobalError("Unsupported rotation degrees.");
+    return 0;
+  }
+  if (downscale != 1 && downscale != 2 && downscale != 4 && downscale != 8 &&
+      downscale != 16) {
+    SetGlobalError("Downscale must be 1, 2, 4, 8 or 16.");
+    return 0;
+  }
+  const bool transposed = rotation_degrees == 90 || rotation_degrees == 270;
+  const int out_width = mp::DownscaledSize(
+      transposed ? image->height : image->width, downscale);
+  const int out_height = mp::DownscaledSize(
+      transposed ? image->width : image->height, downscale);
+  if (!dst || dst_bytes_per_row < out_width * 4 || dst_height < out_height) {
+    SetGlobalError("RGBA output buffer must hold " +
+                   std::to_string(out_width) + "x" +
+                   std::to_string(out_height) + " pixels.");
+    return 0;
+  }
+  g_frame_converter.Convert(mp::YuvSource::From(*image), rotation_degrees,
+                            mirror_horizontal != 0, downscale, dst,
+                            dst_bytes_per_row, mp::DetectKernelIsa());
+  return 1;
+}
+
+FFI_PLUGIN_EXPORT int32_t mp_face_mesh_warmup(MpFaceMeshContext* context,
+                                              int32_t iterations,
+                                              MpWarmupFormat format,
+                                              float* timings_ms) {
+  if (!context) {
+    SetGlobalError("Context is null.");
+    return 0;
+  }
+  return context->impl.Warmup(iterations, format, timings_ms);
+}
+
 FFI_PLUGIN_EXPORT void mp_face_mesh_release_result(MpFaceMeshResult* result) {
   if (!result) {
     return;
@@ -1260,6 +1766,14 @@ FFI_PLUGIN_EXPORT const char* mp_face_mesh_last_error(
   return context->impl.last_error();
 }
 
+FFI_PLUGIN_EXPORT const char* mp_face_mesh_kernel_isa(
+    const MpFaceMeshContext* context) {
+  if (!context) {
+    return nullptr;
+  }
+  return context->impl.kernel_isa();
+}
+
 FFI_PLUGIN_EXPORT const char* mp_face_mesh_last_global_error(void) {
   return g_last_global_error.c_str();
 }
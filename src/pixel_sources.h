@@ -0,0 +1,197 @@
+#ifndef PIXEL_SOURCES_H_
+#define PIXEL_SOURCES_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "mediapipe_face.h"
+
+namespace mp {
+
+// Normalization applied to every sampled channel: [0, 255] -> [-1, 1].
+constexpr float kPixelScale = 1.0f / 127.5f;
+constexpr float kPixelOffset = -1.0f;
+
+// Memory layout of a pixel source, used where cached state must not be
+// shared between layouts.
+enum class SourceFormat { kRgba, kBgra, kYuv420 };
+
+// Packed 32-bit pixels; `kR`/`kB` select the byte holding red/blue.
+template <int kR, int kB>
+struct PackedPixelSource {
+  static constexpr int kRedShift = kR * 8;
+  static constexpr int kBlueShift = kB * 8;
+  static constexpr SourceFormat kFormat =
+      kR == 0 ? SourceFormat::kRgba : SourceFormat::kBgra;
+
+  const uint8_t* data = nullptr;
+  int width = 0;
+  int height = 0;
+  int bytes_per_row = 0;
+
+  static PackedPixelSource From(const MpImage& image) {
+    return {image.data, image.width, image.height, image.bytes_per_row};
+  }
+
+  void Tap(int x, int y, float* rgb) const {
+    const uint8_t* ptr = data + static_cast<size_t>(y) * bytes_per_row +
+                         static_cast<size_t>(x) * 4;
+    rgb[0] = static_cast<float>(ptr[kR]);
+    rgb[1] = static_cast<float>(ptr[1]);
+    rgb[2] = static_cast<float>(ptr[kB]);
+  }
+};
+
+using RgbaSource = PackedPixelSource<0, 2>;
+using BgraSource = PackedPixelSource<2, 0>;
+
+// Packed 24-bit RGB, as taken for crops that are already aligned.
+struct RgbSource {
+  const uint8_t* data = nullptr;
+  int width = 0;
+  int height = 0;
+  int bytes_per_row = 0;
+
+  static RgbSource From(const MpImage& image) {
+    return {image.data, image.width, image.height, image.bytes_per_row};
+  }
+
+  void Tap(int x, int y, float* rgb) const {
+    const uint8_t* ptr = data + static_cast<size_t>(y) * bytes_per_row +
+                         static_cast<size_t>(x) * 3;
+    rgb[0] = static_cast<float>(ptr[0]);
+    rgb[1] = static_cast<float>(ptr[1]);
+    rgb[2] = static_cast<float>(ptr[2]);
+  }
+};
+
+// BT.601 limited range YUV -> RGB in 8-bit fixed point.
+inline void YuvToRgb(int y, int u, int v, uint8_t* rgb) {
+  const int c = std::max(y - 16, 0);
+  const int d = u - 128;
+  const int e = v - 128;
+  const int r = (298 * c + 409 * e + 128) >> 8;
+  const int g = (298 * c - 100 * d - 208 * e + 128) >> 8;
+  const int b = (298 * c + 516 * d + 128) >> 8;
+  rgb[0] = static_cast<uint8_t>(std::min(std::max(r, 0), 255));
+  rgb[1] = static_cast<uint8_t>(std::min(std::max(g, 0), 255));
+  rgb[2] = static_cast<uint8_t>(std::min(std::max(b, 0), 255));
+}
+
+// YUV 4:2:0: full resolution Y plane + 2x2 subsampled U and V planes. Chroma
+// sample (cx, cy) of either plane is at `cy * uv_bytes_per_row +
+// cx * uv_pixel_stride`, which covers planar (I420/YV12, stride 1) and
+// interleaved (NV21/NV12, stride 2) layouts alike.
+struct YuvSource {
+  static constexpr SourceFormat kFormat = SourceFormat::kYuv420;
+
+  const uint8_t* y = nullptr;
+  const uint8_t* u = nullptr;
+  const uint8_t* v = nullptr;
+  int width = 0;
+  int height = 0;
+  int y_bytes_per_row = 0;
+  int uv_bytes_per_row = 0;
+  int uv_pixel_stride = 1;
+
+  static YuvSource From(const MpNv21Image& image) {
+    return {image.y,     image.vu + 1,          image.vu,
+            image.width, image.height,          image.y_bytes_per_row,
+            image.vu_bytes_per_row, 2};
+  }
+
+  static YuvSource From(const MpYuvImage& image) {
+    return {image.y,     image.u,           image.v,
+            image.width, image.height,      image.y_bytes_per_row,
+            image.uv_bytes_per_row, image.uv_pixel_stride};
+  }
+
+  // True when the chroma planes are one interleaved VU plane, i.e. the
+  // NV21 layout the row conversion kernels read natively.
+  bool IsNv21() const { return uv_pixel_stride == 2 && u == v + 1; }
+
+  void Tap(int x, int y_pos, float* rgb) const {
+    const uint8_t luma = y[static_cast<size_t>(y_pos) * y_bytes_per_row +
+                           static_cast<size_t>(x)];
+    const size_t chroma =
+        static_cast<size_t>(y_pos >> 1) * uv_bytes_per_row +
+        static_cast<size_t>(x >> 1) * uv_pixel_stride;
+    uint8_t pixel[3];
+    YuvToRgb(luma, u[chroma], v[chroma], pixel);
+    rgb[0] = static_cast<float>(pixel[0]);
+    rgb[1] = static_cast<float>(pixel[1]);
+    rgb[2] = static_cast<float>(pixel[2]);
+  }
+};
+
+// Bilinear blend of the taps at (x0, y0)..(x1, y1) with weights (dx, dy),
+// written as one normalized RGB triple.
+template <typename Source>
+inline void BlendTaps(const Source& source,
+                      int x0,
+                      int y0,
+                      int x1,
+                      int y1,
+                      float dx,
+                      float dy,
+                      float* out) {
+  float p00[3];
+  float p10[3];
+  float p01[3];
+  float p11[3];
+  source.Tap(x0, y0, p00);
+  source.Tap(x1, y0, p10);
+  source.Tap(x0, y1, p01);
+  source.Tap(x1, y1, p11);
+  for (int c = 0; c < 3; ++c) {
+    const float top = p00[c] + (p10[c] - p00[c]) * dx;
+    const float bottom = p01[c] + (p11[c] - p01[c]) * dx;
+    out[c] = (top + (bottom - top) * dy) * kPixelScale + kPixelOffset;
+  }
+}
+
+// Bilinear sample at source position (sx, sy) written as one normalized RGB
+// triple. Positions outside the source produce black.
+template <typename Source>
+inline void SampleBilinear(const Source& source, float sx, float sy,
+                           float* out) {
+  if (!(sx >= 0.0f && sy >= 0.0f &&
+        sx <= static_cast<float>(source.width - 1) &&
+        sy <= static_cast<float>(source.height - 1))) {
+    out[0] = kPixelOffset;
+    out[1] = kPixelOffset;
+    out[2] = kPixelOffset;
+    return;
+  }
+  const int x0 = static_cast<int>(sx);
+  const int y0 = static_cast<int>(sy);
+  BlendTaps(source, x0, y0, std::min(x0 + 1, source.width - 1),
+            std::min(y0 + 1, source.height - 1), sx - static_cast<float>(x0),
+            sy - static_cast<float>(y0), out);
+}
+
+// SampleBilinear without the bounds check and tap clamping, for positions
+// the caller knows have all four taps inside (see RowInteriorSpan).
+template <typename Source>
+inline void SampleBilinearInterior(const Source& source, float sx, float sy,
+                                   float* out) {
+  const int x0 = static_cast<int>(sx);
+  const int y0 = static_cast<int>(sy);
+  BlendTaps(source, x0, y0, x0 + 1, y0 + 1, sx - static_cast<float>(x0),
+            sy - static_cast<float>(y0), out);
+}
+
+// Nearest-neighbour sample of the tap at (x, y), which must be inside.
+template <typename Source>
+inline void SampleNearest(const Source& source, int x, int y, float* out) {
+  float rgb[3];
+  source.Tap(x, y, rgb);
+  for (int c = 0; c < 3; ++c) {
+    out[c] = rgb[c] * kPixelScale + kPixelOffset;
+  }
+}
+
+}  // namespace mp
+
+#endif  // PIXEL_SOURCES_H_
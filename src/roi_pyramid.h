@@ -0,0 +1,230 @@
+#ifndef ROI_PYRAMID_H_
+#define ROI_PYRAMID_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image_warp.h"
+#include "row_worker_pool.h"
+
+namespace mp {
+
+namespace simd_internal {
+
+// Averages the 2x2 blocks of packed 4-byte pixels under `top`/`bottom` into
+// up to `count` output pixels, rounding to nearest. Returns how many were
+// written; the caller finishes the rest.
+#if defined(MP_SIMD_SSE2)
+
+inline int HalvePackedSpan(const uint8_t* top,
+                           const uint8_t* bottom,
+                           uint8_t* dst,
+                           int count) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i two = _mm_set1_epi16(2);
+  int x = 0;
+  for (; x + 4 <= count; x += 4) {
+    __m128i halves[2];
+    for (int h = 0; h < 2; ++h) {
+      const size_t offset = static_cast<size_t>(x * 2 + h * 4) * 4;
+      const __m128i a =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + offset));
+      const __m128i b =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + offset));
+      // Column sums of pixels 0/1 and 2/3, then 0+1 next to 2+3.
+      const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                       _mm_unpacklo_epi8(b, zero));
+      const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                       _mm_unpackhi_epi8(b, zero));
+      const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi),
+                                        _mm_unpackhi_epi64(lo, hi));
+      halves[h] = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4),
+                     _mm_packus_epi16(halves[0], halves[1]));
+  }
+  return x;
+}
+
+#elif defined(MP_SIMD_NEON)
+
+inline int HalvePackedSpan(const uint8_t* top,
+                           const uint8_t* bottom,
+                           uint8_t* dst,
+                           int count) {
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    const uint8x16x4_t a = vld4q_u8(top + static_cast<size_t>(x) * 8);
+    const uint8x16x4_t b = vld4q_u8(bottom + static_cast<size_t>(x) * 8);
+    uint8x8x4_t out;
+    for (int c = 0; c < 4; ++c) {
+      out.val[c] =
+          vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[c]), b.val[c]), 2);
+    }
+    vst4_u8(dst + static_cast<size_t>(x) * 4, out);
+  }
+  return x;
+}
+
+#else
+
+inline int HalvePackedSpan(const uint8_t*, const uint8_t*, uint8_t*, int) {
+  return 0;
+}
+
+#endif
+
+// Writes rows [row_begin, row_end) of the 2x box reduction of a packed
+// image. An odd trailing column or row is paired with itself.
+inline void HalvePackedRows(const uint8_t* src,
+                            int src_bytes_per_row,
+                            int src_width,
+                            int src_height,
+                            uint8_t* dst,
+                            int dst_bytes_per_row,
+                            int dst_width,
+                            int row_begin,
+                            int row_end) {
+  for (int y = row_begin; y < row_end; ++y) {
+    const uint8_t* top = src + static_cast<size_t>(y) * 2 * src_bytes_per_row;
+    const uint8_t* bottom =
+        y * 2 + 1 < src_height ? top + src_bytes_per_row : top;
+    uint8_t* out = dst + static_cast<size_t>(y) * dst_bytes_per_row;
+    int x = HalvePackedSpan(top, bottom, out, src_width / 2);
+    for (; x < dst_width; ++x) {
+      const size_t left = static_cast<size_t>(x) * 8;
+      const size_t right =
+          static_cast<size_t>(std::min(x * 2 + 1, src_width - 1)) * 4;
+      for (int c = 0; c < 4; ++c) {
+        out[x * 4 + c] = static_cast<uint8_t>(
+            (top[left + c] + top[right + c] + bottom[left + c] +
+             bottom[right + c] + 2) >>
+            2);
+      }
+    }
+  }
+}
+
+}  // namespace simd_internal
+
+// Anti-aliasing for packed sources when the ROI is much larger than the
+// model input. The raw-space bounding box of the ROI is reduced by repeated
+// 2x box filters until the warp samples fewer than 2 * reduction_scale
+// source pixels per output pixel (see ReductionScale), and the warp then
+// reads that level instead of striding sparsely through the full frame.
+// Levels keep the source's channel order.
+class RoiPyramid {
+ public:
+  // Deepest level built (16x reduction).
+  static constexpr int kMaxLevels = 4;
+
+  // Reduces the region of `source` that `transform` samples for a
+  // `target_width` x `target_height` output. Row bands run on `pool`.
+  // Returns false when the ROI does not reach `reduction_scale` source
+  // pixels per output pixel, in which case the caller should warp `source`
+  // directly.
+  template <int kR, int kB>
+  bool Build(const PackedPixelSource<kR, kB>& source,
+             const WarpTransform& transform,
+             int target_width,
+             int target_height,
+             float reduction_scale,
+             RowWorkerPool& pool) {
+    const float scale = WarpScale(transform);
+    int levels = 0;
+    while (levels < kMaxLevels &&
+           reduction_scale * static_cast<float>(1 << levels) <= scale) {
+      ++levels;
+    }
+    if (levels == 0) {
+      return false;
+    }
+    const SourceBounds bounds =
+        WarpSourceBounds(transform, target_width, target_height);
+    if (!(bounds.min_x <= bounds.max_x && bounds.min_y <= bounds.max_y)) {
+      return false;
+    }
+
+    // One level pixel of margin on each side covers the +1 bilinear tap and
+    // rounding between the corners and the per-row positions.
+    const int factor = 1 << levels;
+    const float margin = static_cast<float>(factor);
+    const float source_width = static_cast<float>(source.width);
+    const float source_height = static_cast<float>(source.height);
+    const int x_begin = static_cast<int>(std::min(
+        std::max(std::floor(bounds.min_x) - margin, 0.0f), source_width));
+    const int y_begin = static_cast<int>(std::min(
+        std::max(std::floor(bounds.min_y) - margin, 0.0f), source_height));
+    const int x_end = static_cast<int>(std::min(
+        std::max(std::floor(bounds.max_x) + 2.0f * margin, 0.0f),
+        source_width));
+    const int y_end = static_cast<int>(std::min(
+        std::max(std::floor(bounds.max_y) + 2.0f * margin, 0.0f),
+        source_height));
+    if (x_end <= x_begin || y_end <= y_begin) {
+      return false;
+    }
+
+    const uint8_t* src = source.data +
+                         static_cast<size_t>(y_begin) * source.bytes_per_row +
+                         static_cast<size_t>(x_begin) * 4;
+    int src_bytes_per_row = source.bytes_per_row;
+    int width = x_end - x_begin;
+    int height = y_end - y_begin;
+    for (int level = 0; level < levels; ++level) {
+      const int level_width = (width + 1) / 2;
+      const int level_height = (height + 1) / 2;
+      const int level_bytes_per_row = level_width * 4;
+      std::vector<uint8_t>& buffer = buffers_[level & 1];
+      buffer.resize(static_cast<size_t>(level_bytes_per_row) * level_height);
+      uint8_t* dst = buffer.data();
+      pool.Run(level_height, [&](int, int row_begin, int row_end) {
+        simd_internal::HalvePackedRows(src, src_bytes_per_row, width, height,
+                                       dst, level_bytes_per_row, level_width,
+                                       row_begin, row_end);
+      });
+      src = dst;
+      src_bytes_per_row = level_bytes_per_row;
+      width = level_width;
+      height = level_height;
+    }
+    data_ = src;
+    width_ = width;
+    height_ = height;
+    bytes_per_row_ = src_bytes_per_row;
+
+    // Level pixel i is centered on raw x_begin + i * factor + (factor-1)/2.
+    const float inverse = 1.0f / static_cast<float>(factor);
+    const float center = static_cast<float>(factor - 1) * 0.5f;
+    WarpTransform to_level;
+    to_level.xx = inverse;
+    to_level.xt = -(static_cast<float>(x_begin) + center) * inverse;
+    to_level.yy = inverse;
+    to_level.yt = -(static_cast<float>(y_begin) + center) * inverse;
+    transform_ = Compose(to_level, transform);
+    return true;
+  }
+
+  // Valid after a successful Build() until the next call.
+  template <int kR, int kB>
+  PackedPixelSource<kR, kB> level() const {
+    return {data_, width_, height_, bytes_per_row_};
+  }
+  const WarpTransform& transform() const { return transform_; }
+
+ private:
+  // Levels alternate between two buffers; only the last one is kept.
+  std::vector<uint8_t> buffers_[2];
+  const uint8_t* data_ = nullptr;
+  int width_ = 0;
+  int height_ = 0;
+  int bytes_per_row_ = 0;
+  WarpTransform transform_;
+};
+
+}  // namespace mp
+
+#endif  // ROI_PYRAMID_H_
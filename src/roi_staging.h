@@ -0,0 +1,131 @@
+#ifndef ROI_STAGING_H_
+#define ROI_STAGING_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image_warp.h"
+#include "yuv_convert.h"
+
+namespace mp {
+
+// Two-stage YUV preprocessing. Instead of converting YUV -> RGB for every
+// bilinear tap, the raw-space bounding box of the ROI is converted once into
+// an RGBA scratch image (box-downsampled when the ROI is much larger than the
+// model input) and the warp then samples that image with the packed kernels.
+// Chroma is read as NV21 rows; other layouts are repacked row by row.
+class YuvRoiStager {
+ public:
+  // Largest downsampling factor; keeps the 16-bit column sums from overflowing.
+  static constexpr int kMaxFactor = 16;
+  // Staging is skipped when the scratch image would exceed this many pixels
+  // per output pixel; converting it would cost more than the taps it saves.
+  static constexpr int kMaxPixelsPerOutput = 16;
+
+  // Converts the region of `source` that `transform` samples for a
+  // `target_width` x `target_height` output, box-downsampling from
+  // `reduction_scale` source pixels per output pixel on. Returns false when
+  // staging does not pay off, in which case the caller should warp `source`
+  // directly. `isa` picks the conversion kernels.
+  bool Stage(const YuvSource& source,
+             const WarpTransform& transform,
+             int target_width,
+             int target_height,
+             float reduction_scale,
+             KernelIsa isa = kBaselineKernelIsa) {
+    const SourceBounds bounds =
+        WarpSourceBounds(transform, target_width, target_height);
+    const float min_x = bounds.min_x;
+    const float min_y = bounds.min_y;
+    const float max_x = bounds.max_x;
+    const float max_y = bounds.max_y;
+    if (!(min_x <= max_x && min_y <= max_y)) {
+      return false;
+    }
+
+    // Keep at least reduction_scale / 2 scratch pixels per output pixel so
+    // the warp still sees the detail the model input can hold.
+    const float scale = WarpScale(transform);
+    int factor = 1;
+    while (factor < kMaxFactor &&
+           static_cast<float>(factor) * reduction_scale <= scale) {
+      factor *= 2;
+    }
+
+    // One pixel of margin on each side covers the +1 bilinear tap and any
+    // rounding between the corners and the per-row positions. Columns and
+    // rows start on a chroma sample. A downsampled box is rounded up to whole
+    // chroma blocks, pulled back inside the frame where possible, and only
+    // repeats edge pixels when the frame is smaller than one block row. The
+    // staged image then ends at the block holding the last frame pixel, so
+    // the warp sees the repeated blocks as outside the frame.
+    int x_begin =
+        static_cast<int>(std::max(std::floor(min_x) - 1.0f, 0.0f)) & ~1;
+    int y_begin =
+        static_cast<int>(std::max(std::floor(min_y) - 1.0f, 0.0f)) & ~1;
+    const int x_end = static_cast<int>(
+        std::min(std::floor(max_x) + 3.0f, static_cast<float>(source.width)));
+    const int y_end = static_cast<int>(
+        std::min(std::floor(max_y) + 3.0f, static_cast<float>(source.height)));
+    if (x_end <= x_begin || y_end <= y_begin) {
+      return false;
+    }
+    const int align = 2 * factor;
+    const int width = AlignUp(x_end - x_begin, factor > 1 ? align : 1);
+    const int height = AlignUp(y_end - y_begin, factor > 1 ? align : 1);
+    if (x_begin + width > source.width) {
+      x_begin = std::max(source.width - width, 0) & ~1;
+    }
+    if (y_begin + height > source.height) {
+      y_begin = std::max(source.height - height, 0) & ~1;
+    }
+    const int staged_width = width / factor;
+    const int staged_height = height / factor;
+    if (static_cast<int64_t>(staged_width) * staged_height >
+        static_cast<int64_t>(kMaxPixelsPerOutput) * target_width *
+            target_height) {
+      return false;
+    }
+
+    rgba_.resize(static_cast<size_t>(staged_width) * staged_height * 4);
+    const int rgba_bytes_per_row = staged_width * 4;
+    ConvertYuvRegion(source, x_begin, y_begin, width, height, factor,
+                     rgba_.data(), rgba_bytes_per_row, &scratch_, isa);
+
+    const int valid_width = std::min(width, source.width - x_begin);
+    const int valid_height = std::min(height, source.height - y_begin);
+    staged_ = {rgba_.data(), (valid_width + factor - 1) / factor,
+               (valid_height + factor - 1) / factor, rgba_bytes_per_row};
+    // Scratch pixel i is centered on raw x_begin + i * factor + (factor-1)/2.
+    const float inverse = 1.0f / static_cast<float>(factor);
+    const float center = static_cast<float>(factor - 1) * 0.5f;
+    WarpTransform to_staged;
+    to_staged.xx = inverse;
+    to_staged.xt = -(static_cast<float>(x_begin) + center) * inverse;
+    to_staged.yy = inverse;
+    to_staged.yt = -(static_cast<float>(y_begin) + center) * inverse;
+    transform_ = Compose(to_staged, transform);
+    return true;
+  }
+
+  // Valid after a successful Stage() until the next call.
+  const RgbaSource& staged() const { return staged_; }
+  const WarpTransform& transform() const { return transform_; }
+
+ private:
+  static int AlignUp(int value, int align) {
+    return (value + align - 1) / align * align;
+  }
+
+  std::vector<uint8_t> rgba_;
+  YuvConvertScratch scratch_;
+  RgbaSource staged_;
+  WarpTransform transform_;
+};
+
+}  // namespace mp
+
+#endif  // ROI_STAGING_H_
@@ -0,0 +1,120 @@
+#ifndef ROW_WORKER_POOL_H_
+#define ROW_WORKER_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mp {
+
+// Persistent threads that split a row range into bands. The calling thread
+// takes bands too, so a pool of N threads runs N-1 workers and a pool of one
+// runs everything inline. Workers sleep on a condition variable between
+// calls; Run() is meant to be called from one thread at a time.
+class RowWorkerPool {
+ public:
+  // Bands narrower than this are not worth waking a worker for.
+  static constexpr int kMinRowsPerBand = 16;
+
+  RowWorkerPool() = default;
+  RowWorkerPool(const RowWorkerPool&) = delete;
+  RowWorkerPool& operator=(const RowWorkerPool&) = delete;
+  ~RowWorkerPool() { Stop(); }
+
+  // Spawns `thread_count - 1` workers. Replaces any previous workers.
+  void Start(int thread_count) {
+    Stop();
+    for (int i = 1; i < thread_count; ++i) {
+      workers_.emplace_back([this] { WorkerLoop(); });
+    }
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+    stop_ = false;
+  }
+
+  int thread_count() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Number of bands Run() splits `rows` into.
+  int BandCount(int rows) const {
+    const int by_size = rows / kMinRowsPerBand;
+    return by_size < 1 ? 1
+                       : (by_size < thread_count() ? by_size : thread_count());
+  }
+
+  // Calls `fn(band, row_begin, row_end)` once per band of [0, rows) and
+  // returns after every band has finished. Bands are indexed from 0 to
+  // BandCount(rows) - 1 so callers can give each its own scratch state.
+  void Run(int rows, const std::function<void(int, int, int)>& fn) {
+    const int bands = BandCount(rows);
+    if (bands <= 1) {
+      fn(0, 0, rows);
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &fn;
+    rows_ = rows;
+    band_count_ = bands;
+    next_band_ = 0;
+    pending_ = bands;
+    wake_.notify_all();
+    while (next_band_ < band_count_) {
+      RunNextBand(lock);
+    }
+    done_.wait(lock, [this] { return pending_ == 0; });
+    task_ = nullptr;
+    band_count_ = 0;
+  }
+
+ private:
+  void WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      wake_.wait(lock, [this] { return stop_ || next_band_ < band_count_; });
+      if (stop_) {
+        return;
+      }
+      RunNextBand(lock);
+    }
+  }
+
+  // Claims the next band under `lock`, runs it unlocked and reports back.
+  void RunNextBand(std::unique_lock<std::mutex>& lock) {
+    const int band = next_band_++;
+    const std::function<void(int, int, int)>& fn = *task_;
+    const int row_begin = rows_ * band / band_count_;
+    const int row_end = rows_ * (band + 1) / band_count_;
+    lock.unlock();
+    fn(band, row_begin, row_end);
+    lock.lock();
+    if (--pending_ == 0) {
+      done_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  const std::function<void(int, int, int)>* task_ = nullptr;
+  int rows_ = 0;
+  int band_count_ = 0;
+  int next_band_ = 0;
+  int pending_ = 0;
+  bool stop_ = false;
+};
+
+}  // namespace mp
+
+#endif  // ROW_WORKER_POOL_H_
@@ -0,0 +1,398 @@
+#ifndef SEPARABLE_RESIZE_H_
+#define SEPARABLE_RESIZE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "image_warp.h"
+
+namespace mp {
+
+namespace simd_internal {
+
+// Horizontal pass over one packed source row: for samples [begin, end),
+// writes planar `r/g/b[i] = lerp(pixel(first[i]), pixel(second[i]),
+// weight[i])`. Returns the index of the first sample not written.
+template <int kR, int kB>
+inline int InterpolatePackedRow(const uint8_t* row,
+                                const int32_t* first,
+                                const int32_t* second,
+                                const float* weight,
+                                int begin,
+                                int end,
+                                float* r,
+                                float* g,
+                                float* b);
+
+// Vertical pass: blends two planar rows with weight `dy`, normalizes and
+// writes interleaved RGB for samples [begin, end) to `out`, which is indexed
+// from sample 0. Returns the index of the first sample not written.
+inline int BlendRows(const float* const* top,
+                     const float* const* bottom,
+                     float dy,
+                     int begin,
+                     int end,
+                     float* out);
+
+#if defined(MP_SIMD_SSE2)
+
+template <int kR, int kB>
+inline int InterpolatePackedRow(const uint8_t* row,
+                                const int32_t* first,
+                                const int32_t* second,
+                                const float* weight,
+                                int begin,
+                                int end,
+                                float* r,
+                                float* g,
+                                float* b) {
+  constexpr int kRed = PackedPixelSource<kR, kB>::kRedShift;
+  constexpr int kBlue = PackedPixelSource<kR, kB>::kBlueShift;
+  int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    const __m128i p0 = _mm_setr_epi32(
+        static_cast<int>(LoadPixel(row + first[i] * 4)),
+        static_cast<int>(LoadPixel(row + first[i + 1] * 4)),
+        static_cast<int>(LoadPixel(row + first[i + 2] * 4)),
+        static_cast<int>(LoadPixel(row + first[i + 3] * 4)));
+    const __m128i p1 = _mm_setr_epi32(
+        static_cast<int>(LoadPixel(row + second[i] * 4)),
+        static_cast<int>(LoadPixel(row + second[i + 1] * 4)),
+        static_cast<int>(LoadPixel(row + second[i + 2] * 4)),
+        static_cast<int>(LoadPixel(row + second[i + 3] * 4)));
+    const __m128 dx = _mm_loadu_ps(weight + i);
+    const __m128 r0 = Channel<kRed>(p0);
+    const __m128 g0 = Channel<8>(p0);
+    const __m128 b0 = Channel<kBlue>(p0);
+    _mm_storeu_ps(r + i, _mm_add_ps(r0, _mm_mul_ps(
+                                            _mm_sub_ps(Channel<kRed>(p1), r0),
+                                            dx)));
+    _mm_storeu_ps(g + i, _mm_add_ps(g0, _mm_mul_ps(
+                                            _mm_sub_ps(Channel<8>(p1), g0),
+                                            dx)));
+    _mm_storeu_ps(b + i, _mm_add_ps(b0, _mm_mul_ps(
+                                            _mm_sub_ps(Channel<kBlue>(p1), b0),
+                                            dx)));
+  }
+  return i;
+}
+
+inline int BlendRows(const float* const* top,
+                     const float* const* bottom,
+                     float dy,
+                     int begin,
+                     int end,
+                     float* out) {
+  const __m128 weight = _mm_set1_ps(dy);
+  const __m128 scale = _mm_set1_ps(kPixelScale);
+  const __m128 offset = _mm_set1_ps(kPixelOffset);
+  int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m128 channel[3];
+    for (int c = 0; c < 3; ++c) {
+      const __m128 t = _mm_loadu_ps(top[c] + i);
+      const __m128 b = _mm_loadu_ps(bottom[c] + i);
+      const __m128 value =
+          _mm_add_ps(t, _mm_mul_ps(_mm_sub_ps(b, t), weight));
+      channel[c] = _mm_add_ps(_mm_mul_ps(value, scale), offset);
+    }
+    StoreRgb(out + i * 3, channel[0], channel[1], channel[2]);
+  }
+  return i;
+}
+
+#elif defined(MP_SIMD_NEON)
+
+template <int kR, int kB>
+inline int InterpolatePackedRow(const uint8_t* row,
+                                const int32_t* first,
+                                const int32_t* second,
+                                const float* weight,
+                                int begin,
+                                int end,
+                                float* r,
+                                float* g,
+                                float* b) {
+  constexpr int kRed = PackedPixelSource<kR, kB>::kRedShift;
+  constexpr int kBlue = PackedPixelSource<kR, kB>::kBlueShift;
+  int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    uint32_t left[4];
+    uint32_t right[4];
+    for (int lane = 0; lane < 4; ++lane) {
+      left[lane] = LoadPixel(row + first[i + lane] * 4);
+      right[lane] = LoadPixel(row + second[i + lane] * 4);
+    }
+    const uint32x4_t p0 = vld1q_u32(left);
+    const uint32x4_t p1 = vld1q_u32(right);
+    const float32x4_t dx = vld1q_f32(weight + i);
+    const float32x4_t r0 = Channel<kRed>(p0);
+    const float32x4_t g0 = Channel<8>(p0);
+    const float32x4_t b0 = Channel<kBlue>(p0);
+    vst1q_f32(r + i,
+              vaddq_f32(r0, vmulq_f32(vsubq_f32(Channel<kRed>(p1), r0), dx)));
+    vst1q_f32(g + i,
+              vaddq_f32(g0, vmulq_f32(vsubq_f32(Channel<8>(p1), g0), dx)));
+    vst1q_f32(b + i,
+              vaddq_f32(b0, vmulq_f32(vsubq_f32(Channel<kBlue>(p1), b0), dx)));
+  }
+  return i;
+}
+
+inline int BlendRows(const float* const* top,
+                     const float* const* bottom,
+                     float dy,
+                     int begin,
+                     int end,
+                     float* out) {
+  const float32x4_t offset = vdupq_n_f32(kPixelOffset);
+  int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    float32x4_t channel[3];
+    for (int c = 0; c < 3; ++c) {
+      const float32x4_t t = vld1q_f32(top[c] + i);
+      const float32x4_t b = vld1q_f32(bottom[c] + i);
+      const float32x4_t value = vaddq_f32(t, vmulq_n_f32(vsubq_f32(b, t), dy));
+      channel[c] = vaddq_f32(vmulq_n_f32(value, kPixelScale), offset);
+    }
+    StoreRgb(out + i * 3, channel[0], channel[1], channel[2]);
+  }
+  return i;
+}
+
+#else
+
+template <int kR, int kB>
+inline int InterpolatePackedRow(const uint8_t*,
+                                const int32_t*,
+                                const int32_t*,
+                                const float*,
+                                int begin,
+                                int,
+                                float*,
+                                float*,
+                                float*) {
+  return begin;
+}
+
+inline int BlendRows(const float* const*,
+                     const float* const*,
+                     float,
+                     int begin,
+                     int,
+                     float*) {
+  return begin;
+}
+
+#endif  // MP_SIMD_SSE2 / MP_SIMD_NEON
+
+}  // namespace simd_internal
+
+// Bilinear resampler for warps whose output rows and columns each follow a
+// single source axis: an unrotated ROI under any 0/90/180/270 camera
+// rotation and mirror. Source taps and weights are computed once per output
+// column and per output row, each source row is interpolated horizontally
+// once and kept while consecutive output lines reuse it, and the vertical
+// pass is a plain blend of two cached rows. Same arithmetic as WarpBilinear,
+// so the two paths agree to float rounding.
+class SeparableResampler {
+ public:
+  static bool Supports(const WarpTransform& m) {
+    return (m.xy == 0.0f && m.yx == 0.0f) || (m.xx == 0.0f && m.yy == 0.0f);
+  }
+
+  // Same contract as WarpBilinear; `m` must satisfy Supports().
+  template <typename Source>
+  void Run(const Source& source,
+           const WarpTransform& m,
+           float* dst,
+           int dst_width,
+           int row_begin,
+           int row_end) {
+    // "Lines" are the output pixels that share a source row; "samples" run
+    // along a line and step through source columns. Without a transpose a
+    // line is an output row, otherwise it is an output column.
+    const bool transposed = m.xx == 0.0f;
+    const int band = row_end - row_begin;
+    if (band <= 0 || dst_width <= 0) {
+      return;
+    }
+    const int sample_count = transposed ? band : dst_width;
+    const int line_count = transposed ? dst_width : band;
+    BuildAxis(transposed ? m.xy : m.xx, m.xt, transposed ? row_begin : 0,
+              sample_count, source.width, &samples_);
+    BuildAxis(transposed ? m.yx : m.yy, m.yt, transposed ? 0 : row_begin,
+              line_count, source.height, &lines_);
+
+    const size_t row_stride = static_cast<size_t>(dst_width) * 3;
+    const size_t sample_stride = transposed ? row_stride : 3;
+    const size_t line_stride = transposed ? 3 : row_stride;
+    float* origin = dst + static_cast<size_t>(row_begin) * row_stride;
+
+    plane_stride_ = static_cast<size_t>(sample_count);
+    cached_rows_.resize(plane_stride_ * 3 * 2);
+    cached_index_[0] = -1;
+    cached_index_[1] = -1;
+    for (int line = 0; line < line_count; ++line) {
+      float* out = origin + static_cast<size_t>(line) * line_stride;
+      if (line < lines_.begin || line >= lines_.end) {
+        FillBlack(out, sample_stride, 0, sample_count);
+        continue;
+      }
+      const int top_row = lines_.first[line];
+      const int bottom_row = lines_.second[line];
+      int bottom_slot = FindRow(bottom_row);
+      int top_slot = FindRow(top_row);
+      if (top_slot < 0) {
+        top_slot = bottom_slot == 0 ? 1 : 0;
+        FillRow(source, top_row, top_slot);
+      }
+      if (bottom_row == top_row) {
+        bottom_slot = top_slot;
+      } else if (bottom_slot < 0) {
+        bottom_slot = 1 - top_slot;
+        FillRow(source, bottom_row, bottom_slot);
+      }
+      const float* top[3];
+      const float* bottom[3];
+      for (int c = 0; c < 3; ++c) {
+        top[c] = Plane(top_slot, c);
+        bottom[c] = Plane(bottom_slot, c);
+      }
+      const float dy = lines_.weight[line];
+      FillBlack(out, sample_stride, 0, samples_.begin);
+      int i = samples_.begin;
+      if (!transposed) {
+        i = simd_internal::BlendRows(top, bottom, dy, i, samples_.end, out);
+      }
+      for (; i < samples_.end; ++i) {
+        float* pixel = out + static_cast<size_t>(i) * sample_stride;
+        for (int c = 0; c < 3; ++c) {
+          const float t = top[c][i];
+          const float b = bottom[c][i];
+          pixel[c] = (t + (b - t) * dy) * kPixelScale + kPixelOffset;
+        }
+      }
+      FillBlack(out, sample_stride, samples_.end, sample_count);
+    }
+  }
+
+ private:
+  // Per output position along one axis: the two source taps and the blend
+  // weight. Positions inside the source form the range [begin, end).
+  struct Axis {
+    std::vector<int32_t> first;
+    std::vector<int32_t> second;
+    std::vector<float> weight;
+    int begin = 0;
+    int end = 0;
+  };
+
+  // Positions are `step * index + offset` for index in
+  // [index_first, index_first + count), evaluated exactly as WarpBilinear
+  // does so both paths pick the same taps.
+  static void BuildAxis(float step,
+                        float offset,
+                        int index_first,
+                        int count,
+                        int size,
+                        Axis* axis) {
+    axis->first.assign(static_cast<size_t>(count), 0);
+    axis->second.assign(static_cast<size_t>(count), 0);
+    axis->weight.assign(static_cast<size_t>(count), 0.0f);
+    axis->begin = count;
+    axis->end = count;
+    const float last = static_cast<float>(size - 1);
+    bool seen = false;
+    for (int i = 0; i < count; ++i) {
+      const float position =
+          step * static_cast<float>(index_first + i) + offset;
+      if (!(position >= 0.0f && position <= last)) {
+        // The position is linear in i, so the inside range is contiguous.
+        if (seen && axis->end == count) {
+          axis->end = i;
+        }
+        continue;
+      }
+      if (!seen) {
+        axis->begin = i;
+        seen = true;
+      }
+      const int tap = static_cast<int>(position);
+      axis->first[i] = tap;
+      axis->second[i] = tap < size - 1 ? tap + 1 : tap;
+      axis->weight[i] = position - static_cast<float>(tap);
+    }
+    if (!seen) {
+      axis->begin = 0;
+      axis->end = 0;
+    }
+  }
+
+  static void FillBlack(float* out, size_t stride, int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      float* pixel = out + static_cast<size_t>(i) * stride;
+      pixel[0] = kPixelOffset;
+      pixel[1] = kPixelOffset;
+      pixel[2] = kPixelOffset;
+    }
+  }
+
+  int FindRow(int row) const {
+    if (cached_index_[0] == row) {
+      return 0;
+    }
+    if (cached_index_[1] == row) {
+      return 1;
+    }
+    return -1;
+  }
+
+  float* Plane(int slot, int channel) {
+    return cached_rows_.data() + (static_cast<size_t>(slot) * 3 + channel) *
+                                     plane_stride_;
+  }
+
+  // Horizontally interpolates source row `row` at every inside sample.
+  template <typename Source>
+  void FillRow(const Source& source, int row, int slot) {
+    FillRowTail(source, row, slot, samples_.begin);
+  }
+
+  template <int kR, int kB>
+  void FillRow(const PackedPixelSource<kR, kB>& source, int row, int slot) {
+    const int done = simd_internal::InterpolatePackedRow<kR, kB>(
+        source.data + static_cast<size_t>(row) * source.bytes_per_row,
+        samples_.first.data(), samples_.second.data(), samples_.weight.data(),
+        samples_.begin, samples_.end, Plane(slot, 0), Plane(slot, 1),
+        Plane(slot, 2));
+    FillRowTail(source, row, slot, done);
+  }
+
+  template <typename Source>
+  void FillRowTail(const Source& source, int row, int slot, int begin) {
+    float* planes[3] = {Plane(slot, 0), Plane(slot, 1), Plane(slot, 2)};
+    for (int i = begin; i < samples_.end; ++i) {
+      float p0[3];
+      float p1[3];
+      source.Tap(samples_.first[i], row, p0);
+      source.Tap(samples_.second[i], row, p1);
+      const float dx = samples_.weight[i];
+      for (int c = 0; c < 3; ++c) {
+        planes[c][i] = p0[c] + (p1[c] - p0[c]) * dx;
+      }
+    }
+    cached_index_[slot] = row;
+  }
+
+  Axis samples_;
+  Axis lines_;
+  std::vector<float> cached_rows_;
+  size_t plane_stride_ = 0;
+  int cached_index_[2] = {-1, -1};
+};
+
+}  // namespace mp
+
+#endif  // SEPARABLE_RESIZE_H_
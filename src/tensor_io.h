@@ -0,0 +1,347 @@
+#ifndef TENSOR_IO_H_
+#define TENSOR_IO_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "bilinear_simd.h"
+
+// Hardware float <-> half conversion. On x86 it is F16C, which is part of
+// KernelIsa::kAvx2.
+#if defined(MP_SIMD_NEON) && \
+    (defined(__aarch64__) || (defined(__ARM_FP) && (__ARM_FP & 2)))
+#define MP_SIMD_NEON_FP16 1
+#endif
+
+namespace mp {
+
+// Element types the model's input and outputs may use. Integer tensors are
+// affine-quantized: real = scale * (q - zero_point).
+enum class TensorElement {
+  kFloat32,
+  kFloat16,
+  kUint8,
+  kInt8,
+};
+
+struct TensorEncoding {
+  TensorElement element = TensorElement::kFloat32;
+  float scale = 1.0f;
+  int32_t zero_point = 0;
+
+  // Whether values go through a float32 buffer on the CPU side.
+  bool needs_conversion() const { return element != TensorElement::kFloat32; }
+  bool quantized() const {
+    return element == TensorElement::kUint8 || element == TensorElement::kInt8;
+  }
+  size_t element_size() const {
+    switch (element) {
+      case TensorElement::kFloat32:
+        return sizeof(float);
+      case TensorElement::kFloat16:
+        return sizeof(uint16_t);
+      default:
+        return 1;
+    }
+  }
+  // Range of q. Both integer types span 256 values.
+  float lowest() const {
+    return element == TensorElement::kInt8 ? -128.0f : 0.0f;
+  }
+};
+
+// IEEE binary16 conversion, rounding to nearest even like the hardware
+// instructions. NaN stays NaN; overflow goes to infinity.
+inline uint16_t FloatToHalf(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint32_t sign = (bits >> 16) & 0x8000u;
+  bits &= 0x7FFFFFFFu;
+  if (bits >= 0x7F800000u) {
+    return static_cast<uint16_t>(sign | 0x7C00u |
+                                 (bits > 0x7F800000u ? 0x200u : 0u));
+  }
+  if (bits >= 0x477FF000u) {
+    return static_cast<uint16_t>(sign | 0x7C00u);
+  }
+  if (bits < 0x38800000u) {
+    // Below the smallest normal half: count units of 2^-24.
+    if (bits < 0x33000000u) {
+      return static_cast<uint16_t>(sign);
+    }
+    const uint32_t mantissa = (bits & 0x7FFFFFu) | 0x800000u;
+    const uint32_t shift = 126u - (bits >> 23);
+    uint32_t half = mantissa >> shift;
+    const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+    const uint32_t halfway = 1u << (shift - 1u);
+    if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+      ++half;
+    }
+    return static_cast<uint16_t>(sign | half);
+  }
+  // Rebias the exponent; a rounding carry may step into the next exponent.
+  bits -= 112u << 23;
+  uint32_t half = bits >> 13;
+  const uint32_t remainder = bits & 0x1FFFu;
+  if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+    ++half;
+  }
+  return static_cast<uint16_t>(sign | half);
+}
+
+inline float HalfToFloat(uint16_t half) {
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1Fu;
+  const uint32_t mantissa = half & 0x3FFu;
+  uint32_t bits;
+  if (exponent == 0x1Fu) {
+    bits = sign | 0x7F800000u | (mantissa << 13);
+  } else if (exponent != 0) {
+    bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+  } else {
+    const float magnitude =
+        static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+    std::memcpy(&bits, &magnitude, sizeof(bits));
+    bits |= sign;
+  }
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+namespace simd_internal {
+
+// Converts up to `count` values between float and half. Return how many
+// were converted; the caller finishes the rest.
+#if defined(MP_SIMD_AVX2)
+
+MP_TARGET_AVX2 inline int FloatToHalfSpanF16c(const float* src,
+                                              int count,
+                                              uint16_t* dst) {
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    const __m128i lo =
+        _mm_cvtps_ph(_mm_loadu_ps(src + x), _MM_FROUND_TO_NEAREST_INT);
+    const __m128i hi =
+        _mm_cvtps_ph(_mm_loadu_ps(src + x + 4), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                     _mm_unpacklo_epi64(lo, hi));
+  }
+  return x;
+}
+
+MP_TARGET_AVX2 inline int HalfToFloatSpanF16c(const uint16_t* src,
+                                              int count,
+                                              float* dst) {
+  int x = 0;
+  for (; x + 4 <= count; x += 4) {
+    _mm_storeu_ps(dst + x, _mm_cvtph_ps(_mm_loadl_epi64(
+                               reinterpret_cast<const __m128i*>(src + x))));
+  }
+  return x;
+}
+
+#else
+
+inline int FloatToHalfSpanF16c(const float*, int, uint16_t*) { return 0; }
+inline int HalfToFloatSpanF16c(const uint16_t*, int, float*) { return 0; }
+
+#endif  // MP_SIMD_AVX2
+
+#if defined(MP_SIMD_NEON_FP16)
+
+inline int FloatToHalfSpan(const float* src, int count, uint16_t* dst) {
+  int x = 0;
+  for (; x + 4 <= count; x += 4) {
+    vst1_u16(dst + x, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + x))));
+  }
+  return x;
+}
+
+inline int HalfToFloatSpan(const uint16_t* src, int count, float* dst) {
+  int x = 0;
+  for (; x + 4 <= count; x += 4) {
+    vst1q_f32(dst + x, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + x))));
+  }
+  return x;
+}
+
+#else
+
+inline int FloatToHalfSpan(const float*, int, uint16_t*) { return 0; }
+inline int HalfToFloatSpan(const uint16_t*, int, float*) { return 0; }
+
+#endif
+
+// Quantizes up to `count` values into `dst` as unsigned bytes offset by
+// -lowest(); the caller flips the sign bit for int8. Values are clamped
+// before rounding, so every path rounds half up and matches the scalar
+// tail exactly. Returns how many were written.
+#if defined(MP_SIMD_SSE2)
+
+inline int QuantizeSpan(const float* src,
+                        int count,
+                        float inverse_scale,
+                        float offset,
+                        float lowest,
+                        uint8_t* dst) {
+  const __m128i sign_bit =
+      _mm_set1_epi8(static_cast<char>(lowest < 0.0f ? 0x80 : 0x00));
+  const __m128 multiplier = _mm_set1_ps(inverse_scale);
+  const __m128 shift = _mm_set1_ps(offset - lowest + 0.5f);
+  const __m128 low = _mm_set1_ps(0.5f);
+  const __m128 high = _mm_set1_ps(255.5f);
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    __m128i q[4];
+    for (int i = 0; i < 4; ++i) {
+      const __m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + x + i * 4),
+                                             multiplier),
+                                  shift);
+      q[i] = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, low), high));
+    }
+    const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]),
+                                           _mm_packs_epi32(q[2], q[3]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x),
+                     _mm_xor_si128(bytes, sign_bit));
+  }
+  return x;
+}
+
+#elif defined(MP_SIMD_NEON)
+
+inline int QuantizeSpan(const float* src,
+                        int count,
+                        float inverse_scale,
+                        float offset,
+                        float lowest,
+                        uint8_t* dst) {
+  const uint8x16_t sign_bit = vdupq_n_u8(lowest < 0.0f ? 0x80 : 0x00);
+  const float32x4_t shift = vdupq_n_f32(offset - lowest + 0.5f);
+  const float32x4_t low = vdupq_n_f32(0.5f);
+  const float32x4_t high = vdupq_n_f32(255.5f);
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    uint32x4_t q[4];
+    for (int i = 0; i < 4; ++i) {
+      const float32x4_t v = vaddq_f32(
+          vmulq_n_f32(vld1q_f32(src + x + i * 4), inverse_scale), shift);
+      q[i] = vcvtq_u32_f32(vminq_f32(vmaxq_f32(v, low), high));
+    }
+    const uint16x8_t lo = vcombine_u16(vmovn_u32(q[0]), vmovn_u32(q[1]));
+    const uint16x8_t hi = vcombine_u16(vmovn_u32(q[2]), vmovn_u32(q[3]));
+    vst1q_u8(dst + x,
+             veorq_u8(vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)), sign_bit));
+  }
+  return x;
+}
+
+#else
+
+inline int QuantizeSpan(const float*, int, float, float, float, uint8_t*) {
+  return 0;
+}
+
+#endif
+
+}  // namespace simd_internal
+
+// Writes `count` real values to `dst` in `encoding`, rounding to nearest and
+// saturating integer types.
+inline void EncodeTensorValues(const float* src,
+                               int count,
+                               const TensorEncoding& encoding,
+                               void* dst,
+                               KernelIsa isa = kBaselineKernelIsa) {
+  if (encoding.element == TensorElement::kFloat32) {
+    std::copy(src, src + count, static_cast<float*>(dst));
+    return;
+  }
+  if (encoding.element == TensorElement::kFloat16) {
+    uint16_t* out = static_cast<uint16_t*>(dst);
+    int x = isa == KernelIsa::kAvx2
+                ? simd_internal::FloatToHalfSpanF16c(src, count, out)
+                : simd_internal::FloatToHalfSpan(src, count, out);
+    for (; x < count; ++x) {
+      out[x] = FloatToHalf(src[x]);
+    }
+    return;
+  }
+  uint8_t* out = static_cast<uint8_t*>(dst);
+  const float inverse_scale = 1.0f / encoding.scale;
+  const float offset = static_cast<float>(encoding.zero_point);
+  const float lowest = encoding.lowest();
+  const uint8_t sign_bit = lowest < 0.0f ? 0x80 : 0x00;
+  int x = simd_internal::QuantizeSpan(src, count, inverse_scale, offset,
+                                      lowest, out);
+  for (; x < count; ++x) {
+    const float v = std::min(
+        std::max(src[x] * inverse_scale + (offset - lowest + 0.5f), 0.5f),
+        255.5f);
+    out[x] = static_cast<uint8_t>(static_cast<uint32_t>(v) ^ sign_bit);
+  }
+}
+
+// Reads `count` values stored in `encoding` back as reals.
+inline void DecodeTensorValues(const void* src,
+                               int count,
+                               const TensorEncoding& encoding,
+                               float* dst,
+                               KernelIsa isa = kBaselineKernelIsa) {
+  switch (encoding.element) {
+    case TensorElement::kFloat32: {
+      const float* in = static_cast<const float*>(src);
+      std::copy(in, in + count, dst);
+      return;
+    }
+    case TensorElement::kFloat16: {
+      const uint16_t* in = static_cast<const uint16_t*>(src);
+      int i = isa == KernelIsa::kAvx2
+                  ? simd_internal::HalfToFloatSpanF16c(in, count, dst)
+                  : simd_internal::HalfToFloatSpan(in, count, dst);
+      for (; i < count; ++i) {
+        dst[i] = HalfToFloat(in[i]);
+      }
+      return;
+    }
+    case TensorElement::kUint8: {
+      const uint8_t* in = static_cast<const uint8_t*>(src);
+      for (int i = 0; i < count; ++i) {
+        dst[i] = encoding.scale *
+                 static_cast<float>(static_cast<int32_t>(in[i]) -
+                                    encoding.zero_point);
+      }
+      return;
+    }
+    case TensorElement::kInt8: {
+      const int8_t* in = static_cast<const int8_t*>(src);
+      for (int i = 0; i < count; ++i) {
+        dst[i] = encoding.scale *
+                 static_cast<float>(static_cast<int32_t>(in[i]) -
+                                    encoding.zero_point);
+      }
+      return;
+    }
+  }
+}
+
+// Inverse of the pixel normalization (kPixelScale, kPixelOffset): writes
+// `count` tensor values back as bytes, rounding to nearest and saturating.
+inline void DenormalizePixels(const float* src, int count, uint8_t* dst) {
+  const float inverse_scale = 1.0f / kPixelScale;
+  const float offset = -kPixelOffset * inverse_scale;
+  int x = simd_internal::QuantizeSpan(src, count, inverse_scale, offset, 0.0f,
+                                      dst);
+  for (; x < count; ++x) {
+    const float v =
+        std::min(std::max(src[x] * inverse_scale + (offset + 0.5f), 0.5f),
+                 255.5f);
+    dst[x] = static_cast<uint8_t>(v);
+  }
+}
+
+}  // namespace mp
+
+#endif  // TENSOR_IO_H_
@@ -0,0 +1,280 @@
+#ifndef TFLITE_REGISTRY_H_
+#define TFLITE_REGISTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "tflite_runtime.h"
+
+// A TfLiteModel together with the bytes it was built from. TfLiteModelCreate
+// reads the buffer for the model's whole lifetime, so both live and die
+// together; models created from a file map it themselves and leave `bytes`
+// empty. The runtime is kept alive for the final ModelDelete.
+struct SharedTfLiteModel {
+  SharedTfLiteModel() = default;
+  SharedTfLiteModel(const SharedTfLiteModel&) = delete;
+  SharedTfLiteModel& operator=(const SharedTfLiteModel&) = delete;
+  ~SharedTfLiteModel() {
+    if (model) {
+      runtime->ModelDelete(model);
+    }
+  }
+
+  std::shared_ptr<TfLiteRuntime> runtime;
+  std::vector<uint8_t> bytes;
+  // Size and content hash of the model data, in memory or on disk; the hash
+  // also keys on-disk caches derived from it.
+  size_t size = 0;
+  uint64_t hash = 0;
+  TfLiteModel* model = nullptr;
+};
+
+// Process-wide cache of loaded runtimes and models. Every context used to
+// dlopen the runtime, resolve its symbols and build its own TfLiteModel;
+// with several streams per process that multiplied startup time and model
+// memory. Runtimes are loaded once per library path and stay loaded for the
+// life of the process. Models are shared by content: contexts loading the
+// same bytes through the same runtime get one TfLiteModel (each still builds
+// its own interpreter), which is deleted when the last of them lets go.
+// Models loaded from a file are created from the file, which the runtime
+// maps instead of copying, and are shared by path instead: reopening an
+// unchanged file reuses the model without reading it.
+class TfLiteRegistry {
+ public:
+  static TfLiteRegistry& Get() {
+    // Never destroyed, so contexts torn down during exit cannot outlive it.
+    static TfLiteRegistry* registry = new TfLiteRegistry();
+    return *registry;
+  }
+
+  // Returns the runtime for `library_path` (null or empty for the platform
+  // default), loading it on first use. On failure returns null and sets
+  // `error`.
+  std::shared_ptr<TfLiteRuntime> AcquireRuntime(const char* library_path,
+                                                std::string* error) {
+    const std::string key = library_path ? library_path : "";
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<TfLiteRuntime>& runtime = runtimes_[key];
+    if (runtime) {
+      return runtime;
+    }
+    auto loaded = std::make_shared<TfLiteRuntime>();
+    if (!loaded->Load(key.empty() ? nullptr : key.c_str())) {
+      *error = loaded->error();
+      runtimes_.erase(key);
+      return nullptr;
+    }
+    runtime = loaded;
+    return runtime;
+  }
+
+  // Returns the shared model for the file at `path`. A live model loaded from
+  // the same path through `runtime` is reused while the file's size, mtime
+  // and inode are unchanged; otherwise the file is hashed in chunks and the
+  // model created from it. On failure returns null and sets `error`.
+  std::shared_ptr<SharedTfLiteModel> AcquireModelFromFile(
+      const std::shared_ptr<TfLiteRuntime>& runtime,
+      const std::string& path,
+      std::string* error) {
+    // Stamped before hashing, so a file rewritten in between is recorded
+    // with the old stamp and loaded again next time.
+    FileStamp stamp;
+    const bool stamped = StatFile(path, &stamp);
+    if (stamped) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (std::shared_ptr<SharedTfLiteModel> cached =
+              FindFile(runtime, path, stamp)) {
+        return cached;
+      }
+    }
+
+    auto shared = std::make_shared<SharedTfLiteModel>();
+    shared->runtime = runtime;
+    if (!HashFile(path, &shared->hash, &shared->size, error)) {
+      return nullptr;
+    }
+    shared->model = runtime->ModelCreateFromFile(path.c_str());
+    if (!shared->model) {
+      *error = "TfLiteModelCreateFromFile rejected the model file";
+      return nullptr;
+    }
+    if (stamped) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // Another context may have loaded the same revision meanwhile.
+      if (std::shared_ptr<SharedTfLiteModel> cached =
+              FindFile(runtime, path, stamp)) {
+        return cached;
+      }
+      files_[path] = {stamp, shared};
+    }
+    return shared;
+  }
+
+  // Returns the shared model for `bytes`, building it from them when no
+  // live model has the same content.
+  std::shared_ptr<SharedTfLiteModel> AcquireModel(
+      const std::shared_ptr<TfLiteRuntime>& runtime,
+      std::vector<uint8_t> bytes,
+      std::string* error) {
+    const uint64_t hash = HashBytes(bytes.data(), bytes.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto range = models_.equal_range(hash);
+    for (auto it = range.first; it != range.second;) {
+      std::shared_ptr<SharedTfLiteModel> cached = it->second.lock();
+      if (!cached) {
+        it = models_.erase(it);
+        continue;
+      }
+      if (cached->runtime == runtime && cached->bytes.size() == bytes.size() &&
+          std::memcmp(cached->bytes.data(), bytes.data(), bytes.size()) ==
+              0) {
+        return cached;
+      }
+      ++it;
+    }
+
+    auto shared = std::make_shared<SharedTfLiteModel>();
+    shared->runtime = runtime;
+    shared->bytes = std::move(bytes);
+    shared->size = shared->bytes.size();
+    shared->hash = hash;
+    shared->model = runtime->ModelCreate(shared->bytes.data(),
+                                         shared->bytes.size());
+    if (!shared->model) {
+      *error = "TfLiteModelCreate rejected the model data";
+      return nullptr;
+    }
+    models_.emplace(hash, shared);
+    return shared;
+  }
+
+ private:
+  TfLiteRegistry() = default;
+
+  // What identifies a file's revision without reading it. `mtime` is in
+  // nanoseconds where the platform keeps them, seconds otherwise; the inode
+  // catches files replaced by rename and is 0 on Windows.
+  struct FileStamp {
+    int64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t inode = 0;
+
+    bool operator==(const FileStamp& other) const {
+      return size == other.size && mtime == other.mtime &&
+             inode == other.inode;
+    }
+  };
+
+  struct FileEntry {
+    FileStamp stamp;
+    std::weak_ptr<SharedTfLiteModel> model;
+  };
+
+  // Live model recorded for `path` with `runtime` and `stamp`, or null.
+  // Drops the entry once its model is gone. Called with `mutex_` held.
+  std::shared_ptr<SharedTfLiteModel> FindFile(
+      const std::shared_ptr<TfLiteRuntime>& runtime,
+      const std::string& path,
+      const FileStamp& stamp) {
+    auto it = files_.find(path);
+    if (it == files_.end()) {
+      return nullptr;
+    }
+    std::shared_ptr<SharedTfLiteModel> cached = it->second.model.lock();
+    if (!cached) {
+      files_.erase(it);
+      return nullptr;
+    }
+    if (cached->runtime != runtime || !(it->second.stamp == stamp)) {
+      return nullptr;
+    }
+    return cached;
+  }
+
+  static bool StatFile(const std::string& path, FileStamp* stamp) {
+#if defined(_WIN32)
+    struct _stat64 info;
+    if (_stat64(path.c_str(), &info) != 0) {
+      return false;
+    }
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+      return false;
+    }
+#endif
+    stamp->size = static_cast<int64_t>(info.st_size);
+    stamp->mtime = static_cast<int64_t>(info.st_mtime) * 1000000000;
+#if defined(__APPLE__)
+    stamp->mtime += info.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+    stamp->mtime += info.st_mtim.tv_nsec;
+#endif
+    stamp->inode = static_cast<uint64_t>(info.st_ino);
+    return true;
+  }
+
+  static constexpr uint64_t kHashSeed = 14695981039346656037ull;
+
+  // 64-bit FNV-1a, continuing from `hash`. Only buckets the cache; matches
+  // are confirmed bytewise.
+  static uint64_t HashBytes(const uint8_t* data,
+                            size_t size,
+                            uint64_t hash = kHashSeed) {
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+  }
+
+  // HashBytes over the file at `path`, read in fixed-size chunks so the model
+  // is never held in memory. Fails with `error` set on an unreadable or empty
+  // file.
+  static bool HashFile(const std::string& path,
+                       uint64_t* hash,
+                       size_t* size,
+                       std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      *error = "cannot open file";
+      return false;
+    }
+    std::vector<uint8_t> chunk(64 * 1024);
+    *hash = kHashSeed;
+    *size = 0;
+    while (file) {
+      file.read(reinterpret_cast<char*>(chunk.data()),
+                static_cast<std::streamsize>(chunk.size()));
+      const size_t count = static_cast<size_t>(file.gcount());
+      *hash = HashBytes(chunk.data(), count, *hash);
+      *size += count;
+    }
+    if (!file.eof()) {
+      *error = "read failed";
+      return false;
+    }
+    if (*size == 0) {
+      *error = "file is empty";
+      return false;
+    }
+    return true;
+  }
+
+  std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<TfLiteRuntime>> runtimes_;
+  std::multimap<uint64_t, std::weak_ptr<SharedTfLiteModel>> models_;
+  std::map<std::string, FileEntry> files_;
+};
+
+#endif  // TFLITE_REGISTRY_H_
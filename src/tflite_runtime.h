@@ -27,6 +27,8 @@
 // Lightweight wrapper that loads the TensorFlow Lite C API at runtime.
 class TfLiteRuntime {
  public:
+  using VersionFn = const char* (*)();
+  using ModelCreateFn = TfLiteModel* (*)(const void*, size_t);
   using ModelCreateFromFileFn = TfLiteModel* (*)(const char*);
   using ModelDeleteFn = void (*)(TfLiteModel*);
   using InterpreterOptionsCreateFn = TfLiteInterpreterOptions* (*)();
@@ -52,6 +54,8 @@ class TfLiteRuntime {
   using TensorCopyFromBufferFn = TfLiteStatus (*)(TfLiteTensor*, const void*, size_t);
   using TensorCopyToBufferFn =
       TfLiteStatus (*)(const TfLiteTensor*, void*, size_t);
+  using TensorQuantizationParamsFn =
+      TfLiteQuantizationParams (*)(const TfLiteTensor*);
   using InterpreterOptionsAddDelegateFn =
       void (*)(TfLiteInterpreterOptions*, TfLiteOpaqueDelegate*);
   using XnnpackDelegateCreateFn =
@@ -155,6 +159,8 @@ class TfLiteRuntime {
 #endif
       handle_ = nullptr;
     }
+    Version = nullptr;
+    ModelCreate = nullptr;
     ModelCreateFromFile = nullptr;
     ModelDelete = nullptr;
     InterpreterOptionsCreate = nullptr;
@@ -175,6 +181,7 @@ class TfLiteRuntime {
     TensorData = nullptr;
     TensorCopyFromBuffer = nullptr;
     TensorCopyToBuffer = nullptr;
+    TensorQuantizationParams = nullptr;
     InterpreterOptionsAddDelegate = nullptr;
     XnnpackDelegateCreate = nullptr;
     XnnpackDelegateDelete = nullptr;
@@ -186,6 +193,8 @@ class TfLiteRuntime {
 
   std::string error() const { return error_; }
 
+  VersionFn Version = nullptr;
+  ModelCreateFn ModelCreate = nullptr;
   ModelCreateFromFileFn ModelCreateFromFile = nullptr;
   ModelDeleteFn ModelDelete = nullptr;
   InterpreterOptionsCreateFn InterpreterOptionsCreate = nullptr;
@@ -206,6 +215,7 @@ class TfLiteRuntime {
   TensorDataFn TensorData = nullptr;
   TensorCopyFromBufferFn TensorCopyFromBuffer = nullptr;
   TensorCopyToBufferFn TensorCopyToBuffer = nullptr;
+  TensorQuantizationParamsFn TensorQuantizationParams = nullptr;
   InterpreterOptionsAddDelegateFn InterpreterOptionsAddDelegate = nullptr;
   XnnpackDelegateCreateFn XnnpackDelegateCreate = nullptr;
   XnnpackDelegateDeleteFn XnnpackDelegateDelete = nullptr;
@@ -216,6 +226,8 @@ class TfLiteRuntime {
 
  private:
   bool LoadSymbols() {
+    ModelCreate =
+        reinterpret_cast<ModelCreateFn>(LoadSymbol("TfLiteModelCreate"));
     ModelCreateFromFile =
         reinterpret_cast<ModelCreateFromFileFn>(LoadSymbol("TfLiteModelCreateFromFile"));
     ModelDelete = reinterpret_cast<ModelDeleteFn>(LoadSymbol("TfLiteModelDelete"));
@@ -254,6 +266,11 @@ class TfLiteRuntime {
         LoadSymbol("TfLiteTensorCopyFromBuffer"));
     TensorCopyToBuffer =
         reinterpret_cast<TensorCopyToBufferFn>(LoadSymbol("TfLiteTensorCopyToBuffer"));
+    // Only keys the XNNPACK weight cache.
+    Version = reinterpret_cast<VersionFn>(LoadSymbolOptional("TfLiteVersion"));
+    // Only needed for quantized models; checked when one is loaded.
+    TensorQuantizationParams = reinterpret_cast<TensorQuantizationParamsFn>(
+        LoadSymbolOptional("TfLiteTensorQuantizationParams"));
     XnnpackDelegateCreate = reinterpret_cast<XnnpackDelegateCreateFn>(
         LoadSymbolOptional("TfLiteXNNPackDelegateCreate"));
     XnnpackDelegateDelete = reinterpret_cast<XnnpackDelegateDeleteFn>(
@@ -267,7 +284,7 @@ class TfLiteRuntime {
     GpuDelegateV2OptionsDefault = reinterpret_cast<GpuDelegateV2OptionsDefaultFn>(
         LoadSymbolOptional("TfLiteGpuDelegateOptionsV2Default"));
 
-    if (!ModelCreateFromFile || !ModelDelete || !InterpreterOptionsCreate ||
+    if (!ModelCreate || !ModelCreateFromFile || !ModelDelete || !InterpreterOptionsCreate ||
         !InterpreterOptionsDelete || !InterpreterOptionsSetThreads ||
         !InterpreterOptionsAddDelegate || !InterpreterCreate || !InterpreterDelete ||
         !InterpreterAllocateTensors || !InterpreterInvoke ||
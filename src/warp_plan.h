@@ -0,0 +1,547 @@
+#ifndef WARP_PLAN_H_
+#define WARP_PLAN_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "fixed_point_warp.h"
+#include "image_warp.h"
+
+namespace mp {
+
+// Plan keys hold the ROI snapped to this grid, so that float noise in a
+// tracked or fixed ROI still maps to the same plan. A plan is built from the
+// snapped ROI, so frames that may apply one sample it instead of the exact
+// ROI (see WarpPlan::Expects). The shift is at most 1/16 pixel and 1/2048
+// radian.
+constexpr float kRoiPositionSteps = 8.0f;
+constexpr float kRoiRotationSteps = 1024.0f;
+
+inline RectInPixels QuantizeRoi(const RectInPixels& roi) {
+  RectInPixels snapped;
+  snapped.center_x = std::round(roi.center_x * kRoiPositionSteps) /
+                     kRoiPositionSteps;
+  snapped.center_y = std::round(roi.center_y * kRoiPositionSteps) /
+                     kRoiPositionSteps;
+  snapped.width = std::round(roi.width * kRoiPositionSteps) / kRoiPositionSteps;
+  snapped.height =
+      std::round(roi.height * kRoiPositionSteps) / kRoiPositionSteps;
+  snapped.rotation = std::round(roi.rotation * kRoiRotationSteps) /
+                     kRoiRotationSteps;
+  return snapped;
+}
+
+// Everything that determines the sampling grid of one preprocessing call.
+// `roi` must already be quantized.
+struct WarpPlanKey {
+  SourceFormat format = SourceFormat::kRgba;
+  int width = 0;
+  int height = 0;
+  int bytes_per_row = 0;
+  int chroma_bytes_per_row = 0;
+  int rotation_degrees = 0;
+  bool mirror_horizontal = false;
+  // Selects the pyramid level the plan samples.
+  Interpolation interpolation = Interpolation::kBilinear;
+  RectInPixels roi;
+};
+
+inline bool operator==(const WarpPlanKey& a, const WarpPlanKey& b) {
+  return a.format == b.format && a.width == b.width && a.height == b.height &&
+         a.bytes_per_row == b.bytes_per_row &&
+         a.chroma_bytes_per_row == b.chroma_bytes_per_row &&
+         a.rotation_degrees == b.rotation_degrees &&
+         a.mirror_horizontal == b.mirror_horizontal &&
+         a.interpolation == b.interpolation &&
+         a.roi.center_x == b.roi.center_x &&
+         a.roi.center_y == b.roi.center_y && a.roi.width == b.roi.width &&
+         a.roi.height == b.roi.height && a.roi.rotation == b.roi.rotation;
+}
+
+template <int kR, int kB>
+inline WarpPlanKey MakeWarpPlanKey(const PackedPixelSource<kR, kB>& source,
+                                   int rotation_degrees,
+                                   bool mirror_horizontal,
+                                   const RectInPixels& roi) {
+  WarpPlanKey key;
+  key.format = PackedPixelSource<kR, kB>::kFormat;
+  key.width = source.width;
+  key.height = source.height;
+  key.bytes_per_row = source.bytes_per_row;
+  key.rotation_degrees = rotation_degrees;
+  key.mirror_horizontal = mirror_horizontal;
+  key.roi = roi;
+  return key;
+}
+
+inline WarpPlanKey MakeWarpPlanKey(const YuvSource& source,
+                                   int rotation_degrees,
+                                   bool mirror_horizontal,
+                                   const RectInPixels& roi) {
+  WarpPlanKey key;
+  key.format = YuvSource::kFormat;
+  key.width = source.width;
+  key.height = source.height;
+  key.bytes_per_row = source.y_bytes_per_row;
+  key.chroma_bytes_per_row = source.uv_bytes_per_row;
+  key.rotation_degrees = rotation_degrees;
+  key.mirror_horizontal = mirror_horizontal;
+  key.roi = roi;
+  return key;
+}
+
+namespace simd_internal {
+
+constexpr float kPlanWeightScale = 1.0f / 32768.0f;
+
+// Q15 plan weight -> Q8 weight for the fixed-point blend.
+inline int PlanWeightToQ8(int weight) {
+  return (weight + 64) >> 7;
+}
+
+// Blends one planned pixel: `offset` is the byte offset of the top-left tap
+// and the right/bottom taps are always one pixel / one row further.
+template <int kR, int kB, bool kFixed>
+inline void BlendPlannedPixel(const uint8_t* data,
+                              int bytes_per_row,
+                              int32_t offset,
+                              uint16_t weight_x,
+                              uint16_t weight_y,
+                              float* out) {
+  if (offset < 0) {
+    out[0] = kPixelOffset;
+    out[1] = kPixelOffset;
+    out[2] = kPixelOffset;
+    return;
+  }
+  const uint8_t* top = data + offset;
+  const uint8_t* bottom = top + bytes_per_row;
+  if constexpr (kFixed) {
+    BlendFixedPixel<kR, kB>(top, top + 4, bottom, bottom + 4,
+                            PlanWeightToQ8(weight_x), PlanWeightToQ8(weight_y),
+                            out);
+    return;
+  }
+  const float dx = static_cast<float>(weight_x) * kPlanWeightScale;
+  const float dy = static_cast<float>(weight_y) * kPlanWeightScale;
+  const int channel[3] = {kR, 1, kB};
+  for (int c = 0; c < 3; ++c) {
+    const float p00 = top[channel[c]];
+    const float p10 = top[4 + channel[c]];
+    const float p01 = bottom[channel[c]];
+    const float p11 = bottom[4 + channel[c]];
+    const float upper = p00 + (p10 - p00) * dx;
+    const float lower = p01 + (p11 - p01) * dx;
+    out[c] = (upper + (lower - upper) * dy) * kPixelScale + kPixelOffset;
+  }
+}
+
+// Vector part of WarpPlan::Apply for one output row; returns the index of
+// the first pixel not written.
+template <int kR, int kB, bool kFixed>
+inline int ApplyPlanSpan(const uint8_t* data,
+                         int bytes_per_row,
+                         const int32_t* offsets,
+                         const uint16_t* weight_x,
+                         const uint16_t* weight_y,
+                         float* out,
+                         int begin,
+                         int end);
+
+#if defined(MP_SIMD_AVX2)
+
+// Float-blend plan kernel for KernelIsa::kAvx2, 8 pixels per step. Same
+// contract as ApplyPlanSpan, which finishes what it leaves.
+template <int kR, int kB>
+MP_TARGET_AVX2 inline int ApplyPlanSpanAvx2(const uint8_t* data,
+                                            int bytes_per_row,
+                                            const int32_t* offsets,
+                                            const uint16_t* weight_x,
+                                            const uint16_t* weight_y,
+                                            float* out,
+                                            int begin,
+                                            int end) {
+  // Plans are only built when every offset fits in 32 bits.
+  const int* base = reinterpret_cast<const int*>(data);
+  const __m256i down = _mm256_set1_epi32(bytes_per_row);
+  const __m256i right = _mm256_set1_epi32(4);
+  const __m256 scale8 = _mm256_set1_ps(kPlanWeightScale);
+  int x = begin;
+  for (; x + 8 <= end; x += 8) {
+    const __m256i offset =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + x));
+    if (_mm256_movemask_ps(_mm256_castsi256_ps(offset)) != 0) {
+      for (int i = 0; i < 8; ++i) {
+        BlendPlannedPixel<kR, kB, false>(data, bytes_per_row, offsets[x + i],
+                                         weight_x[x + i], weight_y[x + i],
+                                         out + (x + i) * 3);
+      }
+      continue;
+    }
+    const __m256i bottom = _mm256_add_epi32(offset, down);
+    const __m256i q00 = _mm256_i32gather_epi32(base, offset, 1);
+    const __m256i q10 =
+        _mm256_i32gather_epi32(base, _mm256_add_epi32(offset, right), 1);
+    const __m256i q01 = _mm256_i32gather_epi32(base, bottom, 1);
+    const __m256i q11 =
+        _mm256_i32gather_epi32(base, _mm256_add_epi32(bottom, right), 1);
+    const __m256 dx = _mm256_mul_ps(
+        _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(weight_x + x)))),
+        scale8);
+    const __m256 dy = _mm256_mul_ps(
+        _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(weight_y + x)))),
+        scale8);
+    for (int half = 0; half < 2; ++half) {
+      const __m128i h00 = half ? _mm256_extracti128_si256(q00, 1)
+                               : _mm256_castsi256_si128(q00);
+      const __m128i h10 = half ? _mm256_extracti128_si256(q10, 1)
+                               : _mm256_castsi256_si128(q10);
+      const __m128i h01 = half ? _mm256_extracti128_si256(q01, 1)
+                               : _mm256_castsi256_si128(q01);
+      const __m128i h11 = half ? _mm256_extracti128_si256(q11, 1)
+                               : _mm256_castsi256_si128(q11);
+      const __m128 hdx = half ? _mm256_extractf128_ps(dx, 1)
+                              : _mm256_castps256_ps128(dx);
+      const __m128 hdy = half ? _mm256_extractf128_ps(dy, 1)
+                              : _mm256_castps256_ps128(dy);
+      BlendPacked4<kR, kB>(h00, h10, h01, h11, hdx, hdy,
+                           out + (x + half * 4) * 3);
+    }
+  }
+  return x;
+}
+
+#else
+
+template <int kR, int kB>
+inline int ApplyPlanSpanAvx2(const uint8_t*,
+                             int,
+                             const int32_t*,
+                             const uint16_t*,
+                             const uint16_t*,
+                             float*,
+                             int begin,
+                             int) {
+  return begin;
+}
+
+#endif  // MP_SIMD_AVX2
+
+#if defined(MP_SIMD_SSE2)
+
+template <int kR, int kB, bool kFixed>
+inline int ApplyPlanSpan(const uint8_t* data,
+                         int bytes_per_row,
+                         const int32_t* offsets,
+                         const uint16_t* weight_x,
+                         const uint16_t* weight_y,
+                         float* out,
+                         int begin,
+                         int end) {
+  const __m128 scale = _mm_set1_ps(kPlanWeightScale);
+  const __m128i zero = _mm_setzero_si128();
+  int x = begin;
+  for (; x + 4 <= end; x += 4) {
+    const __m128i offset =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(offsets + x));
+    if (_mm_movemask_ps(_mm_castsi128_ps(offset)) != 0) {
+      for (int i = 0; i < 4; ++i) {
+        BlendPlannedPixel<kR, kB, kFixed>(
+            data, bytes_per_row, offsets[x + i], weight_x[x + i],
+            weight_y[x + i], out + (x + i) * 3);
+      }
+      continue;
+    }
+    uint32_t p00[4];
+    uint32_t p10[4];
+    uint32_t p01[4];
+    uint32_t p11[4];
+    for (int i = 0; i < 4; ++i) {
+      const uint8_t* top = data + offsets[x + i];
+      p00[i] = LoadPixel(top);
+      p10[i] = LoadPixel(top + 4);
+      p01[i] = LoadPixel(top + bytes_per_row);
+      p11[i] = LoadPixel(top + bytes_per_row + 4);
+    }
+    const __m128i wx = _mm_unpacklo_epi16(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(weight_x + x)), zero);
+    const __m128i wy = _mm_unpacklo_epi16(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(weight_y + x)), zero);
+    const __m128i q00 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p00));
+    const __m128i q10 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p10));
+    const __m128i q01 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p01));
+    const __m128i q11 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p11));
+    if constexpr (kFixed) {
+      const __m128i round = _mm_set1_epi32(64);
+      BlendFixed4<kR, kB>(q00, q10, q01, q11,
+                          _mm_srli_epi32(_mm_add_epi32(wx, round), 7),
+                          _mm_srli_epi32(_mm_add_epi32(wy, round), 7),
+                          out + x * 3);
+    } else {
+      BlendPacked4<kR, kB>(q00, q10, q01, q11,
+                           _mm_mul_ps(_mm_cvtepi32_ps(wx), scale),
+                           _mm_mul_ps(_mm_cvtepi32_ps(wy), scale),
+                           out + x * 3);
+    }
+  }
+  return x;
+}
+
+#elif defined(MP_SIMD_NEON)
+
+// True when every lane of `mask` is set.
+inline bool AllLanes(uint32x4_t mask) {
+#if defined(__aarch64__)
+  return vminvq_u32(mask) != 0;
+#else
+  const uint32x2_t folded = vpmin_u32(vget_low_u32(mask), vget_high_u32(mask));
+  return vget_lane_u32(vpmin_u32(folded, folded), 0) != 0;
+#endif
+}
+
+template <int kR, int kB, bool kFixed>
+inline int ApplyPlanSpan(const uint8_t* data,
+                         int bytes_per_row,
+                         const int32_t* offsets,
+                         const uint16_t* weight_x,
+                         const uint16_t* weight_y,
+                         float* out,
+                         int begin,
+                         int end) {
+  constexpr int kRed = PackedPixelSource<kR, kB>::kRedShift;
+  constexpr int kBlue = PackedPixelSource<kR, kB>::kBlueShift;
+  int x = begin;
+  for (; x + 4 <= end; x += 4) {
+    if (!AllLanes(vcgeq_s32(vld1q_s32(offsets + x), vdupq_n_s32(0)))) {
+      for (int i = 0; i < 4; ++i) {
+        BlendPlannedPixel<kR, kB, kFixed>(
+            data, bytes_per_row, offsets[x + i], weight_x[x + i],
+            weight_y[x + i], out + (x + i) * 3);
+      }
+      continue;
+    }
+    uint32_t p00[4];
+    uint32_t p10[4];
+    uint32_t p01[4];
+    uint32_t p11[4];
+    for (int i = 0; i < 4; ++i) {
+      const uint8_t* top = data + offsets[x + i];
+      p00[i] = LoadPixel(top);
+      p10[i] = LoadPixel(top + 4);
+      p01[i] = LoadPixel(top + bytes_per_row);
+      p11[i] = LoadPixel(top + bytes_per_row + 4);
+    }
+    const uint32x4_t wx = vmovl_u16(vld1_u16(weight_x + x));
+    const uint32x4_t wy = vmovl_u16(vld1_u16(weight_y + x));
+    const uint32x4_t q00 = vld1q_u32(p00);
+    const uint32x4_t q10 = vld1q_u32(p10);
+    const uint32x4_t q01 = vld1q_u32(p01);
+    const uint32x4_t q11 = vld1q_u32(p11);
+    if constexpr (kFixed) {
+      BlendFixed4<kR, kB>(q00, q10, q01, q11, vrshrq_n_u32(wx, 7),
+                          vrshrq_n_u32(wy, 7), out + x * 3);
+      continue;
+    }
+    const float32x4_t dx = vmulq_n_f32(vcvtq_f32_u32(wx), kPlanWeightScale);
+    const float32x4_t dy = vmulq_n_f32(vcvtq_f32_u32(wy), kPlanWeightScale);
+    StoreRgb(out + x * 3,
+             Blend(Channel<kRed>(q00), Channel<kRed>(q10), Channel<kRed>(q01),
+                   Channel<kRed>(q11), dx, dy),
+             Blend(Channel<8>(q00), Channel<8>(q10), Channel<8>(q01),
+                   Channel<8>(q11), dx, dy),
+             Blend(Channel<kBlue>(q00), Channel<kBlue>(q10),
+                   Channel<kBlue>(q01), Channel<kBlue>(q11), dx, dy));
+  }
+  return x;
+}
+
+#else
+
+template <int kR, int kB, bool kFixed>
+inline int ApplyPlanSpan(const uint8_t*,
+                         int,
+                         const int32_t*,
+                         const uint16_t*,
+                         const uint16_t*,
+                         float*,
+                         int begin,
+                         int) {
+  return begin;
+}
+
+#endif  // MP_SIMD_SSE2 / MP_SIMD_NEON
+
+}  // namespace simd_internal
+
+// Precomputed sampling grid for one WarpPlanKey: per output pixel, the byte
+// offset of its top-left bilinear tap (-1 for black) and Q15 blend weights.
+// Applying a plan is pure gathers and blends, with no coordinate math. Plans
+// only cover packed sources; NV21 uses them through the staged RGBA buffer.
+class WarpPlan {
+ public:
+  // Returns true when a plan for `key` is ready to apply. A plan is built the
+  // second consecutive time a key is seen, so a moving ROI never pays for
+  // building grids it will not reuse. `source_*` describe the packed image
+  // the plan will be applied to, which for NV21 is the staged buffer.
+  bool Prepare(const WarpPlanKey& key,
+               int source_width,
+               int source_height,
+               int source_bytes_per_row,
+               const WarpTransform& m,
+               int dst_width,
+               int dst_height) {
+    const bool same_target = source_width == source_width_ &&
+                             source_height == source_height_ &&
+                             source_bytes_per_row == bytes_per_row_ &&
+                             dst_width == dst_width_ &&
+                             dst_height == dst_height_;
+    if (state_ != State::kEmpty && key == key_ && same_target) {
+      if (state_ == State::kSeen) {
+        state_ = Build(m) ? State::kReady : State::kUnavailable;
+      }
+      return state_ == State::kReady;
+    }
+    key_ = key;
+    source_width_ = source_width;
+    source_height_ = source_height;
+    bytes_per_row_ = source_bytes_per_row;
+    dst_width_ = dst_width;
+    dst_height_ = dst_height;
+    state_ = State::kSeen;
+    return false;
+  }
+
+  // Forgets the current key, so the next Prepare() starts over as if no
+  // frame had been seen. The grid buffers stay allocated.
+  void Reset() { state_ = State::kEmpty; }
+
+  // True when Prepare() with `key` would build or reuse a plan, provided the
+  // source and output geometry are unchanged. Such a frame should warp with
+  // the transform of the key's snapped ROI, which is what the plan holds.
+  bool Expects(const WarpPlanKey& key) const {
+    return (state_ == State::kSeen || state_ == State::kReady) && key == key_;
+  }
+
+  // Writes rows [row_begin, row_end) of the output. Only valid after
+  // Prepare() returned true, with a source matching the geometry given there.
+  // `fixed_point` selects the integer blend of fixed_point_warp.h and `isa`
+  // the vector kernels.
+  template <int kR, int kB>
+  void Apply(const PackedPixelSource<kR, kB>& source,
+             float* dst,
+             int row_begin,
+             int row_end,
+             bool fixed_point,
+             KernelIsa isa = kBaselineKernelIsa) const {
+    if (fixed_point) {
+      ApplyRows<kR, kB, true>(source, dst, row_begin, row_end, isa);
+    } else {
+      ApplyRows<kR, kB, false>(source, dst, row_begin, row_end, isa);
+    }
+  }
+
+ private:
+  enum class State { kEmpty, kSeen, kReady, kUnavailable };
+
+  template <int kR, int kB, bool kFixed>
+  void ApplyRows(const PackedPixelSource<kR, kB>& source,
+                 float* dst,
+                 int row_begin,
+                 int row_end,
+                 KernelIsa isa) const {
+    for (int x_begin = 0; x_begin < dst_width_; x_begin += tile_width_) {
+      const int count = std::min(tile_width_, dst_width_ - x_begin);
+      for (int y = row_begin; y < row_end; ++y) {
+        const size_t first = static_cast<size_t>(y) * dst_width_ + x_begin;
+        const int32_t* offsets = offsets_.data() + first;
+        const uint16_t* weight_x = weight_x_.data() + first;
+        const uint16_t* weight_y = weight_y_.data() + first;
+        float* out = dst + first * 3;
+        int x = 0;
+        if (!kFixed && isa == KernelIsa::kAvx2) {
+          x = simd_internal::ApplyPlanSpanAvx2<kR, kB>(
+              source.data, source.bytes_per_row, offsets, weight_x, weight_y,
+              out, x, count);
+        }
+        x = simd_internal::ApplyPlanSpan<kR, kB, kFixed>(
+            source.data, source.bytes_per_row, offsets, weight_x, weight_y,
+            out, x, count);
+        for (; x < count; ++x) {
+          simd_internal::BlendPlannedPixel<kR, kB, kFixed>(
+              source.data, source.bytes_per_row, offsets[x], weight_x[x],
+              weight_y[x], out + x * 3);
+        }
+      }
+    }
+  }
+
+  bool Build(const WarpTransform& m) {
+    // Right/bottom taps are addressed as +4 bytes / +1 row, and offsets are
+    // 32-bit.
+    if (source_width_ < 2 || source_height_ < 2 ||
+        static_cast<int64_t>(source_height_) * bytes_per_row_ > INT32_MAX) {
+      return false;
+    }
+    const size_t count = static_cast<size_t>(dst_width_) * dst_height_;
+    tile_width_ = WarpTileWidth(m, dst_width_);
+    offsets_.resize(count);
+    weight_x_.resize(count);
+    weight_y_.resize(count);
+    const float last_x = static_cast<float>(source_width_ - 1);
+    const float last_y = static_cast<float>(source_height_ - 1);
+    size_t index = 0;
+    for (int y = 0; y < dst_height_; ++y) {
+      const float row_x = m.xy * static_cast<float>(y) + m.xt;
+      const float row_y = m.yy * static_cast<float>(y) + m.yt;
+      for (int x = 0; x < dst_width_; ++x, ++index) {
+        const float sx = m.xx * static_cast<float>(x) + row_x;
+        const float sy = m.yx * static_cast<float>(x) + row_y;
+        if (!(sx >= 0.0f && sy >= 0.0f && sx <= last_x && sy <= last_y)) {
+          offsets_[index] = -1;
+          weight_x_[index] = 0;
+          weight_y_[index] = 0;
+          continue;
+        }
+        // On the last column/row the weight is 0; step back one pixel with
+        // weight 1 so the +1 tap stays inside and reads the same value.
+        int x0 = static_cast<int>(sx);
+        int y0 = static_cast<int>(sy);
+        float dx = sx - static_cast<float>(x0);
+        float dy = sy - static_cast<float>(y0);
+        if (x0 == source_width_ - 1) {
+          --x0;
+          dx = 1.0f;
+        }
+        if (y0 == source_height_ - 1) {
+          --y0;
+          dy = 1.0f;
+        }
+        offsets_[index] = y0 * bytes_per_row_ + x0 * 4;
+        weight_x_[index] = static_cast<uint16_t>(std::lround(dx * 32768.0f));
+        weight_y_[index] = static_cast<uint16_t>(std::lround(dy * 32768.0f));
+      }
+    }
+    return true;
+  }
+
+  State state_ = State::kEmpty;
+  WarpPlanKey key_;
+  int source_width_ = 0;
+  int source_height_ = 0;
+  int bytes_per_row_ = 0;
+  int dst_width_ = 0;
+  int dst_height_ = 0;
+  int tile_width_ = 0;
+  std::vector<int32_t> offsets_;
+  std::vector<uint16_t> weight_x_;
+  std::vector<uint16_t> weight_y_;
+};
+
+}  // namespace mp
+
+#endif  // WARP_PLAN_H_
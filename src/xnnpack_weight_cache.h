@@ -0,0 +1,202 @@
+#ifndef XNNPACK_WEIGHT_CACHE_H_
+#define XNNPACK_WEIGHT_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+// On-disk cache of the weights XNNPACK repacks for a model, so later runs
+// map the packed file instead of repacking every convolution at startup.
+//
+// The file is named after the model's content hash; a stamp file next to it
+// records the model and TensorFlow Lite runtime the cache was built for and
+// is written only after a context has finished building it. A missing or
+// mismatched stamp (different runtime version, or a build that never
+// completed) deletes the cache so XNNPACK starts a fresh one. Contexts
+// lock the cache file from Open until Commit or Close: shared while it is
+// complete and only mapped, exclusive while one of them invalidates and
+// builds it. Threads of one process take a per-file shared_mutex, and an
+// advisory flock on a ".lock" file next to the cache extends the same locking
+// to other processes using the directory (except on Windows, where only
+// contexts in one process are coordinated). Contexts on different models, or
+// on the same finished cache, do not wait for each other.
+class XnnpackWeightCache {
+ public:
+  XnnpackWeightCache() = default;
+  XnnpackWeightCache(const XnnpackWeightCache&) = delete;
+  XnnpackWeightCache& operator=(const XnnpackWeightCache&) = delete;
+  ~XnnpackWeightCache() { Close(); }
+
+  // Prepares the cache file for the model with `model_hash` / `model_size`
+  // under `directory`. Returns false, leaving the cache unused, when
+  // `directory` is empty or the file cannot be created there.
+  bool Open(const std::string& directory,
+            uint64_t model_hash,
+            size_t model_size,
+            const char* runtime_version) {
+    Close();
+    if (directory.empty()) {
+      return false;
+    }
+    char hash_hex[17];
+    std::snprintf(hash_hex, sizeof(hash_hex), "%016llx",
+                  static_cast<unsigned long long>(model_hash));
+    path_ = directory + "/face_mesh_" + hash_hex + ".xnnpack_cache";
+    stamp_path_ = path_ + ".stamp";
+    lock_path_ = path_ + ".lock";
+    std::ostringstream key;
+    key << "model " << hash_hex << ' ' << model_size << '\n'
+        << "tflite " << (runtime_version ? runtime_version : "unknown")
+        << '\n';
+    key_ = key.str();
+
+    std::shared_mutex& mutex = PathMutex(path_);
+    shared_lock_ = std::shared_lock<std::shared_mutex>(mutex);
+    LockFile(kShared);
+    built_ = StampMatches();
+    if (!built_) {
+      // Both locks are dropped before waiting, so two contexts upgrading at
+      // once never hold a shared file lock the other's exclusive one needs.
+      UnlockFile();
+      shared_lock_.unlock();
+      exclusive_lock_ = std::unique_lock<std::shared_mutex>(mutex);
+      LockFile(kExclusive);
+      // Another context or process may have built it while this one waited.
+      built_ = StampMatches();
+      if (!built_) {
+        std::remove(stamp_path_.c_str());
+        std::remove(path_.c_str());
+      }
+    }
+    // The XNNPACK delegate builds into `weight_cache_file_path` when the file
+    // exists but is empty, and maps it when it holds a finished cache. The
+    // file is created without truncation: after invalidation it is new and
+    // empty, and a cache whose stamp matched is left as it is.
+    if (!std::ofstream(path_, std::ios::binary | std::ios::app)) {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  // Marks a freshly built cache as complete and releases the lock. Call once
+  // the interpreter using the cache has been created.
+  void Commit() {
+    if (!shared_lock_ && !exclusive_lock_) {
+      return;
+    }
+    if (!built_) {
+      const std::string temp_path = stamp_path_ + ".tmp";
+      bool written = false;
+      {
+        std::ofstream stamp(temp_path, std::ios::binary | std::ios::trunc);
+        written = stamp && (stamp << key_) && stamp.flush();
+      }
+      if (!written || std::rename(temp_path.c_str(), stamp_path_.c_str())) {
+        std::remove(temp_path.c_str());
+      }
+      built_ = true;
+    }
+    Close();
+  }
+
+  // Releases the lock without marking the cache complete.
+  void Close() {
+    UnlockFile();
+    if (shared_lock_) {
+      shared_lock_.unlock();
+    }
+    if (exclusive_lock_) {
+      exclusive_lock_.unlock();
+    }
+  }
+
+  const char* path() const { return path_.c_str(); }
+
+  // True when the cache was already complete on Open.
+  bool built() const { return built_; }
+
+ private:
+#if defined(_WIN32)
+  static constexpr int kShared = 0;
+  static constexpr int kExclusive = 0;
+#else
+  static constexpr int kShared = LOCK_SH;
+  static constexpr int kExclusive = LOCK_EX;
+#endif
+
+  // Takes the cross-process lock (kShared or kExclusive) on `lock_path_`.
+  // Without a lock file, as on read-only directories, only the in-process
+  // lock applies.
+  void LockFile(int operation) {
+#if !defined(_WIN32)
+    if (lock_fd_ < 0) {
+      lock_fd_ = open(lock_path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+      if (lock_fd_ < 0) {
+        return;
+      }
+    }
+    while (flock(lock_fd_, operation) != 0 && errno == EINTR) {
+    }
+#else
+    (void)operation;
+#endif
+  }
+
+  void UnlockFile() {
+#if !defined(_WIN32)
+    if (lock_fd_ >= 0) {
+      // Closing the only descriptor releases the flock.
+      close(lock_fd_);
+      lock_fd_ = -1;
+    }
+#endif
+  }
+
+  // One lock per cache file, kept for the life of the process.
+  static std::shared_mutex& PathMutex(const std::string& path) {
+    static std::mutex* guard = new std::mutex();
+    static auto* mutexes =
+        new std::map<std::string, std::unique_ptr<std::shared_mutex>>();
+    std::lock_guard<std::mutex> lock(*guard);
+    std::unique_ptr<std::shared_mutex>& mutex = (*mutexes)[path];
+    if (!mutex) {
+      mutex.reset(new std::shared_mutex());
+    }
+    return *mutex;
+  }
+
+  bool StampMatches() const {
+    std::ifstream stamp(stamp_path_, std::ios::binary);
+    const std::string recorded((std::istreambuf_iterator<char>(stamp)),
+                               std::istreambuf_iterator<char>());
+    return stamp && recorded == key_;
+  }
+
+  std::string path_;
+  std::string stamp_path_;
+  std::string lock_path_;
+  std::string key_;
+  bool built_ = false;
+  std::shared_lock<std::shared_mutex> shared_lock_;
+  std::unique_lock<std::shared_mutex> exclusive_lock_;
+  int lock_fd_ = -1;
+};
+
+#endif  // XNNPACK_WEIGHT_CACHE_H_
@@ -0,0 +1,202 @@
+#ifndef YUV_CONVERT_H_
+#define YUV_CONVERT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "image_warp.h"
+
+namespace mp {
+
+// Reusable buffers for ConvertYuvRegion.
+struct YuvConvertScratch {
+  std::vector<uint8_t> luma;
+  std::vector<uint8_t> chroma;
+  std::vector<uint8_t> vu_row;
+  std::vector<uint8_t> packed_vu;
+  std::vector<uint16_t> sums;
+};
+
+// Converts the `width` x `height` region of `source` at (`x_begin`,
+// `y_begin`) to packed RGBA, box-downsampled by `factor` (a power of two no
+// larger than 16), writing `width / factor` x `height / factor` pixels to
+// `dst`. The region starts on a chroma sample. With `factor` > 1 its size is
+// a multiple of 2 * `factor` and may run past the frame, in which case the
+// last row/column repeats; without downsampling it must lie inside the frame.
+// Chroma is read as NV21 rows; other layouts are repacked row by row. `isa`
+// picks the vector kernels.
+inline void ConvertYuvRegion(const YuvSource& source,
+                             int x_begin,
+                             int y_begin,
+                             int width,
+                             int height,
+                             int factor,
+                             uint8_t* dst,
+                             int dst_bytes_per_row,
+                             YuvConvertScratch* scratch,
+                             KernelIsa isa = kBaselineKernelIsa) {
+  const int out_width = width / factor;
+  const int out_height = height / factor;
+  if (factor == 1) {
+    const int pairs = (width + 1) / 2;
+    scratch->vu_row.resize(static_cast<size_t>(pairs) * 2);
+    const uint8_t* vu = nullptr;
+    int vu_row_index = -1;
+    for (int row = 0; row < height; ++row) {
+      const int y = y_begin + row;
+      if ((y >> 1) != vu_row_index) {
+        vu_row_index = y >> 1;
+        vu = VuRow(source, vu_row_index, x_begin / 2, pairs,
+                   scratch->vu_row.data(), isa);
+      }
+      Nv21RowToRgba(
+          source.y + static_cast<size_t>(y) * source.y_bytes_per_row + x_begin,
+          vu, width, dst + static_cast<size_t>(row) * dst_bytes_per_row, isa);
+    }
+    return;
+  }
+
+  // Downsample Y and VU by the same factor; the result is itself an NV21
+  // image with even dimensions.
+  const int chroma_height = out_height / 2;
+  const int luma_width = std::min(width, source.width - x_begin);
+  const int luma_height = std::min(height, source.height - y_begin);
+  const int chroma_width = (luma_width + 1) / 2;
+  const int chroma_rows = (luma_height + 1) / 2;
+  const uint8_t* vu_plane = nullptr;
+  int vu_bytes_per_row = 0;
+  if (source.IsNv21()) {
+    vu_plane = source.v +
+               static_cast<size_t>(y_begin / 2) * source.uv_bytes_per_row +
+               x_begin;
+    vu_bytes_per_row = source.uv_bytes_per_row;
+  } else {
+    vu_bytes_per_row = chroma_width * 2;
+    scratch->packed_vu.resize(static_cast<size_t>(vu_bytes_per_row) *
+                              chroma_rows);
+    for (int row = 0; row < chroma_rows; ++row) {
+      PackVuRow(source, y_begin / 2 + row, x_begin / 2, chroma_width,
+                scratch->packed_vu.data() +
+                    static_cast<size_t>(row) * vu_bytes_per_row,
+                isa);
+    }
+    vu_plane = scratch->packed_vu.data();
+  }
+  scratch->luma.resize(static_cast<size_t>(out_width) * out_height);
+  scratch->chroma.resize(static_cast<size_t>(out_width) * chroma_height);
+  scratch->sums.resize(static_cast<size_t>(luma_width) + 2);
+  BoxDownsamplePlane(
+      source.y + static_cast<size_t>(y_begin) * source.y_bytes_per_row +
+          x_begin,
+      source.y_bytes_per_row, luma_width, luma_height, 1, factor, out_width,
+      out_height, scratch->sums.data(), scratch->luma.data(), out_width, isa);
+  BoxDownsamplePlane(vu_plane, vu_bytes_per_row, chroma_width, chroma_rows, 2,
+                     factor, out_width / 2, chroma_height,
+                     scratch->sums.data(), scratch->chroma.data(), out_width,
+                     isa);
+  for (int row = 0; row < out_height; ++row) {
+    Nv21RowToRgba(
+        scratch->luma.data() + static_cast<size_t>(row) * out_width,
+        scratch->chroma.data() + static_cast<size_t>(row >> 1) * out_width,
+        out_width, dst + static_cast<size_t>(row) * dst_bytes_per_row, isa);
+  }
+}
+
+// Output size of YuvFrameConverter before rotation: the frame divided by
+// `downscale`, rounded up.
+inline int DownscaledSize(int size, int downscale) {
+  return (size + downscale - 1) / downscale;
+}
+
+// Converts a whole frame to packed RGBA (alpha 255) for display: box-
+// downscaled by `downscale` (1, 2, 4, 8 or 16), then rotated and mirrored
+// into the logical orientation that processing uses for the same
+// `rotation_degrees` / `mirror_horizontal` (see OrientationTransform). The
+// frame is converted in strips of kStripRows output rows, and each strip is
+// scattered to `dst` in tiles of kTileWidth pixels so rotated writes stay in
+// a few cache lines. `isa` picks the vector kernels.
+class YuvFrameConverter {
+ public:
+  static constexpr int kStripRows = 16;
+  static constexpr int kTileWidth = 16;
+
+  void Convert(const YuvSource& source,
+               int rotation_degrees,
+               bool mirror_horizontal,
+               int downscale,
+               uint8_t* dst,
+               int dst_bytes_per_row,
+               KernelIsa isa = kBaselineKernelIsa) {
+    const int out_width = DownscaledSize(source.width, downscale);
+    const int out_height = DownscaledSize(source.height, downscale);
+    // Downsampled regions are whole chroma blocks; the part past the frame
+    // edge repeats it and is cut off again below.
+    const int align = downscale > 1 ? 2 * downscale : 1;
+    const int region_width = AlignUp(source.width, align);
+    const int strip_width = region_width / downscale;
+    const int strip_bytes_per_row = strip_width * 4;
+    // A short last strip of odd height rounds up to a whole chroma row.
+    strip_.resize(static_cast<size_t>(strip_bytes_per_row) *
+                  (kStripRows + 1));
+
+    // Inverse of the logical -> raw orientation map. Its linear part is a
+    // signed permutation, so the inverse is the transpose.
+    const WarpTransform m = OrientationTransform(
+        rotation_degrees, mirror_horizontal, out_width, out_height);
+    const int xx = static_cast<int>(m.xx);
+    const int xy = static_cast<int>(m.xy);
+    const int yx = static_cast<int>(m.yx);
+    const int yy = static_cast<int>(m.yy);
+    const int xt = static_cast<int>(m.xt);
+    const int yt = static_cast<int>(m.yt);
+    const ptrdiff_t step = static_cast<ptrdiff_t>(xx) * 4 +
+                           static_cast<ptrdiff_t>(xy) * dst_bytes_per_row;
+
+    for (int strip_y = 0; strip_y < out_height; strip_y += kStripRows) {
+      const int rows = std::min(kStripRows, out_height - strip_y);
+      const int y_begin = strip_y * downscale;
+      const int raw_rows =
+          std::min(rows * downscale, source.height - y_begin);
+      ConvertYuvRegion(source, 0, y_begin, region_width,
+                       AlignUp(raw_rows, align), downscale, strip_.data(),
+                       strip_bytes_per_row, &scratch_, isa);
+      for (int x_begin = 0; x_begin < out_width; x_begin += kTileWidth) {
+        const int count = std::min(kTileWidth, out_width - x_begin);
+        for (int row = 0; row < rows; ++row) {
+          const int sx = x_begin - xt;
+          const int sy = strip_y + row - yt;
+          const int ox = xx * sx + yx * sy;
+          const int oy = xy * sx + yy * sy;
+          const uint8_t* in = strip_.data() +
+                              static_cast<size_t>(row) * strip_bytes_per_row +
+                              static_cast<size_t>(x_begin) * 4;
+          uint8_t* out = dst + static_cast<ptrdiff_t>(oy) * dst_bytes_per_row +
+                         static_cast<ptrdiff_t>(ox) * 4;
+          if (step == 4) {
+            std::memcpy(out, in, static_cast<size_t>(count) * 4);
+            continue;
+          }
+          for (int i = 0; i < count; ++i) {
+            std::memcpy(out, in + i * 4, 4);
+            out += step;
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  static int AlignUp(int value, int align) {
+    return (value + align - 1) / align * align;
+  }
+
+  std::vector<uint8_t> strip_;
+  YuvConvertScratch scratch_;
+};
+
+}  // namespace mp
+
+#endif  // YUV_CONVERT_H_
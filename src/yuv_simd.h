@@ -0,0 +1,825 @@
+#ifndef YUV_SIMD_H_
+#define YUV_SIMD_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "bilinear_simd.h"
+#include "pixel_sources.h"
+
+namespace mp {
+
+namespace simd_internal {
+
+// Loads Y/U/V for the four bilinear taps of kLanes pixels whose top-left tap
+// is at (xs[i], ys[i]). Tap order is 00, 10, 01, 11; the caller has already
+// checked that every tap is inside.
+template <int kLanes>
+inline void GatherYuvTaps(const YuvSource& source,
+                          const int32_t* xs,
+                          const int32_t* ys,
+                          int32_t (*luma)[kLanes],
+                          int32_t (*u)[kLanes],
+                          int32_t (*v)[kLanes]) {
+  for (int i = 0; i < kLanes; ++i) {
+    const int tap_x[2] = {xs[i], xs[i] + 1};
+    const int tap_y[2] = {ys[i], ys[i] + 1};
+    for (int t = 0; t < 4; ++t) {
+      const int x = tap_x[t & 1];
+      const int y = tap_y[t >> 1];
+      const size_t chroma =
+          static_cast<size_t>(y >> 1) * source.uv_bytes_per_row +
+          static_cast<size_t>(x >> 1) * source.uv_pixel_stride;
+      luma[t][i] = source.y[static_cast<size_t>(y) * source.y_bytes_per_row +
+                            static_cast<size_t>(x)];
+      u[t][i] = source.u[chroma];
+      v[t][i] = source.v[chroma];
+    }
+  }
+}
+
+// Loads Y/U/V of the pixels at (xs[i], ys[i]) for 4 nearest-neighbour taps.
+inline void GatherYuvPixels(const YuvSource& source,
+                            const int32_t* xs,
+                            const int32_t* ys,
+                            int32_t* luma,
+                            int32_t* u,
+                            int32_t* v) {
+  for (int i = 0; i < 4; ++i) {
+    const size_t chroma =
+        static_cast<size_t>(ys[i] >> 1) * source.uv_bytes_per_row +
+        static_cast<size_t>(xs[i] >> 1) * source.uv_pixel_stride;
+    luma[i] = source.y[static_cast<size_t>(ys[i]) * source.y_bytes_per_row +
+                       static_cast<size_t>(xs[i])];
+    u[i] = source.u[chroma];
+    v[i] = source.v[chroma];
+  }
+}
+
+}  // namespace simd_internal
+
+#if defined(MP_SIMD_SSE2)
+
+namespace simd_internal {
+
+// Two signed 16-bit coefficients packed into each 32-bit lane for
+// _mm_madd_epi16: lane = lo * a + hi * b.
+inline __m128i PairConstant(int lo, int hi) {
+  return _mm_set1_epi32(static_cast<int32_t>(
+      (static_cast<uint32_t>(static_cast<uint16_t>(hi)) << 16) |
+      static_cast<uint16_t>(lo)));
+}
+
+inline __m128i ClampByte(__m128i value) {
+  return _mm_min_epi16(_mm_max_epi16(value, _mm_setzero_si128()),
+                       _mm_set1_epi16(255));
+}
+
+// Bit-exact vector form of YuvToRgb for 4 pixels held in 32-bit lanes.
+inline void YuvToRgb4(__m128i y,
+                      __m128i u,
+                      __m128i v,
+                      __m128* r,
+                      __m128* g,
+                      __m128* b) {
+  const __m128i c = _mm_sub_epi32(y, _mm_set1_epi32(16));
+  const __m128i c_clamped = _mm_andnot_si128(_mm_srai_epi32(c, 31), c);
+  const __m128i d = _mm_sub_epi32(u, _mm_set1_epi32(128));
+  const __m128i e = _mm_sub_epi32(v, _mm_set1_epi32(128));
+  const __m128i round = _mm_set1_epi32(128);
+  // c is in [0, 239] so it fits the low half; d/e go in the high half.
+  const __m128i ce = _mm_or_si128(c_clamped, _mm_slli_epi32(e, 16));
+  const __m128i cd = _mm_or_si128(c_clamped, _mm_slli_epi32(d, 16));
+  const __m128i r32 = _mm_srai_epi32(
+      _mm_add_epi32(_mm_madd_epi16(ce, PairConstant(298, 409)), round), 8);
+  const __m128i g32 = _mm_srai_epi32(
+      _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(cd, PairConstant(298, -100)),
+                                  _mm_madd_epi16(e, PairConstant(-208, 0))),
+                    round),
+      8);
+  const __m128i b32 = _mm_srai_epi32(
+      _mm_add_epi32(_mm_madd_epi16(cd, PairConstant(298, 516)), round), 8);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i rg = ClampByte(_mm_packs_epi32(r32, g32));
+  const __m128i bb = ClampByte(_mm_packs_epi32(b32, b32));
+  *r = _mm_cvtepi32_ps(_mm_unpacklo_epi16(rg, zero));
+  *g = _mm_cvtepi32_ps(_mm_unpackhi_epi16(rg, zero));
+  *b = _mm_cvtepi32_ps(_mm_unpacklo_epi16(bb, zero));
+}
+
+// Converts 8 NV21 pixels (8 luma bytes, 4 VU pairs) to 8 packed RGBA pixels.
+// Same arithmetic as YuvToRgb, evaluated as 16-bit pairs through madd.
+inline void Nv21ToRgba8(const uint8_t* luma, const uint8_t* vu, uint8_t* dst) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i y16 = _mm_unpacklo_epi8(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(luma)), zero);
+  __m128i vu16 = _mm_unpacklo_epi8(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vu)), zero);
+  const __m128i c = _mm_max_epi16(_mm_sub_epi16(y16, _mm_set1_epi16(16)), zero);
+  vu16 = _mm_sub_epi16(vu16, _mm_set1_epi16(128));
+  // Duplicate each chroma sample across the two pixels that share it.
+  const __m128i e = _mm_shufflehi_epi16(
+      _mm_shufflelo_epi16(vu16, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+  const __m128i d = _mm_shufflehi_epi16(
+      _mm_shufflelo_epi16(vu16, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+  const __m128i one = _mm_set1_epi16(1);
+  __m128i channel[3][2];
+  for (int half = 0; half < 2; ++half) {
+    const __m128i ce = half ? _mm_unpackhi_epi16(c, e) : _mm_unpacklo_epi16(c, e);
+    const __m128i cd = half ? _mm_unpackhi_epi16(c, d) : _mm_unpacklo_epi16(c, d);
+    const __m128i e1 =
+        half ? _mm_unpackhi_epi16(e, one) : _mm_unpacklo_epi16(e, one);
+    const __m128i round = _mm_set1_epi32(128);
+    channel[0][half] = _mm_srai_epi32(
+        _mm_add_epi32(_mm_madd_epi16(ce, PairConstant(298, 409)), round), 8);
+    channel[1][half] = _mm_srai_epi32(
+        _mm_add_epi32(_mm_madd_epi16(cd, PairConstant(298, -100)),
+                      _mm_madd_epi16(e1, PairConstant(-208, 128))),
+        8);
+    channel[2][half] = _mm_srai_epi32(
+        _mm_add_epi32(_mm_madd_epi16(cd, PairConstant(298, 516)), round), 8);
+  }
+  // packus saturates to [0, 255], which is the clamp in YuvToRgb.
+  const __m128i r = _mm_packus_epi16(
+      _mm_packs_epi32(channel[0][0], channel[0][1]), zero);
+  const __m128i g = _mm_packus_epi16(
+      _mm_packs_epi32(channel[1][0], channel[1][1]), zero);
+  const __m128i b = _mm_packus_epi16(
+      _mm_packs_epi32(channel[2][0], channel[2][1]), zero);
+  const __m128i rg = _mm_unpacklo_epi8(r, g);
+  const __m128i ba = _mm_unpacklo_epi8(b, _mm_set1_epi8(-1));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi16(rg, ba));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16),
+                   _mm_unpackhi_epi16(rg, ba));
+}
+
+}  // namespace simd_internal
+
+inline int BilinearSpan(const YuvSource& source,
+                        float row_x,
+                        float row_y,
+                        float step_x,
+                        float step_y,
+                        float* out,
+                        int begin,
+                        int end) {
+  return simd_internal::ForEachQuad(
+      row_x, row_y, step_x, step_y, out, begin, end,
+      [&source](__m128i xi, __m128i yi, __m128 dx, __m128 dy, float* dst) {
+        alignas(16) int32_t xs[4];
+        alignas(16) int32_t ys[4];
+        alignas(16) int32_t luma[4][4];
+        alignas(16) int32_t u[4][4];
+        alignas(16) int32_t v[4][4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(xs), xi);
+        _mm_store_si128(reinterpret_cast<__m128i*>(ys), yi);
+        simd_internal::GatherYuvTaps(source, xs, ys, luma, u, v);
+        __m128 rgb[4][3];
+        for (int t = 0; t < 4; ++t) {
+          simd_internal::YuvToRgb4(
+              _mm_load_si128(reinterpret_cast<const __m128i*>(luma[t])),
+              _mm_load_si128(reinterpret_cast<const __m128i*>(u[t])),
+              _mm_load_si128(reinterpret_cast<const __m128i*>(v[t])),
+              &rgb[t][0], &rgb[t][1], &rgb[t][2]);
+        }
+        __m128 channel[3];
+        for (int c = 0; c < 3; ++c) {
+          channel[c] = simd_internal::Blend(rgb[0][c], rgb[1][c], rgb[2][c],
+                                            rgb[3][c], dx, dy);
+        }
+        simd_internal::StoreRgb(dst, channel[0], channel[1], channel[2]);
+      });
+}
+
+inline int NearestSpan(const YuvSource& source,
+                       float row_x,
+                       float row_y,
+                       float step_x,
+                       float step_y,
+                       float* out,
+                       int begin,
+                       int end) {
+  return simd_internal::ForEachQuad(
+      row_x, row_y, step_x, step_y, out, begin, end,
+      [&source](__m128i xi, __m128i yi, __m128, __m128, float* dst) {
+        alignas(16) int32_t xs[4];
+        alignas(16) int32_t ys[4];
+        alignas(16) int32_t luma[4];
+        alignas(16) int32_t u[4];
+        alignas(16) int32_t v[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(xs), xi);
+        _mm_store_si128(reinterpret_cast<__m128i*>(ys), yi);
+        simd_internal::GatherYuvPixels(source, xs, ys, luma, u, v);
+        __m128 rgb[3];
+        simd_internal::YuvToRgb4(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(luma)),
+            _mm_load_si128(reinterpret_cast<const __m128i*>(u)),
+            _mm_load_si128(reinterpret_cast<const __m128i*>(v)), &rgb[0],
+            &rgb[1], &rgb[2]);
+        simd_internal::StoreRgb(dst, simd_internal::Normalize(rgb[0]),
+                                simd_internal::Normalize(rgb[1]),
+                                simd_internal::Normalize(rgb[2]));
+      });
+}
+
+#elif defined(MP_SIMD_NEON)
+
+namespace simd_internal {
+
+// Bit-exact vector form of YuvToRgb for 4 pixels held in 32-bit lanes.
+inline void YuvToRgb4(int32x4_t y,
+                      int32x4_t u,
+                      int32x4_t v,
+                      float32x4_t* r,
+                      float32x4_t* g,
+                      float32x4_t* b) {
+  const int32x4_t zero = vdupq_n_s32(0);
+  const int32x4_t max = vdupq_n_s32(255);
+  const int32x4_t c = vmaxq_s32(vsubq_s32(y, vdupq_n_s32(16)), zero);
+  const int32x4_t d = vsubq_s32(u, vdupq_n_s32(128));
+  const int32x4_t e = vsubq_s32(v, vdupq_n_s32(128));
+  const int32x4_t base = vmlaq_n_s32(vdupq_n_s32(128), c, 298);
+  const int32x4_t r32 = vshrq_n_s32(vmlaq_n_s32(base, e, 409), 8);
+  const int32x4_t g32 =
+      vshrq_n_s32(vmlaq_n_s32(vmlaq_n_s32(base, d, -100), e, -208), 8);
+  const int32x4_t b32 = vshrq_n_s32(vmlaq_n_s32(base, d, 516), 8);
+  *r = vcvtq_f32_s32(vminq_s32(vmaxq_s32(r32, zero), max));
+  *g = vcvtq_f32_s32(vminq_s32(vmaxq_s32(g32, zero), max));
+  *b = vcvtq_f32_s32(vminq_s32(vmaxq_s32(b32, zero), max));
+}
+
+// Converts 8 NV21 pixels (8 luma bytes, 4 VU pairs) to 8 packed RGBA pixels.
+inline void Nv21ToRgba8(const uint8_t* luma, const uint8_t* vu, uint8_t* dst) {
+  const uint8x8_t vu8 = vld1_u8(vu);
+  const uint8x8x2_t planar = vuzp_u8(vu8, vu8);
+  // Duplicate each chroma sample across the two pixels that share it.
+  const uint8x8_t v8 = vzip_u8(planar.val[0], planar.val[0]).val[0];
+  const uint8x8_t u8 = vzip_u8(planar.val[1], planar.val[1]).val[0];
+  const int16x8_t c = vmaxq_s16(
+      vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(luma))), vdupq_n_s16(16)),
+      vdupq_n_s16(0));
+  const int16x8_t d =
+      vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), vdupq_n_s16(128));
+  const int16x8_t e =
+      vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), vdupq_n_s16(128));
+  int16x4_t channel[3][2];
+  for (int half = 0; half < 2; ++half) {
+    const int16x4_t c4 = half ? vget_high_s16(c) : vget_low_s16(c);
+    const int16x4_t d4 = half ? vget_high_s16(d) : vget_low_s16(d);
+    const int16x4_t e4 = half ? vget_high_s16(e) : vget_low_s16(e);
+    const int32x4_t base = vmlal_n_s16(vdupq_n_s32(128), c4, 298);
+    channel[0][half] = vshrn_n_s32(vmlal_n_s16(base, e4, 409), 8);
+    channel[1][half] = vshrn_n_s32(
+        vmlal_n_s16(vmlal_n_s16(base, d4, -100), e4, -208), 8);
+    channel[2][half] = vshrn_n_s32(vmlal_n_s16(base, d4, 516), 8);
+  }
+  uint8x8x4_t rgba;
+  // vqmovun saturates to [0, 255], which is the clamp in YuvToRgb.
+  rgba.val[0] = vqmovun_s16(vcombine_s16(channel[0][0], channel[0][1]));
+  rgba.val[1] = vqmovun_s16(vcombine_s16(channel[1][0], channel[1][1]));
+  rgba.val[2] = vqmovun_s16(vcombine_s16(channel[2][0], channel[2][1]));
+  rgba.val[3] = vdup_n_u8(255);
+  vst4_u8(dst, rgba);
+}
+
+}  // namespace simd_internal
+
+inline int BilinearSpan(const YuvSource& source,
+                        float row_x,
+                        float row_y,
+                        float step_x,
+                        float step_y,
+                        float* out,
+                        int begin,
+                        int end) {
+  return simd_internal::ForEachQuad(
+      row_x, row_y, step_x, step_y, out, begin, end,
+      [&source](int32x4_t xi, int32x4_t yi, float32x4_t dx, float32x4_t dy,
+                float* dst) {
+        int32_t xs[4];
+        int32_t ys[4];
+        int32_t luma[4][4];
+        int32_t u[4][4];
+        int32_t v[4][4];
+        vst1q_s32(xs, xi);
+        vst1q_s32(ys, yi);
+        simd_internal::GatherYuvTaps(source, xs, ys, luma, u, v);
+        float32x4_t rgb[4][3];
+        for (int t = 0; t < 4; ++t) {
+          simd_internal::YuvToRgb4(vld1q_s32(luma[t]), vld1q_s32(u[t]),
+                                   vld1q_s32(v[t]), &rgb[t][0], &rgb[t][1],
+                                   &rgb[t][2]);
+        }
+        float32x4_t channel[3];
+        for (int c = 0; c < 3; ++c) {
+          channel[c] = simd_internal::Blend(rgb[0][c], rgb[1][c], rgb[2][c],
+                                            rgb[3][c], dx, dy);
+        }
+        simd_internal::StoreRgb(dst, channel[0], channel[1], channel[2]);
+      });
+}
+
+inline int NearestSpan(const YuvSource& source,
+                       float row_x,
+                       float row_y,
+                       float step_x,
+                       float step_y,
+                       float* out,
+                       int begin,
+                       int end) {
+  return simd_internal::ForEachQuad(
+      row_x, row_y, step_x, step_y, out, begin, end,
+      [&source](int32x4_t xi, int32x4_t yi, float32x4_t, float32x4_t,
+                float* dst) {
+        int32_t xs[4];
+        int32_t ys[4];
+        int32_t luma[4];
+        int32_t u[4];
+        int32_t v[4];
+        vst1q_s32(xs, xi);
+        vst1q_s32(ys, yi);
+        simd_internal::GatherYuvPixels(source, xs, ys, luma, u, v);
+        float32x4_t rgb[3];
+        simd_internal::YuvToRgb4(vld1q_s32(luma), vld1q_s32(u), vld1q_s32(v),
+                                 &rgb[0], &rgb[1], &rgb[2]);
+        simd_internal::StoreRgb(dst, simd_internal::Normalize(rgb[0]),
+                                simd_internal::Normalize(rgb[1]),
+                                simd_internal::Normalize(rgb[2]));
+      });
+}
+
+#endif  // MP_SIMD_SSE2 / MP_SIMD_NEON
+
+// AVX2 kernels for KernelIsa::kAvx2. Each handles a multiple of its vector
+// width and returns where it stopped; the baseline kernel finishes the rest.
+#if defined(MP_SIMD_AVX2)
+
+namespace simd_internal {
+
+MP_TARGET_AVX2 inline __m256i PairConstantAvx2(int lo, int hi) {
+  return _mm256_set1_epi32(static_cast<int32_t>(
+      (static_cast<uint32_t>(static_cast<uint16_t>(hi)) << 16) |
+      static_cast<uint16_t>(lo)));
+}
+
+// YuvToRgb4 for 8 pixels.
+MP_TARGET_AVX2 inline void YuvToRgb8(__m256i y,
+                                     __m256i u,
+                                     __m256i v,
+                                     __m256* r,
+                                     __m256* g,
+                                     __m256* b) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max = _mm256_set1_epi32(255);
+  const __m256i c =
+      _mm256_max_epi32(_mm256_sub_epi32(y, _mm256_set1_epi32(16)), zero);
+  const __m256i d = _mm256_sub_epi32(u, _mm256_set1_epi32(128));
+  const __m256i e = _mm256_sub_epi32(v, _mm256_set1_epi32(128));
+  const __m256i round = _mm256_set1_epi32(128);
+  const __m256i ce = _mm256_or_si256(c, _mm256_slli_epi32(e, 16));
+  const __m256i cd = _mm256_or_si256(c, _mm256_slli_epi32(d, 16));
+  const __m256i r32 = _mm256_srai_epi32(
+      _mm256_add_epi32(_mm256_madd_epi16(ce, PairConstantAvx2(298, 409)),
+                       round),
+      8);
+  const __m256i g32 = _mm256_srai_epi32(
+      _mm256_add_epi32(
+          _mm256_add_epi32(_mm256_madd_epi16(cd, PairConstantAvx2(298, -100)),
+                           _mm256_madd_epi16(e, PairConstantAvx2(-208, 0))),
+          round),
+      8);
+  const __m256i b32 = _mm256_srai_epi32(
+      _mm256_add_epi32(_mm256_madd_epi16(cd, PairConstantAvx2(298, 516)),
+                       round),
+      8);
+  *r = _mm256_cvtepi32_ps(_mm256_min_epi32(_mm256_max_epi32(r32, zero), max));
+  *g = _mm256_cvtepi32_ps(_mm256_min_epi32(_mm256_max_epi32(g32, zero), max));
+  *b = _mm256_cvtepi32_ps(_mm256_min_epi32(_mm256_max_epi32(b32, zero), max));
+}
+
+// Nv21ToRgba8 for 16 pixels. Each 128-bit lane converts 8 of them, so the
+// two halves are swapped back into order on the way out.
+MP_TARGET_AVX2 inline void Nv21ToRgba16(const uint8_t* luma,
+                                        const uint8_t* vu,
+                                        uint8_t* dst) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i y16 = _mm256_cvtepu8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(luma)));
+  const __m256i vu16 = _mm256_sub_epi16(
+      _mm256_cvtepu8_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(vu))),
+      _mm256_set1_epi16(128));
+  const __m256i c =
+      _mm256_max_epi16(_mm256_sub_epi16(y16, _mm256_set1_epi16(16)), zero);
+  const __m256i e = _mm256_shufflehi_epi16(
+      _mm256_shufflelo_epi16(vu16, _MM_SHUFFLE(2, 2, 0, 0)),
+      _MM_SHUFFLE(2, 2, 0, 0));
+  const __m256i d = _mm256_shufflehi_epi16(
+      _mm256_shufflelo_epi16(vu16, _MM_SHUFFLE(3, 3, 1, 1)),
+      _MM_SHUFFLE(3, 3, 1, 1));
+  const __m256i one = _mm256_set1_epi16(1);
+  const __m256i round = _mm256_set1_epi32(128);
+  __m256i channel[3][2];
+  for (int half = 0; half < 2; ++half) {
+    const __m256i ce =
+        half ? _mm256_unpackhi_epi16(c, e) : _mm256_unpacklo_epi16(c, e);
+    const __m256i cd =
+        half ? _mm256_unpackhi_epi16(c, d) : _mm256_unpacklo_epi16(c, d);
+    const __m256i e1 =
+        half ? _mm256_unpackhi_epi16(e, one) : _mm256_unpacklo_epi16(e, one);
+    channel[0][half] = _mm256_srai_epi32(
+        _mm256_add_epi32(_mm256_madd_epi16(ce, PairConstantAvx2(298, 409)),
+                         round),
+        8);
+    channel[1][half] = _mm256_srai_epi32(
+        _mm256_add_epi32(_mm256_madd_epi16(cd, PairConstantAvx2(298, -100)),
+                         _mm256_madd_epi16(e1, PairConstantAvx2(-208, 128))),
+        8);
+    channel[2][half] = _mm256_srai_epi32(
+        _mm256_add_epi32(_mm256_madd_epi16(cd, PairConstantAvx2(298, 516)),
+                         round),
+        8);
+  }
+  const __m256i r = _mm256_packus_epi16(
+      _mm256_packs_epi32(channel[0][0], channel[0][1]), zero);
+  const __m256i g = _mm256_packus_epi16(
+      _mm256_packs_epi32(channel[1][0], channel[1][1]), zero);
+  const __m256i b = _mm256_packus_epi16(
+      _mm256_packs_epi32(channel[2][0], channel[2][1]), zero);
+  const __m256i rg = _mm256_unpacklo_epi8(r, g);
+  const __m256i ba = _mm256_unpacklo_epi8(b, _mm256_set1_epi8(-1));
+  const __m256i lo = _mm256_unpacklo_epi16(rg, ba);  // pixels 0-3, 8-11
+  const __m256i hi = _mm256_unpackhi_epi16(rg, ba);  // pixels 4-7, 12-15
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                      _mm256_permute2x128_si256(lo, hi, 0x20));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32),
+                      _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+MP_TARGET_AVX2 inline int Nv21RowToRgbaAvx2(const uint8_t* luma,
+                                            const uint8_t* vu,
+                                            int count,
+                                            uint8_t* dst) {
+  int x = 0;
+  for (; x + 16 <= count; x += 16) {
+    Nv21ToRgba16(luma + x, vu + x, dst + x * 4);
+  }
+  return x;
+}
+
+// Writes 32 V,U pairs.
+MP_TARGET_AVX2 inline void StoreVuPairs32(__m256i u, __m256i v, uint8_t* dst) {
+  const __m256i lo = _mm256_unpacklo_epi8(v, u);  // pairs 0-7, 16-23
+  const __m256i hi = _mm256_unpackhi_epi8(v, u);  // pairs 8-15, 24-31
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                      _mm256_permute2x128_si256(lo, hi, 0x20));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32),
+                      _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+// Loads the 32 even bytes of `src`.
+MP_TARGET_AVX2 inline __m256i EvenBytes32(const uint8_t* src) {
+  const __m256i even = _mm256_set1_epi16(0x00FF);
+  const __m256i packed = _mm256_packus_epi16(
+      _mm256_and_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src)), even),
+      _mm256_and_si256(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32)),
+          even));
+  // packus works per lane, leaving the 8-byte groups in order 0, 2, 1, 3.
+  return _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+// InterleaveVuSpan for 32 pairs per step, with the same read bounds.
+MP_TARGET_AVX2 inline int InterleaveVuSpanAvx2(const uint8_t* u,
+                                               const uint8_t* v,
+                                               int pixel_stride,
+                                               int count,
+                                               uint8_t* dst) {
+  int x = 0;
+  if (pixel_stride == 1) {
+    for (; x + 32 <= count; x += 32) {
+      StoreVuPairs32(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + x)),
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + x)),
+          dst + x * 2);
+    }
+  } else if (pixel_stride == 2) {
+    for (; x + 32 < count; x += 32) {
+      StoreVuPairs32(EvenBytes32(u + static_cast<size_t>(x) * 2),
+                     EvenBytes32(v + static_cast<size_t>(x) * 2),
+                     dst + x * 2);
+    }
+  }
+  return x;
+}
+
+// Adds the first multiple of 16 of `count` bytes of `line` to `sums`.
+MP_TARGET_AVX2 inline int AccumulateRowAvx2(const uint8_t* line,
+                                            int count,
+                                            uint16_t* sums) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256i* sum = reinterpret_cast<__m256i*>(sums + i);
+    _mm256_storeu_si256(
+        sum, _mm256_add_epi16(
+                 _mm256_loadu_si256(sum),
+                 _mm256_cvtepu8_epi16(_mm_loadu_si128(
+                     reinterpret_cast<const __m128i*>(line + i)))));
+  }
+  return i;
+}
+
+}  // namespace simd_internal
+
+MP_TARGET_AVX2 inline int BilinearSpanAvx2(const YuvSource& source,
+                                           float row_x,
+                                           float row_y,
+                                           float step_x,
+                                           float step_y,
+                                           float* out,
+                                           int begin,
+                                           int end) {
+  const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256 scale = _mm256_set1_ps(kPixelScale);
+  const __m256 offset = _mm256_set1_ps(kPixelOffset);
+  int x = begin;
+  for (; x + 8 <= end; x += 8) {
+    const __m256 index = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)),
+                                       lane);
+    const __m256 sx = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(step_x), index),
+                                    _mm256_set1_ps(row_x));
+    const __m256 sy = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(step_y), index),
+                                    _mm256_set1_ps(row_y));
+    const __m256i xi = _mm256_cvttps_epi32(sx);
+    const __m256i yi = _mm256_cvttps_epi32(sy);
+    const __m256 dx = _mm256_sub_ps(sx, _mm256_cvtepi32_ps(xi));
+    const __m256 dy = _mm256_sub_ps(sy, _mm256_cvtepi32_ps(yi));
+    alignas(32) int32_t xs[8];
+    alignas(32) int32_t ys[8];
+    alignas(32) int32_t luma[4][8];
+    alignas(32) int32_t u[4][8];
+    alignas(32) int32_t v[4][8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(xs), xi);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(ys), yi);
+    simd_internal::GatherYuvTaps(source, xs, ys, luma, u, v);
+    __m256 rgb[4][3];
+    for (int t = 0; t < 4; ++t) {
+      simd_internal::YuvToRgb8(
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(luma[t])),
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(u[t])),
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(v[t])),
+          &rgb[t][0], &rgb[t][1], &rgb[t][2]);
+    }
+    __m256 channel[3];
+    for (int c = 0; c < 3; ++c) {
+      const __m256 top = _mm256_add_ps(
+          rgb[0][c], _mm256_mul_ps(_mm256_sub_ps(rgb[1][c], rgb[0][c]), dx));
+      const __m256 bottom = _mm256_add_ps(
+          rgb[2][c], _mm256_mul_ps(_mm256_sub_ps(rgb[3][c], rgb[2][c]), dx));
+      const __m256 value =
+          _mm256_add_ps(top, _mm256_mul_ps(_mm256_sub_ps(bottom, top), dy));
+      channel[c] = _mm256_add_ps(_mm256_mul_ps(value, scale), offset);
+    }
+    simd_internal::StoreRgb(out + x * 3, _mm256_castps256_ps128(channel[0]),
+                            _mm256_castps256_ps128(channel[1]),
+                            _mm256_castps256_ps128(channel[2]));
+    simd_internal::StoreRgb(out + (x + 4) * 3,
+                            _mm256_extractf128_ps(channel[0], 1),
+                            _mm256_extractf128_ps(channel[1], 1),
+                            _mm256_extractf128_ps(channel[2], 1));
+  }
+  return x;
+}
+
+#else
+
+namespace simd_internal {
+
+inline int Nv21RowToRgbaAvx2(const uint8_t*, const uint8_t*, int, uint8_t*) {
+  return 0;
+}
+inline int InterleaveVuSpanAvx2(const uint8_t*, const uint8_t*, int, int,
+                                uint8_t*) {
+  return 0;
+}
+inline int AccumulateRowAvx2(const uint8_t*, int, uint16_t*) { return 0; }
+
+}  // namespace simd_internal
+
+#endif  // MP_SIMD_AVX2
+
+// Converts `count` pixels of one NV21 row to packed RGBA. `luma` and `vu`
+// point at the same even column of the Y row and of its VU row.
+inline void Nv21RowToRgba(const uint8_t* luma,
+                          const uint8_t* vu,
+                          int count,
+                          uint8_t* dst,
+                          KernelIsa isa = kBaselineKernelIsa) {
+  int x = 0;
+  if (isa == KernelIsa::kAvx2) {
+    x = simd_internal::Nv21RowToRgbaAvx2(luma, vu, count, dst);
+  }
+#if defined(MP_SIMD_SSE2) || defined(MP_SIMD_NEON)
+  for (; x + 8 <= count; x += 8) {
+    simd_internal::Nv21ToRgba8(luma + x, vu + x, dst + x * 4);
+  }
+#endif
+  for (; x < count; ++x) {
+    const uint8_t* chroma = vu + (x & ~1);
+    YuvToRgb(luma[x], chroma[1], chroma[0], dst + x * 4);
+    dst[x * 4 + 3] = 255;
+  }
+}
+
+namespace simd_internal {
+
+// Interleaves chroma samples `u[i * pixel_stride]` / `v[i * pixel_stride]`
+// into V,U pairs for pixel strides 1 and 2. Returns the number of pairs
+// written; the caller finishes the rest. The stride-2 loop never reads past
+// the last sample, since YUV_420_888 planes end right after it.
+#if defined(MP_SIMD_SSE2)
+
+inline int InterleaveVuSpan(const uint8_t* u,
+                            const uint8_t* v,
+                            int pixel_stride,
+                            int count,
+                            uint8_t* dst) {
+  int x = 0;
+  if (pixel_stride == 1) {
+    for (; x + 16 <= count; x += 16) {
+      const __m128i u16 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x));
+      const __m128i v16 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2),
+                       _mm_unpacklo_epi8(v16, u16));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2 + 16),
+                       _mm_unpackhi_epi8(v16, u16));
+    }
+  } else if (pixel_stride == 2) {
+    const __m128i even = _mm_set1_epi16(0x00FF);
+    for (; x + 16 < count; x += 16) {
+      const uint8_t* u_src = u + static_cast<size_t>(x) * 2;
+      const uint8_t* v_src = v + static_cast<size_t>(x) * 2;
+      const __m128i u16 = _mm_packus_epi16(
+          _mm_and_si128(
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(u_src)), even),
+          _mm_and_si128(
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(u_src + 16)),
+              even));
+      const __m128i v16 = _mm_packus_epi16(
+          _mm_and_si128(
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(v_src)), even),
+          _mm_and_si128(
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(v_src + 16)),
+              even));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2),
+                       _mm_unpacklo_epi8(v16, u16));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2 + 16),
+                       _mm_unpackhi_epi8(v16, u16));
+    }
+  }
+  return x;
+}
+
+#elif defined(MP_SIMD_NEON)
+
+inline int InterleaveVuSpan(const uint8_t* u,
+                            const uint8_t* v,
+                            int pixel_stride,
+                            int count,
+                            uint8_t* dst) {
+  int x = 0;
+  if (pixel_stride == 1) {
+    for (; x + 16 <= count; x += 16) {
+      uint8x16x2_t vu;
+      vu.val[0] = vld1q_u8(v + x);
+      vu.val[1] = vld1q_u8(u + x);
+      vst2q_u8(dst + x * 2, vu);
+    }
+  } else if (pixel_stride == 2) {
+    for (; x + 16 < count; x += 16) {
+      uint8x16x2_t vu;
+      vu.val[0] = vld2q_u8(v + static_cast<size_t>(x) * 2).val[0];
+      vu.val[1] = vld2q_u8(u + static_cast<size_t>(x) * 2).val[0];
+      vst2q_u8(dst + x * 2, vu);
+    }
+  }
+  return x;
+}
+
+#else
+
+inline int InterleaveVuSpan(const uint8_t*, const uint8_t*, int, int,
+                            uint8_t*) {
+  return 0;
+}
+
+#endif
+
+}  // namespace simd_internal
+
+// Writes `count` V,U pairs of chroma row `row`, starting at chroma column
+// `column`, to `dst` in NV21 order.
+inline void PackVuRow(const YuvSource& source,
+                      int row,
+                      int column,
+                      int count,
+                      uint8_t* dst,
+                      KernelIsa isa = kBaselineKernelIsa) {
+  const size_t first = static_cast<size_t>(row) * source.uv_bytes_per_row +
+                       static_cast<size_t>(column) * source.uv_pixel_stride;
+  const uint8_t* u = source.u + first;
+  const uint8_t* v = source.v + first;
+  int x = 0;
+  if (isa == KernelIsa::kAvx2) {
+    x = simd_internal::InterleaveVuSpanAvx2(u, v, source.uv_pixel_stride,
+                                            count, dst);
+  }
+  x += simd_internal::InterleaveVuSpan(u + static_cast<size_t>(x) *
+                                               source.uv_pixel_stride,
+                                       v + static_cast<size_t>(x) *
+                                               source.uv_pixel_stride,
+                                       source.uv_pixel_stride, count - x,
+                                       dst + x * 2);
+  for (; x < count; ++x) {
+    const size_t offset = static_cast<size_t>(x) * source.uv_pixel_stride;
+    dst[x * 2] = v[offset];
+    dst[x * 2 + 1] = u[offset];
+  }
+}
+
+// Same as PackVuRow, but NV21 sources are returned in place and only other
+// layouts are packed into `scratch` (2 * `count` bytes).
+inline const uint8_t* VuRow(const YuvSource& source,
+                            int row,
+                            int column,
+                            int count,
+                            uint8_t* scratch,
+                            KernelIsa isa = kBaselineKernelIsa) {
+  if (source.IsNv21()) {
+    return source.v + static_cast<size_t>(row) * source.uv_bytes_per_row +
+           static_cast<size_t>(column) * 2;
+  }
+  PackVuRow(source, row, column, count, scratch, isa);
+  return scratch;
+}
+
+// Box-filters an 8-bit plane of `channels` interleaved samples by `factor`
+// in both directions. Only `in_width` x `in_height` samples of `src` are
+// valid; blocks that run past them repeat the last valid row/column.
+// `factor` is a power of two no larger than 16 so the column sums fit
+// `sums`, which must hold `in_width * channels` entries.
+inline void BoxDownsamplePlane(const uint8_t* src,
+                               int src_bytes_per_row,
+                               int in_width,
+                               int in_height,
+                               int channels,
+                               int factor,
+                               int out_width,
+                               int out_height,
+                               uint16_t* sums,
+                               uint8_t* dst,
+                               int dst_bytes_per_row,
+                               KernelIsa isa = kBaselineKernelIsa) {
+  int shift = 0;
+  while ((1 << shift) < factor * factor) {
+    ++shift;
+  }
+  const int round = (1 << shift) >> 1;
+  const int span = in_width * channels;
+  for (int row = 0; row < out_height; ++row) {
+    std::fill(sums, sums + span, static_cast<uint16_t>(0));
+    for (int r = 0; r < factor; ++r) {
+      const int y = std::min(row * factor + r, in_height - 1);
+      const uint8_t* line = src + static_cast<size_t>(y) * src_bytes_per_row;
+      int i = 0;
+      if (isa == KernelIsa::kAvx2) {
+        i = simd_internal::AccumulateRowAvx2(line, span, sums);
+      }
+      for (; i < span; ++i) {
+        sums[i] = static_cast<uint16_t>(sums[i] + line[i]);
+      }
+    }
+    uint8_t* out = dst + static_cast<size_t>(row) * dst_bytes_per_row;
+    for (int x = 0; x < out_width; ++x) {
+      const int first = x * factor;
+      // Blocks past the last valid column repeat it entirely.
+      const int full = std::max(std::min(factor, in_width - first), 0);
+      for (int c = 0; c < channels; ++c) {
+        int total = 0;
+        for (int k = 0; k < full; ++k) {
+          total += sums[(first + k) * channels + c];
+        }
+        total += (factor - full) * sums[(in_width - 1) * channels + c];
+        out[x * channels + c] = static_cast<uint8_t>((total + round) >> shift);
+      }
+    }
+  }
+}
+
+}  // namespace mp
+
+#endif  // YUV_SIMD_H_
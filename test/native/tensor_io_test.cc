@@ -0,0 +1,202 @@
+// Checks tensor encoding and decoding with each kernel set against scalar
+// conversions: float16 through the binary16 definition, integer types
+// through the affine quantization formula.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tensor_io.h"
+#include "test_util.h"
+
+namespace {
+
+using mp_test::KernelIsas;
+
+float FromBits(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Odd lengths leave a scalar tail after every vector loop.
+std::vector<float> TestValues(int count, float range, uint32_t seed) {
+  const std::vector<uint8_t> noise = mp_test::RandomBytes(
+      static_cast<size_t>(count) * 2, seed);
+  std::vector<float> values(count);
+  for (int i = 0; i < count; ++i) {
+    const int bits = noise[i * 2] << 8 | noise[i * 2 + 1];
+    values[i] = (static_cast<float>(bits) / 32767.5f - 1.0f) * range;
+  }
+  return values;
+}
+
+// Every half decodes to the float it denotes and encodes back to itself.
+void HalfRoundTripsExhaustively() {
+  for (uint32_t half = 0; half <= 0xFFFFu; ++half) {
+    const uint32_t exponent = (half >> 10) & 0x1Fu;
+    const uint32_t mantissa = half & 0x3FFu;
+    const float magnitude =
+        exponent == 0x1Fu
+            ? (mantissa ? NAN : INFINITY)
+            : std::ldexp(static_cast<float>(exponent ? mantissa | 0x400u
+                                                     : mantissa),
+                         static_cast<int>(exponent ? exponent : 1) - 25);
+    const float expected = (half & 0x8000u) ? -magnitude : magnitude;
+    const float value = mp::HalfToFloat(static_cast<uint16_t>(half));
+    if (std::isnan(expected)) {
+      MP_EXPECT(std::isnan(value));
+      MP_EXPECT((mp::FloatToHalf(value) & 0x7C00u) == 0x7C00u &&
+                (mp::FloatToHalf(value) & 0x3FFu) != 0);
+      continue;
+    }
+    if (value != expected || std::signbit(value) != std::signbit(expected) ||
+        mp::FloatToHalf(value) != half) {
+      std::printf("half 0x%04x: decoded %g, expected %g\n", half, value,
+                  expected);
+      ++mp_test::FailureCount();
+    }
+  }
+}
+
+// Ties round to even, overflow saturates to infinity, tiny values flush.
+void FloatToHalfRounds() {
+  struct Case {
+    float value;
+    uint16_t half;
+  };
+  const Case cases[] = {
+      {1.0f + std::ldexp(1.0f, -11), 0x3C00u},
+      {1.0f + 3.0f * std::ldexp(1.0f, -11), 0x3C02u},
+      {65504.0f, 0x7BFFu},
+      {65520.0f, 0x7C00u},
+      {-1e9f, 0xFC00u},
+      {std::ldexp(1.0f, -25), 0x0000u},
+      {std::ldexp(1.5f, -25), 0x0001u},
+      {std::ldexp(3.0f, -25), 0x0002u},
+      {-0.0f, 0x8000u},
+      {FromBits(0x33000001u), 0x0001u},
+  };
+  for (const Case& test : cases) {
+    const uint16_t half = mp::FloatToHalf(test.value);
+    if (half != test.half) {
+      std::printf("FloatToHalf(%a) = 0x%04x, expected 0x%04x\n", test.value,
+                  half, test.half);
+      ++mp_test::FailureCount();
+    }
+  }
+}
+
+void Float16SpansMatchScalar() {
+  mp::TensorEncoding encoding;
+  encoding.element = mp::TensorElement::kFloat16;
+  for (int count : {1, 7, 8, 9, 63, 1000}) {
+    std::vector<float> values = TestValues(count, 70000.0f, count);
+    values[0] = std::ldexp(1.0f, -20);
+    for (mp::KernelIsa isa : KernelIsas()) {
+      std::vector<uint16_t> encoded(count);
+      std::vector<float> decoded(count);
+      mp::EncodeTensorValues(values.data(), count, encoding, encoded.data(),
+                             isa);
+      mp::DecodeTensorValues(encoded.data(), count, encoding, decoded.data(),
+                             isa);
+      for (int i = 0; i < count; ++i) {
+        const uint16_t half = mp::FloatToHalf(values[i]);
+        const float value = mp::HalfToFloat(half);
+        if (encoded[i] != half || decoded[i] != value) {
+          std::printf("float16/%s/%d: value %d (%g) encoded 0x%04x, "
+                      "expected 0x%04x\n",
+                      mp::KernelIsaName(isa), count, i, values[i], encoded[i],
+                      half);
+          ++mp_test::FailureCount();
+          break;
+        }
+      }
+    }
+  }
+}
+
+void QuantizedSpansMatchFormula() {
+  struct Case {
+    mp::TensorElement element;
+    float scale;
+    int32_t zero_point;
+  };
+  const Case cases[] = {
+      {mp::TensorElement::kUint8, 1.0f / 64.0f, 128},
+      {mp::TensorElement::kUint8, 0.0123f, 3},
+      {mp::TensorElement::kInt8, 1.0f / 64.0f, 0},
+      {mp::TensorElement::kInt8, 0.0271f, -17},
+  };
+  for (const Case& test : cases) {
+    mp::TensorEncoding encoding;
+    encoding.element = test.element;
+    encoding.scale = test.scale;
+    encoding.zero_point = test.zero_point;
+    const bool is_signed = test.element == mp::TensorElement::kInt8;
+    const double lowest = is_signed ? -128.0 : 0.0;
+    for (int count : {1, 15, 16, 17, 333}) {
+      const std::vector<float> values = TestValues(count, 3.0f, count + 9);
+      for (mp::KernelIsa isa : KernelIsas()) {
+        std::vector<uint8_t> encoded(count);
+        std::vector<float> decoded(count);
+        mp::EncodeTensorValues(values.data(), count, encoding, encoded.data(),
+                               isa);
+        mp::DecodeTensorValues(encoded.data(), count, encoding,
+                               decoded.data(), isa);
+        for (int i = 0; i < count; ++i) {
+          const double q = std::fmin(
+              std::fmax(std::floor(values[i] / static_cast<double>(test.scale) +
+                                   test.zero_point + 0.5),
+                        lowest),
+              lowest + 255.0);
+          const int stored = is_signed ? static_cast<int8_t>(encoded[i])
+                                       : static_cast<int>(encoded[i]);
+          const float real = test.scale * static_cast<float>(
+                                              stored - test.zero_point);
+          if (stored != static_cast<int>(q) || decoded[i] != real) {
+            std::printf("%s/%s/%d: value %d (%g) stored %d, expected %d\n",
+                        is_signed ? "int8" : "uint8", mp::KernelIsaName(isa),
+                        count, i, values[i], stored, static_cast<int>(q));
+            ++mp_test::FailureCount();
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+void DenormalizeMatchesFormula() {
+  for (int count : {1, 15, 16, 17, 301}) {
+    const std::vector<float> values = TestValues(count, 1.2f, count + 40);
+    std::vector<uint8_t> out(count);
+    mp::DenormalizePixels(values.data(), count, out.data());
+    for (int i = 0; i < count; ++i) {
+      const double expected = std::fmin(
+          std::fmax(std::floor((values[i] + 1.0) * 127.5 + 0.5), 0.0), 255.0);
+      if (out[i] != static_cast<int>(expected)) {
+        std::printf("denormalize/%d: value %d (%g) gave %d, expected %d\n",
+                    count, i, values[i], out[i], static_cast<int>(expected));
+        ++mp_test::FailureCount();
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  static const mp_test::TestCase kTests[] = {
+      {"HalfRoundTripsExhaustively", HalfRoundTripsExhaustively},
+      {"FloatToHalfRounds", FloatToHalfRounds},
+      {"Float16SpansMatchScalar", Float16SpansMatchScalar},
+      {"QuantizedSpansMatchFormula", QuantizedSpansMatchFormula},
+      {"DenormalizeMatchesFormula", DenormalizeMatchesFormula},
+  };
+  return mp_test::RunTests(kTests);
+}
@@ -0,0 +1,314 @@
+#ifndef TEST_NATIVE_TEST_UTIL_H_
+#define TEST_NATIVE_TEST_UTIL_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+#include "cpu_features.h"
+#include "image_warp.h"
+#include "pixel_sources.h"
+
+// Minimal harness for the native kernel tests: every check that fails is
+// printed and counted, and RunTests() turns the count into the exit status
+// ctest reads. The reference samplers below are the plain per-pixel loops the
+// vector kernels, plans and staging paths are meant to reproduce.
+namespace mp_test {
+
+inline int& FailureCount() {
+  static int failures = 0;
+  return failures;
+}
+
+#define MP_EXPECT(condition)                                              \
+  do {                                                                    \
+    if (!(condition)) {                                                   \
+      std::printf("%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+      ++::mp_test::FailureCount();                                        \
+    }                                                                     \
+  } while (0)
+
+struct TestCase {
+  const char* name;
+  void (*run)();
+};
+
+template <size_t kCount>
+int RunTests(const TestCase (&tests)[kCount]) {
+  for (const TestCase& test : tests) {
+    const int before = FailureCount();
+    test.run();
+    std::printf("[%s] %s\n", FailureCount() == before ? "  OK  " : " FAIL ",
+                test.name);
+  }
+  return FailureCount() == 0 ? 0 : 1;
+}
+
+// Compares `count` values against `expected`, skipping expected NaNs (see
+// the reference samplers). Reports the first and the largest mismatch.
+inline bool ExpectNear(const char* what,
+                       const float* actual,
+                       const float* expected,
+                       size_t count,
+                       float tolerance) {
+  size_t mismatches = 0;
+  size_t first = 0;
+  float worst = 0.0f;
+  for (size_t i = 0; i < count; ++i) {
+    if (std::isnan(expected[i])) {
+      continue;
+    }
+    const float error = std::fabs(actual[i] - expected[i]);
+    if (!(error <= tolerance)) {
+      if (mismatches++ == 0) {
+        first = i;
+      }
+      worst = std::isnan(error) ? error : std::fmax(worst, error);
+    }
+  }
+  if (mismatches != 0) {
+    std::printf("%s: %zu of %zu values off by more than %g (first at %zu: "
+                "%g vs %g, worst %g)\n",
+                what, mismatches, count, tolerance, first, actual[first],
+                expected[first], worst);
+    ++FailureCount();
+  }
+  return mismatches == 0;
+}
+
+// Kernel sets this CPU can run: the baseline, plus AVX2 where supported.
+inline std::vector<mp::KernelIsa> KernelIsas() {
+  std::vector<mp::KernelIsa> isas = {mp::kBaselineKernelIsa};
+  if (mp::CpuSupportsAvx2()) {
+    isas.push_back(mp::KernelIsa::kAvx2);
+  }
+  return isas;
+}
+
+// Deterministic noise, so failures reproduce.
+inline std::vector<uint8_t> RandomBytes(size_t count, uint32_t seed) {
+  std::vector<uint8_t> bytes(count);
+  uint32_t state = seed * 2654435761u + 1u;
+  for (uint8_t& byte : bytes) {
+    state = state * 1664525u + 1013904223u;
+    byte = static_cast<uint8_t>(state >> 24);
+  }
+  return bytes;
+}
+
+// Positions closer than this to a sampling boundary may legitimately land on
+// either side in a kernel that evaluates them in a different order.
+constexpr float kBoundaryEpsilon = 1e-3f;
+
+inline bool NearBoundary(float position, float limit) {
+  return std::fabs(position) < kBoundaryEpsilon ||
+         std::fabs(position - limit) < kBoundaryEpsilon;
+}
+
+inline void FillNan(float* out) {
+  out[0] = out[1] = out[2] = std::numeric_limits<float>::quiet_NaN();
+}
+
+// Scalar bilinear warp: black outside the source, taps clamped on the last
+// row/column. Pixels on the inside/outside boundary come out as NaN.
+template <typename Source>
+void ReferenceBilinear(const Source& source,
+                       const mp::WarpTransform& m,
+                       int width,
+                       int height,
+                       float* dst) {
+  const float last_x = static_cast<float>(source.width - 1);
+  const float last_y = static_cast<float>(source.height - 1);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      float* out = dst + (static_cast<size_t>(y) * width + x) * 3;
+      const float sx = m.xx * static_cast<float>(x) +
+                       m.xy * static_cast<float>(y) + m.xt;
+      const float sy = m.yx * static_cast<float>(x) +
+                       m.yy * static_cast<float>(y) + m.yt;
+      if (NearBoundary(sx, last_x) || NearBoundary(sy, last_y)) {
+        FillNan(out);
+        continue;
+      }
+      if (sx < 0.0f || sy < 0.0f || sx > last_x || sy > last_y) {
+        out[0] = out[1] = out[2] = mp::kPixelOffset;
+        continue;
+      }
+      const int x0 = static_cast<int>(std::floor(sx));
+      const int y0 = static_cast<int>(std::floor(sy));
+      const int x1 = x0 + 1 < source.width ? x0 + 1 : x0;
+      const int y1 = y0 + 1 < source.height ? y0 + 1 : y0;
+      const float dx = sx - static_cast<float>(x0);
+      const float dy = sy - static_cast<float>(y0);
+      float p00[3];
+      float p10[3];
+      float p01[3];
+      float p11[3];
+      source.Tap(x0, y0, p00);
+      source.Tap(x1, y0, p10);
+      source.Tap(x0, y1, p01);
+      source.Tap(x1, y1, p11);
+      for (int c = 0; c < 3; ++c) {
+        const float top = p00[c] + (p10[c] - p00[c]) * dx;
+        const float bottom = p01[c] + (p11[c] - p01[c]) * dx;
+        out[c] = (top + (bottom - top) * dy) / 127.5f - 1.0f;
+      }
+    }
+  }
+}
+
+// Scalar nearest-neighbour warp over the same inside test as
+// ReferenceBilinear. Positions halfway between two taps come out as NaN.
+template <typename Source>
+void ReferenceNearest(const Source& source,
+                      const mp::WarpTransform& m,
+                      int width,
+                      int height,
+                      float* dst) {
+  const float last_x = static_cast<float>(source.width - 1);
+  const float last_y = static_cast<float>(source.height - 1);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      float* out = dst + (static_cast<size_t>(y) * width + x) * 3;
+      const float sx = m.xx * static_cast<float>(x) +
+                       m.xy * static_cast<float>(y) + m.xt;
+      const float sy = m.yx * static_cast<float>(x) +
+                       m.yy * static_cast<float>(y) + m.yt;
+      const float fx = sx + 0.5f - std::floor(sx + 0.5f);
+      const float fy = sy + 0.5f - std::floor(sy + 0.5f);
+      if (NearBoundary(sx, last_x) || NearBoundary(sy, last_y) ||
+          NearBoundary(fx, 1.0f) || NearBoundary(fy, 1.0f)) {
+        FillNan(out);
+        continue;
+      }
+      if (sx < 0.0f || sy < 0.0f || sx > last_x || sy > last_y) {
+        out[0] = out[1] = out[2] = mp::kPixelOffset;
+        continue;
+      }
+      float rgb[3];
+      source.Tap(static_cast<int>(std::floor(sx + 0.5f)),
+                 static_cast<int>(std::floor(sy + 0.5f)), rgb);
+      for (int c = 0; c < 3; ++c) {
+        out[c] = rgb[c] / 127.5f - 1.0f;
+      }
+    }
+  }
+}
+
+// One crop geometry: a raw frame, a logical-space ROI and the output size.
+struct WarpCase {
+  const char* name;
+  int source_width;
+  int source_height;
+  mp::RectInPixels roi;
+  int rotation_degrees;
+  bool mirror_horizontal;
+  int target_width;
+  int target_height;
+
+  mp::WarpTransform Transform() const {
+    return mp::MakeWarpTransform(roi, target_width, target_height,
+                                 rotation_degrees, mirror_horizontal,
+                                 source_width, source_height);
+  }
+};
+
+// Odd frame and output sizes, every camera rotation, mirroring, rotated and
+// axis-aligned ROIs, up- and downscaling, and ROIs that leave the frame.
+// Centers sit off the half-pixel grid so few positions land exactly on a
+// boundary.
+inline std::vector<WarpCase> WarpCases() {
+  return {
+      {"inside", 101, 77, {50.3f, 38.2f, 60.0f, 50.0f, 0.0f}, 0, false, 37, 29},
+      {"rotated", 101, 77, {50.3f, 38.2f, 60.0f, 50.0f, 0.35f}, 0, false, 37,
+       29},
+      {"partly_outside", 101, 77, {12.1f, 70.4f, 90.0f, 66.0f, 0.0f}, 0,
+       false, 41, 33},
+      {"rotated_outside", 101, 77, {95.7f, 5.3f, 80.0f, 80.0f, -0.6f}, 0,
+       false, 33, 33},
+      {"camera_90", 77, 101, {40.1f, 60.6f, 70.0f, 70.0f, 0.0f}, 90, false, 35,
+       35},
+      {"camera_180_mirror", 101, 77, {60.2f, 30.9f, 70.0f, 44.0f, 0.0f}, 180,
+       true, 39, 25},
+      {"camera_270_mirror", 77, 101, {30.4f, 50.1f, 90.0f, 90.0f, 0.2f}, 270,
+       true, 31, 31},
+      {"upscale", 101, 77, {20.6f, 20.3f, 12.0f, 10.0f, 0.0f}, 0, false, 45,
+       37},
+      {"downscale", 301, 203, {150.3f, 100.6f, 290.0f, 190.0f, 0.0f}, 0,
+       false, 29, 19},
+      {"outside", 101, 77, {400.3f, 300.2f, 30.0f, 30.0f, 0.0f}, 0, false, 17,
+       17},
+  };
+}
+
+// Owns the bytes behind a packed source with padded rows.
+struct PackedImage {
+  std::vector<uint8_t> pixels;
+  int width = 0;
+  int height = 0;
+  int bytes_per_row = 0;
+
+  PackedImage(int w, int h, uint32_t seed)
+      : width(w), height(h), bytes_per_row(w * 4 + 12) {
+    pixels = RandomBytes(static_cast<size_t>(bytes_per_row) * h, seed);
+  }
+
+  template <int kR, int kB>
+  mp::PackedPixelSource<kR, kB> Source() const {
+    return {pixels.data(), width, height, bytes_per_row};
+  }
+};
+
+// Owns the planes behind a 4:2:0 source. Stride 2 lays the chroma out as
+// one interleaved plane (NV21 when `v_first`, NV12 otherwise); stride 1 as
+// separate U and V planes. Rows are padded and every plane ends right after
+// its last sample, like YUV_420_888 buffers.
+struct YuvImage {
+  std::vector<uint8_t> luma;
+  std::vector<uint8_t> chroma;
+  std::vector<uint8_t> chroma2;
+  mp::YuvSource source;
+
+  YuvImage(int width, int height, int pixel_stride, bool v_first,
+           uint32_t seed) {
+    const int chroma_width = (width + 1) / 2;
+    const int chroma_height = (height + 1) / 2;
+    const int y_bytes_per_row = width + 5;
+    luma = RandomBytes(static_cast<size_t>(y_bytes_per_row) * height, seed);
+    source.y = luma.data();
+    source.width = width;
+    source.height = height;
+    source.y_bytes_per_row = y_bytes_per_row;
+    source.uv_pixel_stride = pixel_stride;
+    if (pixel_stride == 2) {
+      const int uv_bytes_per_row = chroma_width * 2 + 6;
+      chroma = RandomBytes(
+          static_cast<size_t>(uv_bytes_per_row) * (chroma_height - 1) +
+              chroma_width * 2,
+          seed + 1);
+      source.uv_bytes_per_row = uv_bytes_per_row;
+      source.v = chroma.data() + (v_first ? 0 : 1);
+      source.u = chroma.data() + (v_first ? 1 : 0);
+    } else {
+      const int uv_bytes_per_row = chroma_width + 3;
+      const size_t plane =
+          static_cast<size_t>(uv_bytes_per_row) * (chroma_height - 1) +
+          chroma_width;
+      chroma = RandomBytes(plane, seed + 1);
+      chroma2 = RandomBytes(plane, seed + 2);
+      source.uv_bytes_per_row = uv_bytes_per_row;
+      source.u = chroma.data();
+      source.v = chroma2.data();
+    }
+  }
+
+  YuvImage(const YuvImage&) = delete;
+  YuvImage& operator=(const YuvImage&) = delete;
+};
+
+}  // namespace mp_test
+
+#endif  // TEST_NATIVE_TEST_UTIL_H_
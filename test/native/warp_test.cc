@@ -0,0 +1,298 @@
+// Checks every warp path the preprocessing picks from against the scalar
+// reference samplers: the bilinear and nearest warps with each kernel set,
+// the fixed-point warp, the separable resampler and cached warp plans, over
+// packed and 4:2:0 sources, and that banding the warps over the worker pool
+// does not change their output.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fixed_point_warp.h"
+#include "image_warp.h"
+#include "row_worker_pool.h"
+#include "separable_resize.h"
+#include "test_util.h"
+#include "warp_plan.h"
+
+namespace {
+
+using mp_test::ExpectNear;
+using mp_test::KernelIsas;
+using mp_test::PackedImage;
+using mp_test::WarpCase;
+using mp_test::WarpCases;
+using mp_test::YuvImage;
+
+// Float paths differ from the reference only in how positions are rounded.
+constexpr float kFloatTolerance = 2e-3f;
+// Two 8-bit levels, the documented bound of the fixed-point blend.
+constexpr float kFixedTolerance = 2.0f / 127.5f + 1e-4f;
+
+std::string Label(const WarpCase& test, const char* source, const char* path,
+                  mp::KernelIsa isa) {
+  return std::string(test.name) + "/" + source + "/" + path + "/" +
+         mp::KernelIsaName(isa);
+}
+
+// Runs `warp(dst, row_begin, row_end)` in two uneven row bands, as the
+// worker pool would.
+template <typename Warp>
+std::vector<float> RunBands(const WarpCase& test, Warp warp) {
+  std::vector<float> dst(
+      static_cast<size_t>(test.target_width) * test.target_height * 3, 7.0f);
+  const int split = test.target_height / 3;
+  warp(dst.data(), 0, split);
+  warp(dst.data(), split, test.target_height);
+  return dst;
+}
+
+template <typename Source>
+void CheckFloatWarps(const WarpCase& test, const Source& source,
+                     const char* source_name) {
+  const mp::WarpTransform m = test.Transform();
+  const size_t count =
+      static_cast<size_t>(test.target_width) * test.target_height * 3;
+  std::vector<float> bilinear(count);
+  std::vector<float> nearest(count);
+  mp_test::ReferenceBilinear(source, m, test.target_width,
+                             test.target_height, bilinear.data());
+  mp_test::ReferenceNearest(source, m, test.target_width, test.target_height,
+                            nearest.data());
+
+  for (mp::KernelIsa isa : KernelIsas()) {
+    const std::vector<float> out =
+        RunBands(test, [&](float* dst, int begin, int end) {
+          mp::WarpBilinear(source, m, dst, test.target_width, begin, end, isa);
+        });
+    ExpectNear(Label(test, source_name, "bilinear", isa).c_str(), out.data(),
+               bilinear.data(), count, kFloatTolerance);
+  }
+  const std::vector<float> out =
+      RunBands(test, [&](float* dst, int begin, int end) {
+        mp::WarpNearest(source, m, dst, test.target_width, begin, end);
+      });
+  ExpectNear(Label(test, source_name, "nearest", mp::kBaselineKernelIsa)
+                 .c_str(),
+             out.data(), nearest.data(), count, 1e-6f);
+
+  if (mp::SeparableResampler::Supports(m)) {
+    mp::SeparableResampler resampler;
+    const std::vector<float> separable =
+        RunBands(test, [&](float* dst, int begin, int end) {
+          resampler.Run(source, m, dst, test.target_width, begin, end);
+        });
+    ExpectNear(Label(test, source_name, "separable", mp::kBaselineKernelIsa)
+                   .c_str(),
+               separable.data(), bilinear.data(), count, kFloatTolerance);
+  }
+}
+
+template <int kR, int kB>
+void CheckPackedOnlyWarps(const WarpCase& test,
+                          const mp::PackedPixelSource<kR, kB>& source,
+                          const char* source_name) {
+  const mp::WarpTransform m = test.Transform();
+  const size_t count =
+      static_cast<size_t>(test.target_width) * test.target_height * 3;
+  std::vector<float> expected(count);
+  mp_test::ReferenceBilinear(source, m, test.target_width,
+                             test.target_height, expected.data());
+
+  const std::vector<float> fixed =
+      RunBands(test, [&](float* dst, int begin, int end) {
+        mp::WarpBilinearFixed(source, m, dst, test.target_width, begin, end);
+      });
+  ExpectNear(Label(test, source_name, "fixed", mp::kBaselineKernelIsa).c_str(),
+             fixed.data(), expected.data(), count, kFixedTolerance);
+
+  const mp::WarpPlanKey key = mp::MakeWarpPlanKey(
+      source, test.rotation_degrees, test.mirror_horizontal,
+      mp::QuantizeRoi(test.roi));
+  mp::WarpPlan plan;
+  MP_EXPECT(!plan.Prepare(key, source.width, source.height,
+                          source.bytes_per_row, m, test.target_width,
+                          test.target_height));
+  const bool ready =
+      plan.Prepare(key, source.width, source.height, source.bytes_per_row, m,
+                   test.target_width, test.target_height);
+  MP_EXPECT(ready);
+  if (!ready) {
+    return;
+  }
+  for (mp::KernelIsa isa : KernelIsas()) {
+    for (bool fixed_point : {false, true}) {
+      const std::vector<float> out =
+          RunBands(test, [&](float* dst, int begin, int end) {
+            plan.Apply(source, dst, begin, end, fixed_point, isa);
+          });
+      ExpectNear(Label(test, source_name,
+                       fixed_point ? "plan_fixed" : "plan", isa)
+                     .c_str(),
+                 out.data(), expected.data(), count,
+                 fixed_point ? kFixedTolerance : kFloatTolerance);
+    }
+  }
+}
+
+void PackedWarpsMatchReference() {
+  uint32_t seed = 1;
+  for (const WarpCase& test : WarpCases()) {
+    const PackedImage image(test.source_width, test.source_height, seed++);
+    CheckFloatWarps(test, image.Source<0, 2>(), "rgba");
+    CheckFloatWarps(test, image.Source<2, 0>(), "bgra");
+    CheckPackedOnlyWarps(test, image.Source<0, 2>(), "rgba");
+    CheckPackedOnlyWarps(test, image.Source<2, 0>(), "bgra");
+  }
+}
+
+void YuvWarpsMatchReference() {
+  uint32_t seed = 100;
+  for (const WarpCase& test : WarpCases()) {
+    const YuvImage nv21(test.source_width, test.source_height, 2, true,
+                        seed++);
+    const YuvImage nv12(test.source_width, test.source_height, 2, false,
+                        seed++);
+    const YuvImage i420(test.source_width, test.source_height, 1, false,
+                        seed++);
+    CheckFloatWarps(test, nv21.source, "nv21");
+    CheckFloatWarps(test, nv12.source, "nv12");
+    CheckFloatWarps(test, i420.source, "i420");
+  }
+}
+
+// The vector fixed-point blend is bit-exact with SampleBilinearFixed at the
+// positions the warp computes.
+void FixedWarpMatchesScalarSampler() {
+  uint32_t seed = 50;
+  for (const WarpCase& test : WarpCases()) {
+    const PackedImage image(test.source_width, test.source_height, seed++);
+    const mp::RgbaSource source = image.Source<0, 2>();
+    const mp::WarpTransform m = test.Transform();
+    const size_t count =
+        static_cast<size_t>(test.target_width) * test.target_height * 3;
+    std::vector<float> expected(count);
+    const int tile = mp::WarpTileWidth(m, test.target_width);
+    for (int x_begin = 0; x_begin < test.target_width; x_begin += tile) {
+      const float tile_x = m.xx * static_cast<float>(x_begin);
+      const float tile_y = m.yx * static_cast<float>(x_begin);
+      const int end = std::min(test.target_width, x_begin + tile);
+      for (int y = 0; y < test.target_height; ++y) {
+        const float row_x = m.xy * static_cast<float>(y) + tile_x + m.xt;
+        const float row_y = m.yy * static_cast<float>(y) + tile_y + m.yt;
+        for (int x = x_begin; x < end; ++x) {
+          const float dx = static_cast<float>(x - x_begin);
+          mp::SampleBilinearFixed(
+              source, m.xx * dx + row_x, m.yx * dx + row_y,
+              &expected[(static_cast<size_t>(y) * test.target_width + x) * 3]);
+        }
+      }
+    }
+    std::vector<float> out(count);
+    mp::WarpBilinearFixed(source, m, out.data(), test.target_width, 0,
+                          test.target_height);
+    ExpectNear(Label(test, "rgba", "fixed_exact", mp::kBaselineKernelIsa)
+                   .c_str(),
+               out.data(), expected.data(), count, 0.0f);
+  }
+}
+
+// Splitting a warp into the worker pool's bands, on any thread count, gives
+// the single-threaded output exactly.
+void PoolBandsMatchSingleBand() {
+  constexpr int kTarget = 192;
+  const PackedImage packed(640, 480, 60);
+  const YuvImage yuv(640, 480, 2, true, 61);
+  const mp::RectInPixels rois[] = {
+      {320.4f, 240.7f, 300.0f, 300.0f, 0.0f},
+      {300.2f, 260.9f, 260.0f, 260.0f, 0.45f},
+  };
+  const size_t count = static_cast<size_t>(kTarget) * kTarget * 3;
+  for (const mp::RectInPixels& roi : rois) {
+    const mp::WarpTransform m =
+        mp::MakeWarpTransform(roi, kTarget, kTarget, 0, false, 640, 480);
+    const std::pair<const char*,
+                    std::function<void(float*, int, int, mp::KernelIsa)>>
+        warps[] = {
+            {"rgba",
+             [&](float* dst, int begin, int end, mp::KernelIsa isa) {
+               mp::WarpBilinear(packed.Source<0, 2>(), m, dst, kTarget, begin,
+                                end, isa);
+             }},
+            {"fixed",
+             [&](float* dst, int begin, int end, mp::KernelIsa) {
+               mp::WarpBilinearFixed(packed.Source<0, 2>(), m, dst, kTarget,
+                                     begin, end);
+             }},
+            {"nv21",
+             [&](float* dst, int begin, int end, mp::KernelIsa isa) {
+               mp::WarpBilinear(yuv.source, m, dst, kTarget, begin, end, isa);
+             }},
+        };
+    for (const auto& warp : warps) {
+      for (mp::KernelIsa isa : KernelIsas()) {
+        std::vector<float> expected(count);
+        warp.second(expected.data(), 0, kTarget, isa);
+        for (int threads = 1; threads <= 8; ++threads) {
+          mp::RowWorkerPool pool;
+          pool.Start(threads);
+          std::vector<float> out(count, 7.0f);
+          pool.Run(kTarget, [&](int, int begin, int end) {
+            warp.second(out.data(), begin, end, isa);
+          });
+          ExpectNear((std::string(warp.first) + "/" +
+                      mp::KernelIsaName(isa) + "/threads " +
+                      std::to_string(threads))
+                         .c_str(),
+                     out.data(), expected.data(), count, 0.0f);
+        }
+      }
+    }
+  }
+}
+
+// A plan is only reused for the key, source geometry and output size it was
+// built for, and not after Reset().
+void WarpPlanRebuildsOnChange() {
+  const WarpCase test = WarpCases()[1];
+  const PackedImage image(test.source_width, test.source_height, 7);
+  const mp::RgbaSource source = image.Source<0, 2>();
+  const mp::WarpTransform m = test.Transform();
+  const mp::WarpPlanKey key =
+      mp::MakeWarpPlanKey(source, test.rotation_degrees,
+                          test.mirror_horizontal, mp::QuantizeRoi(test.roi));
+  mp::WarpPlan plan;
+  const auto prepare = [&](const mp::WarpPlanKey& k, int dst_width) {
+    return plan.Prepare(k, source.width, source.height, source.bytes_per_row,
+                        m, dst_width, test.target_height);
+  };
+  MP_EXPECT(!prepare(key, test.target_width));
+  MP_EXPECT(prepare(key, test.target_width));
+  MP_EXPECT(prepare(key, test.target_width));
+  MP_EXPECT(!prepare(key, test.target_width + 1));
+  mp::WarpPlanKey moved = key;
+  moved.roi.center_x += 1.0f;
+  MP_EXPECT(!prepare(moved, test.target_width + 1));
+  MP_EXPECT(prepare(moved, test.target_width + 1));
+  plan.Reset();
+  MP_EXPECT(!plan.Expects(moved));
+  MP_EXPECT(!prepare(moved, test.target_width + 1));
+  MP_EXPECT(prepare(moved, test.target_width + 1));
+}
+
+}  // namespace
+
+int main() {
+  static const mp_test::TestCase kTests[] = {
+      {"PackedWarpsMatchReference", PackedWarpsMatchReference},
+      {"YuvWarpsMatchReference", YuvWarpsMatchReference},
+      {"FixedWarpMatchesScalarSampler", FixedWarpMatchesScalarSampler},
+      {"PoolBandsMatchSingleBand", PoolBandsMatchSingleBand},
+      {"WarpPlanRebuildsOnChange", WarpPlanRebuildsOnChange},
+  };
+  return mp_test::RunTests(kTests);
+}
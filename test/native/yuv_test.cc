@@ -0,0 +1,555 @@
+// Checks the 4:2:0 conversion kernels and the ROI staging built on them
+// against per-pixel scalar conversion, for NV21, NV12 and planar chroma.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cpu_features.h"
+#include "image_warp.h"
+#include "roi_staging.h"
+#include "test_util.h"
+#include "yuv_convert.h"
+#include "yuv_simd.h"
+
+namespace {
+
+using mp_test::ExpectNear;
+using mp_test::KernelIsas;
+using mp_test::WarpCase;
+using mp_test::WarpCases;
+using mp_test::YuvImage;
+
+struct Layout {
+  const char* name;
+  int pixel_stride;
+  bool v_first;
+};
+
+constexpr Layout kLayouts[] = {
+    {"nv21", 2, true},
+    {"nv12", 2, false},
+    {"i420", 1, false},
+};
+
+uint8_t Luma(const mp::YuvSource& source, int x, int y) {
+  return source.y[static_cast<size_t>(y) * source.y_bytes_per_row + x];
+}
+
+size_t ChromaOffset(const mp::YuvSource& source, int cx, int cy) {
+  return static_cast<size_t>(cy) * source.uv_bytes_per_row +
+         static_cast<size_t>(cx) * source.uv_pixel_stride;
+}
+
+// Exact comparison of two byte images; reports the first differing pixel.
+void ExpectSameBytes(const std::string& what,
+                     const uint8_t* actual,
+                     const uint8_t* expected,
+                     int width,
+                     int height,
+                     int bytes_per_row) {
+  for (int y = 0; y < height; ++y) {
+    for (int i = 0; i < width * 4; ++i) {
+      const size_t at = static_cast<size_t>(y) * bytes_per_row + i;
+      if (actual[at] != expected[at]) {
+        std::printf("%s: pixel (%d, %d) channel %d is %d, expected %d\n",
+                    what.c_str(), i / 4, y, i % 4, actual[at], expected[at]);
+        ++mp_test::FailureCount();
+        return;
+      }
+    }
+  }
+}
+
+void Nv21RowMatchesScalar() {
+  const std::vector<uint8_t> luma = mp_test::RandomBytes(80, 1);
+  const std::vector<uint8_t> vu = mp_test::RandomBytes(80, 2);
+  for (mp::KernelIsa isa : KernelIsas()) {
+    for (int count = 1; count <= 72; ++count) {
+      std::vector<uint8_t> out(static_cast<size_t>(count) * 4);
+      std::vector<uint8_t> expected(out.size());
+      mp::Nv21RowToRgba(luma.data(), vu.data(), count, out.data(), isa);
+      for (int x = 0; x < count; ++x) {
+        const uint8_t* chroma = vu.data() + (x & ~1);
+        mp::YuvToRgb(luma[x], chroma[1], chroma[0], &expected[x * 4]);
+        expected[x * 4 + 3] = 255;
+      }
+      ExpectSameBytes(std::string("nv21 row/") + mp::KernelIsaName(isa) +
+                          "/" + std::to_string(count),
+                      out.data(), expected.data(), count, 1, count * 4);
+    }
+  }
+}
+
+#if defined(MP_SIMD_SSE2) || defined(MP_SIMD_NEON)
+// Converts luma 0..255 with fixed chroma through the 4-lane YuvToRgb the
+// YUV warps use.
+void VectorYuvToRgb4(int u, int v, uint8_t* out) {
+  for (int y = 0; y < 256; y += 4) {
+    alignas(16) float rgb[3][4];
+#if defined(MP_SIMD_SSE2)
+    __m128 r, g, b;
+    mp::simd_internal::YuvToRgb4(_mm_setr_epi32(y, y + 1, y + 2, y + 3),
+                                 _mm_set1_epi32(u), _mm_set1_epi32(v), &r,
+                                 &g, &b);
+    _mm_store_ps(rgb[0], r);
+    _mm_store_ps(rgb[1], g);
+    _mm_store_ps(rgb[2], b);
+#else
+    const int32_t lanes[4] = {y, y + 1, y + 2, y + 3};
+    float32x4_t r, g, b;
+    mp::simd_internal::YuvToRgb4(vld1q_s32(lanes), vdupq_n_s32(u),
+                                 vdupq_n_s32(v), &r, &g, &b);
+    vst1q_f32(rgb[0], r);
+    vst1q_f32(rgb[1], g);
+    vst1q_f32(rgb[2], b);
+#endif
+    for (int k = 0; k < 4; ++k) {
+      for (int c = 0; c < 3; ++c) {
+        out[(y + k) * 4 + c] = static_cast<uint8_t>(rgb[c][k]);
+      }
+      out[(y + k) * 4 + 3] = 255;
+    }
+  }
+}
+#endif
+
+#if defined(MP_SIMD_AVX2)
+// VectorYuvToRgb4 for the 8-lane AVX2 form.
+MP_TARGET_AVX2 void VectorYuvToRgb8(int u, int v, uint8_t* out) {
+  for (int y = 0; y < 256; y += 8) {
+    alignas(32) float rgb[3][8];
+    __m256 r, g, b;
+    mp::simd_internal::YuvToRgb8(
+        _mm256_setr_epi32(y, y + 1, y + 2, y + 3, y + 4, y + 5, y + 6, y + 7),
+        _mm256_set1_epi32(u), _mm256_set1_epi32(v), &r, &g, &b);
+    _mm256_store_ps(rgb[0], r);
+    _mm256_store_ps(rgb[1], g);
+    _mm256_store_ps(rgb[2], b);
+    for (int k = 0; k < 8; ++k) {
+      for (int c = 0; c < 3; ++c) {
+        out[(y + k) * 4 + c] = static_cast<uint8_t>(rgb[c][k]);
+      }
+      out[(y + k) * 4 + 3] = 255;
+    }
+  }
+}
+#endif
+
+// Every Y/U/V combination through each vector conversion: the NV21 row
+// kernels and the YuvToRgb lanes behind the YUV warps.
+void ConversionMatchesScalarForAllInputs() {
+  constexpr int kCount = 256;
+  std::vector<uint8_t> luma(kCount);
+  std::vector<uint8_t> vu(kCount);
+  std::vector<uint8_t> expected(kCount * 4);
+  std::vector<uint8_t> out(kCount * 4);
+  for (int y = 0; y < kCount; ++y) {
+    luma[y] = static_cast<uint8_t>(y);
+  }
+  const auto check = [&](const char* what, int u, int v) {
+    if (std::memcmp(out.data(), expected.data(), out.size()) == 0) {
+      return true;
+    }
+    ExpectSameBytes(std::string(what) + " u=" + std::to_string(u) +
+                        " v=" + std::to_string(v),
+                    out.data(), expected.data(), kCount, 1, kCount * 4);
+    return false;
+  };
+  for (int u = 0; u < 256; ++u) {
+    for (int v = 0; v < 256; ++v) {
+      for (int x = 0; x < kCount; x += 2) {
+        vu[x] = static_cast<uint8_t>(v);
+        vu[x + 1] = static_cast<uint8_t>(u);
+      }
+      for (int y = 0; y < kCount; ++y) {
+        mp::YuvToRgb(y, u, v, &expected[y * 4]);
+        expected[y * 4 + 3] = 255;
+      }
+      for (mp::KernelIsa isa : KernelIsas()) {
+        mp::Nv21RowToRgba(luma.data(), vu.data(), kCount, out.data(), isa);
+        if (!check(mp::KernelIsaName(isa), u, v)) {
+          return;
+        }
+      }
+#if defined(MP_SIMD_SSE2) || defined(MP_SIMD_NEON)
+      VectorYuvToRgb4(u, v, out.data());
+      if (!check("YuvToRgb4", u, v)) {
+        return;
+      }
+#endif
+#if defined(MP_SIMD_AVX2)
+      if (mp::CpuSupportsAvx2()) {
+        VectorYuvToRgb8(u, v, out.data());
+        if (!check("YuvToRgb8", u, v)) {
+          return;
+        }
+      }
+#endif
+    }
+  }
+}
+
+void PackVuRowMatchesScalar() {
+  for (const Layout& layout : kLayouts) {
+    const YuvImage image(161, 9, layout.pixel_stride, layout.v_first, 3);
+    const mp::YuvSource& source = image.source;
+    const int chroma_width = (source.width + 1) / 2;
+    for (mp::KernelIsa isa : KernelIsas()) {
+      for (int column = 0; column < chroma_width; column += 3) {
+        for (int row = 0; row < (source.height + 1) / 2; ++row) {
+          const int count = chroma_width - column;
+          std::vector<uint8_t> out(static_cast<size_t>(count) * 2);
+          mp::PackVuRow(source, row, column, count, out.data(), isa);
+          for (int i = 0; i < count; ++i) {
+            const size_t at = ChromaOffset(source, column + i, row);
+            if (out[i * 2] != source.v[at] ||
+                out[i * 2 + 1] != source.u[at]) {
+              std::printf("%s/%s: pair %d of row %d from column %d differs\n",
+                          layout.name, mp::KernelIsaName(isa), i, row,
+                          column);
+              ++mp_test::FailureCount();
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// Region conversion without downsampling reproduces YuvToRgb per pixel.
+void ConvertRegionMatchesScalar() {
+  struct Region {
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+  const Region regions[] = {
+      {0, 0, 45, 31}, {2, 4, 43, 27}, {10, 6, 1, 1}, {44, 30, 1, 1},
+      {18, 0, 17, 31},
+  };
+  for (const Layout& layout : kLayouts) {
+    const YuvImage image(45, 31, layout.pixel_stride, layout.v_first, 4);
+    const mp::YuvSource& source = image.source;
+    for (const Region& region : regions) {
+      const int bytes_per_row = region.width * 4;
+      std::vector<uint8_t> expected(static_cast<size_t>(bytes_per_row) *
+                                    region.height);
+      for (int y = 0; y < region.height; ++y) {
+        for (int x = 0; x < region.width; ++x) {
+          const int sx = region.x + x;
+          const int sy = region.y + y;
+          const size_t chroma = ChromaOffset(source, sx / 2, sy / 2);
+          uint8_t* pixel =
+              &expected[static_cast<size_t>(y) * bytes_per_row + x * 4];
+          mp::YuvToRgb(Luma(source, sx, sy), source.u[chroma],
+                       source.v[chroma], pixel);
+          pixel[3] = 255;
+        }
+      }
+      for (mp::KernelIsa isa : KernelIsas()) {
+        std::vector<uint8_t> out(expected.size());
+        mp::YuvConvertScratch scratch;
+        mp::ConvertYuvRegion(source, region.x, region.y, region.width,
+                             region.height, 1, out.data(), bytes_per_row,
+                             &scratch, isa);
+        ExpectSameBytes(std::string(layout.name) + "/" +
+                            mp::KernelIsaName(isa) + " region " +
+                            std::to_string(region.x) + "," +
+                            std::to_string(region.y),
+                        out.data(), expected.data(), region.width,
+                        region.height, bytes_per_row);
+      }
+    }
+  }
+}
+
+// Rounded average of a `factor` x `factor` block of samples `at(x, y)`,
+// repeating the last valid row and column.
+template <typename Sample>
+int BoxAverage(Sample at, int x0, int y0, int factor, int width, int height) {
+  int total = 0;
+  for (int y = y0; y < y0 + factor; ++y) {
+    for (int x = x0; x < x0 + factor; ++x) {
+      total += at(std::min(x, width - 1), std::min(y, height - 1));
+    }
+  }
+  const int area = factor * factor;
+  return (total + area / 2) / area;
+}
+
+// Scalar counterpart of ConvertYuvRegion with `factor` > 1: Y and the
+// chroma planes are box-averaged separately, then converted.
+std::vector<uint8_t> ReferenceDownsample(const mp::YuvSource& source,
+                                         int x_begin,
+                                         int y_begin,
+                                         int width,
+                                         int height,
+                                         int factor) {
+  const int out_width = width / factor;
+  const int out_height = height / factor;
+  const int luma_width = std::min(width, source.width - x_begin);
+  const int luma_height = std::min(height, source.height - y_begin);
+  const int chroma_width = (luma_width + 1) / 2;
+  const int chroma_height = (luma_height + 1) / 2;
+  const auto luma = [&](int x, int y) {
+    return Luma(source, x_begin + x, y_begin + y);
+  };
+  const auto u = [&](int x, int y) {
+    return source.u[ChromaOffset(source, x_begin / 2 + x, y_begin / 2 + y)];
+  };
+  const auto v = [&](int x, int y) {
+    return source.v[ChromaOffset(source, x_begin / 2 + x, y_begin / 2 + y)];
+  };
+  std::vector<uint8_t> out(static_cast<size_t>(out_width) * out_height * 4);
+  for (int y = 0; y < out_height; ++y) {
+    for (int x = 0; x < out_width; ++x) {
+      const int cx = (x / 2) * factor;
+      const int cy = (y / 2) * factor;
+      uint8_t* pixel = &out[(static_cast<size_t>(y) * out_width + x) * 4];
+      mp::YuvToRgb(
+          BoxAverage(luma, x * factor, y * factor, factor, luma_width,
+                     luma_height),
+          BoxAverage(u, cx, cy, factor, chroma_width, chroma_height),
+          BoxAverage(v, cx, cy, factor, chroma_width, chroma_height), pixel);
+      pixel[3] = 255;
+    }
+  }
+  return out;
+}
+
+void DownsampledRegionMatchesScalar() {
+  struct Region {
+    int x;
+    int y;
+    int width;
+    int height;
+    int factor;
+  };
+  const Region regions[] = {
+      {0, 0, 96, 64, 2},  {4, 2, 64, 48, 4},   {0, 0, 96, 64, 8},
+      {2, 0, 64, 64, 16}, {24, 14, 72, 48, 4},
+      // Regions running more than one block past the right/bottom edge.
+      {64, 32, 48, 48, 8}, {90, 60, 32, 32, 16},
+  };
+  for (const Layout& layout : kLayouts) {
+    const YuvImage image(99, 67, layout.pixel_stride, layout.v_first, 5);
+    const mp::YuvSource& source = image.source;
+    for (const Region& region : regions) {
+      const int out_width = region.width / region.factor;
+      const int out_height = region.height / region.factor;
+      const std::vector<uint8_t> expected =
+          ReferenceDownsample(source, region.x, region.y, region.width,
+                              region.height, region.factor);
+      for (mp::KernelIsa isa : KernelIsas()) {
+        std::vector<uint8_t> out(expected.size());
+        mp::YuvConvertScratch scratch;
+        mp::ConvertYuvRegion(source, region.x, region.y, region.width,
+                             region.height, region.factor, out.data(),
+                             out_width * 4, &scratch, isa);
+        ExpectSameBytes(std::string(layout.name) + "/" +
+                            mp::KernelIsaName(isa) + " factor " +
+                            std::to_string(region.factor) + " at " +
+                            std::to_string(region.x) + "," +
+                            std::to_string(region.y),
+                        out.data(), expected.data(), out_width, out_height,
+                        out_width * 4);
+      }
+    }
+  }
+}
+
+// Without downsampling the staged crop matches warping the YUV source
+// directly.
+void StagedWarpMatchesReference() {
+  uint32_t seed = 200;
+  for (const WarpCase& test : WarpCases()) {
+    const mp::WarpTransform m = test.Transform();
+    if (mp::WarpScale(m) >= mp::ReductionScale(mp::Interpolation::kArea)) {
+      continue;
+    }
+    for (const Layout& layout : kLayouts) {
+      const YuvImage image(test.source_width, test.source_height,
+                           layout.pixel_stride, layout.v_first, seed++);
+      const size_t count =
+          static_cast<size_t>(test.target_width) * test.target_height * 3;
+      std::vector<float> expected(count);
+      mp_test::ReferenceBilinear(image.source, m, test.target_width,
+                                 test.target_height, expected.data());
+      for (mp::KernelIsa isa : KernelIsas()) {
+        mp::YuvRoiStager stager;
+        if (!stager.Stage(image.source, m, test.target_width,
+                          test.target_height,
+                          mp::ReductionScale(mp::Interpolation::kArea),
+                          isa)) {
+          continue;
+        }
+        std::vector<float> out(count);
+        mp::WarpBilinear(stager.staged(), stager.transform(), out.data(),
+                         test.target_width, 0, test.target_height, isa);
+        ExpectNear((std::string(test.name) + "/" + layout.name + "/staged/" +
+                    mp::KernelIsaName(isa))
+                       .c_str(),
+                   out.data(), expected.data(), count, 2e-3f);
+      }
+    }
+  }
+}
+
+// Rewrites `image` to hold the same pixels as `from`, keeping its layout.
+void CopySamples(const mp::YuvSource& from, YuvImage* image) {
+  const mp::YuvSource& to = image->source;
+  for (int y = 0; y < from.height; ++y) {
+    for (int x = 0; x < from.width; ++x) {
+      image->luma[static_cast<size_t>(y) * to.y_bytes_per_row + x] =
+          Luma(from, x, y);
+    }
+  }
+  // The chroma pointers alias the image's own vectors.
+  uint8_t* u = const_cast<uint8_t*>(to.u);
+  uint8_t* v = const_cast<uint8_t*>(to.v);
+  for (int cy = 0; cy < (from.height + 1) / 2; ++cy) {
+    for (int cx = 0; cx < (from.width + 1) / 2; ++cx) {
+      u[ChromaOffset(to, cx, cy)] = from.u[ChromaOffset(from, cx, cy)];
+      v[ChromaOffset(to, cx, cy)] = from.v[ChromaOffset(from, cx, cy)];
+    }
+  }
+}
+
+// NV12 and I420 frames holding the same pixels as an NV21 frame produce
+// exactly the NV21 output, both warped directly and staged.
+void LayoutsMatchNv21() {
+  uint32_t seed = 400;
+  for (const WarpCase& test : WarpCases()) {
+    const mp::WarpTransform m = test.Transform();
+    const YuvImage nv21(test.source_width, test.source_height, 2, true,
+                        seed++);
+    const size_t count =
+        static_cast<size_t>(test.target_width) * test.target_height * 3;
+    const auto warp = [&](const mp::YuvSource& source, mp::KernelIsa isa,
+                          bool staged) {
+      std::vector<float> out(count);
+      mp::YuvRoiStager stager;
+      if (staged &&
+          stager.Stage(source, m, test.target_width, test.target_height,
+                       mp::ReductionScale(mp::Interpolation::kArea), isa)) {
+        mp::WarpBilinear(stager.staged(), stager.transform(), out.data(),
+                         test.target_width, 0, test.target_height, isa);
+      } else {
+        mp::WarpBilinear(source, m, out.data(), test.target_width, 0,
+                         test.target_height, isa);
+      }
+      return out;
+    };
+    for (const Layout& layout : kLayouts) {
+      YuvImage image(test.source_width, test.source_height,
+                     layout.pixel_stride, layout.v_first, seed++);
+      CopySamples(nv21.source, &image);
+      for (mp::KernelIsa isa : KernelIsas()) {
+        for (bool staged : {false, true}) {
+          const std::vector<float> expected = warp(nv21.source, isa, staged);
+          const std::vector<float> out = warp(image.source, isa, staged);
+          ExpectNear((std::string(test.name) + "/" + layout.name +
+                      (staged ? "/staged/" : "/direct/") +
+                      mp::KernelIsaName(isa))
+                         .c_str(),
+                     out.data(), expected.data(), count, 0.0f);
+        }
+      }
+    }
+  }
+}
+
+// Drops (sets to NaN) the expected values of pixels that sample within
+// `margin` raw pixels of a frame edge, where box-filtered staging and direct
+// sampling legitimately differ.
+void MaskFrameEdges(const mp::WarpTransform& m,
+                    int width,
+                    int height,
+                    int frame_width,
+                    int frame_height,
+                    float margin,
+                    float* expected) {
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const float sx = m.xx * static_cast<float>(x) +
+                       m.xy * static_cast<float>(y) + m.xt;
+      const float sy = m.yx * static_cast<float>(x) +
+                       m.yy * static_cast<float>(y) + m.yt;
+      const auto near_edge = [&](float position, int size) {
+        return std::fabs(position) < margin ||
+               std::fabs(position - static_cast<float>(size - 1)) < margin;
+      };
+      if (near_edge(sx, frame_width) || near_edge(sy, frame_height)) {
+        mp_test::FillNan(expected + (static_cast<size_t>(y) * width + x) * 3);
+      }
+    }
+  }
+}
+
+// A downsampled ROI larger than a frame whose size is not a multiple of the
+// staged block: the blocks padded past the frame must sample as black, not
+// as repeated edge pixels. The frame is a smooth luma ramp so box filtering
+// and direct sampling agree away from the edges.
+void StagedAreaCropBlacksOutsideFrame() {
+  const int width = 994;
+  const int height = 600;
+  const int target = 192;
+  for (const Layout& layout : kLayouts) {
+    YuvImage image(width, height, layout.pixel_stride, layout.v_first, 300);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        image.luma[static_cast<size_t>(y) * image.source.y_bytes_per_row + x] =
+            static_cast<uint8_t>(16 + (x + y) / 8);
+      }
+    }
+    std::fill(image.chroma.begin(), image.chroma.end(), 128);
+    std::fill(image.chroma2.begin(), image.chroma2.end(), 128);
+
+    const mp::RectInPixels roi = {497.0f, 300.0f, 1600.0f, 1600.0f, 0.0f};
+    const mp::WarpTransform m =
+        mp::MakeWarpTransform(roi, target, target, 0, false, width, height);
+    mp::YuvRoiStager stager;
+    const bool staged =
+        stager.Stage(image.source, m, target, target,
+                     mp::ReductionScale(mp::Interpolation::kArea));
+    MP_EXPECT(staged);
+    if (!staged) {
+      continue;
+    }
+    MP_EXPECT(stager.staged().width == 125 && stager.staged().height == 75);
+    const size_t count = static_cast<size_t>(target) * target * 3;
+    std::vector<float> out(count);
+    std::vector<float> expected(count);
+    mp::WarpBilinear(stager.staged(), stager.transform(), out.data(), target,
+                     0, target);
+    mp_test::ReferenceBilinear(image.source, m, target, target,
+                               expected.data());
+    MaskFrameEdges(m, target, target, width, height, 8.0f, expected.data());
+    ExpectNear((std::string("area crop/") + layout.name).c_str(), out.data(),
+               expected.data(), count, 2.0f / 127.5f);
+  }
+}
+
+}  // namespace
+
+int main() {
+  static const mp_test::TestCase kTests[] = {
+      {"Nv21RowMatchesScalar", Nv21RowMatchesScalar},
+      {"ConversionMatchesScalarForAllInputs",
+       ConversionMatchesScalarForAllInputs},
+      {"PackVuRowMatchesScalar", PackVuRowMatchesScalar},
+      {"ConvertRegionMatchesScalar", ConvertRegionMatchesScalar},
+      {"DownsampledRegionMatchesScalar", DownsampledRegionMatchesScalar},
+      {"StagedWarpMatchesReference", StagedWarpMatchesReference},
+      {"LayoutsMatchNv21", LayoutsMatchNv21},
+      {"StagedAreaCropBlacksOutsideFrame", StagedAreaCropBlacksOutsideFrame},
+  };
+  return mp_test::RunTests(kTests);
+}